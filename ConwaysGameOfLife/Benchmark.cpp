@@ -0,0 +1,415 @@
+#include "Benchmark.h"
+#include "EngineFactory.h"
+#include "HashLife.h"
+#include "LifeEngine.h"
+#include "PatternIO.h"
+#include "SparseUniverse.h"
+#include "ThreadPool.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+struct CorpusPattern
+{
+	int width;
+	int height;
+	const char* rle;
+};
+
+static const CorpusPattern GosperGun = { 36, 9,
+	"24bo$22bobo$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o$2o8bo3bob2o4bobo$10bo5bo7bo$11bo3bo$12b2o!" };
+static const CorpusPattern Acorn = { 7, 3, "bo$3bo$2o2b3o!" };
+
+//Linux can set the peak back to what the process holds right now, so every run gets a peak of its own.
+//Elsewhere the peak covers the whole process so far.
+static bool ResetPeakRss()
+{
+#if defined(__linux__)
+	std::ofstream clearRefs{ "/proc/self/clear_refs" };
+	clearRefs << "5";
+	clearRefs.flush();
+	return bool(clearRefs);
+#else
+	return false;
+#endif
+}
+
+static uint64_t GetPeakRss()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return uint64_t(counters.PeakWorkingSetSize);
+#else
+#if defined(__linux__)
+	//ru_maxrss does not see the reset, the high water mark in the status file does
+	std::ifstream status{ "/proc/self/status" };
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (line.compare(0, 6, "VmHWM:") == 0)
+			return std::stoull(line.substr(6)) * 1024;
+	}
+#endif
+	struct rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#if defined(__APPLE__)
+	return uint64_t(usage.ru_maxrss);
+#else
+	//Linux reports kilobytes
+	return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+//Every cell is alive when all of its bits in 'andCount' random words are, a chance of 1 / 2^andCount
+static void FillRandom(Grid& grid, int andCount, uint64_t seed)
+{
+	std::mt19937_64 random{ seed };
+	uint64_t lastWordMask = grid.GetLastWordMask();
+	int wordsPerRow = grid.GetWordsPerRow();
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		uint64_t* pRow = grid.GetRow(y);
+		for (int w{ 0 }; w < wordsPerRow; w++)
+		{
+			uint64_t word = ~uint64_t(0);
+			for (int i{ 0 }; i < andCount; i++)
+				word &= random();
+			pRow[w] = word;
+		}
+		pRow[wordsPerRow - 1] &= lastWordMask;
+	}
+	grid.MarkEdited();
+}
+
+static void AddCounters(BenchmarkResult& result, const GenerationCounters& counters)
+{
+	result.allocations += counters.allocations;
+	result.bytesAllocated += counters.bytesAllocated;
+	result.bytesCopied += counters.bytesCopied;
+}
+
+static void FillCentered(Grid& grid, const CorpusPattern& pattern)
+{
+	std::istringstream stream{ pattern.rle };
+	GridPatternSink sink{ grid, (grid.GetWidth() - pattern.width) / 2, (grid.GetHeight() - pattern.height) / 2 };
+	PatternReader::ReadRle(stream, sink);
+}
+
+//Blocks on a 3 cell lattice: 4 of every 9 cells alive and nothing ever changes
+static void FillBlocks(Grid& grid)
+{
+	for (int y{ 0 }; y + 1 < grid.GetHeight(); y += 3)
+	{
+		for (int x{ 0 }; x + 1 < grid.GetWidth(); x += 3)
+		{
+			grid.SetCell(x, y, true);
+			grid.SetCell(x + 1, y, true);
+			grid.SetCell(x, y + 1, true);
+			grid.SetCell(x + 1, y + 1, true);
+		}
+	}
+}
+
+//The unbounded universes do not step a Grid, they are named on their own next to the engines of EngineFactory
+static bool IsUniverse(const std::string& engine)
+{
+	return engine == "hashlife" || engine == "sparse";
+}
+
+//Steps one untimed generation, then times generations until the limits of the options are reached
+template <typename StepFunction>
+static void TimeGenerations(const BenchmarkOptions& options, BenchmarkResult& result, StepFunction step)
+{
+	//The first generation allocates the buffers and touches every page: its allocations count, its time does not
+	step();
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start = Clock::now();
+	double seconds = 0.0;
+	uint64_t timedGenerations = 0;
+	while (true)
+	{
+		if (options.generations != 0 ? timedGenerations + 1 >= options.generations
+			: timedGenerations + 1 >= options.maxGenerations || (timedGenerations > 0 && seconds >= options.minSeconds))
+			break;
+
+		step();
+		++timedGenerations;
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	double cellUpdates = double(result.size) * result.size * timedGenerations;
+	result.generations = timedGenerations + 1;
+	result.seconds = seconds;
+	result.nsPerCell = cellUpdates > 0.0 ? seconds * 1e9 / cellUpdates : 0.0;
+	result.cellsPerSecond = seconds > 0.0 ? cellUpdates / seconds : 0.0;
+}
+
+Benchmark::Benchmark(const BenchmarkOptions& options)
+	: m_Options(options)
+{
+}
+
+std::vector<BenchmarkResult> Benchmark::Run()
+{
+	std::vector<std::string> engines = m_Options.engines;
+	if (engines.empty())
+	{
+		engines = EngineFactory::GetEngineNames();
+		engines.push_back("hashlife");
+		engines.push_back("sparse");
+	}
+	std::vector<std::string> patterns = m_Options.patterns.empty() ? GetPatternNames() : m_Options.patterns;
+
+	//Fail before spending minutes on the first engines
+	std::vector<std::string> corpus = GetPatternNames();
+	for (const std::string& pattern : patterns)
+	{
+		if (std::find(corpus.begin(), corpus.end(), pattern) == corpus.end())
+			throw std::runtime_error{ "Unknown pattern " + pattern };
+	}
+
+	std::vector<BenchmarkResult> results;
+	std::set<std::string> measured;
+	for (const std::string& engine : engines)
+	{
+		//"bitwise" and the instruction sets the CPU lacks end up as one of the other bitwise engines
+		std::string name = engine;
+		if (!IsUniverse(engine))
+			name = std::unique_ptr<LifeEngine>{ EngineFactory::Create(engine) }->GetName();
+		if (!measured.insert(name).second)
+			continue;
+
+		for (const std::string& pattern : patterns)
+		{
+			for (int size : m_Options.sizes)
+			{
+				results.push_back(RunOne(engine, pattern, size));
+
+				const BenchmarkResult& result = results.back();
+				std::cerr << result.engine << " " << result.pattern << " " << result.size << "x" << result.size << ": "
+					<< std::fixed << std::setprecision(3) << result.nsPerCell << " ns/cell" << std::endl;
+				std::cerr.unsetf(std::ios_base::floatfield);
+			}
+		}
+	}
+
+	return results;
+}
+
+BenchmarkResult Benchmark::RunOne(const std::string& engine, const std::string& pattern, int size) const
+{
+	//Before anything of the run is allocated, the peak should only see this run on top of what the process already holds
+	bool peakRssReset = ResetPeakRss();
+
+	Grid grid{ size, size, 1 };
+	FillPattern(grid, pattern, m_Options.seed);
+
+	BenchmarkResult result{};
+	result.engine = engine;
+	result.pattern = pattern;
+	result.size = size;
+
+	//The unbounded universes step single threaded and without a border, what leaves the board is gone from the hash.
+	//They keep their cells outside of a Grid, so they have no GenerationCounters to add up.
+	if (engine == "hashlife")
+	{
+		HashLife hashLife{};
+		hashLife.SetRule(Rule::Conway());
+		hashLife.LoadGrid(grid);
+		TimeGenerations(m_Options, result, [&hashLife]() { hashLife.Advance(0); });
+		grid.ClearGrid();
+		hashLife.WriteToGrid(grid);
+	}
+	else if (engine == "sparse")
+	{
+		SparseUniverse universe{};
+		universe.SetRule(Rule::Conway());
+		universe.LoadGrid(grid);
+		TimeGenerations(m_Options, result, [&universe]() { universe.Step(); });
+		grid.ClearGrid();
+		universe.WriteToGrid(grid);
+	}
+	else
+	{
+		//Every engine runs Conway's Life, Larger than Life writes it in its own notation
+		std::string rule = engine == "larger-than-life" ? "R1,C0,M0,S2..3,B3..3,NM" : "B3/S23";
+		std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(engine, rule) };
+		std::unique_ptr<ThreadPool> pThreadPool{ m_Options.threadCount != 1 ? new ThreadPool{ m_Options.threadCount } : nullptr };
+		pEngine->SetThreadPool(pThreadPool.get());
+		result.engine = pEngine->GetName();
+
+		TimeGenerations(m_Options, result, [&]()
+			{
+				pEngine->Step(grid);
+				AddCounters(result, grid.GetGenerationCounters());
+			}
+		);
+	}
+
+	result.peakRssBytes = GetPeakRss();
+	result.peakRssOfRun = peakRssReset;
+	result.population = grid.GetPopulation();
+	result.hash = grid.ComputeHash();
+	return result;
+}
+
+std::vector<std::string> Benchmark::GetPatternNames()
+{
+	return { "soup", "gun", "acorn", "sparse", "still-life" };
+}
+
+void Benchmark::FillPattern(Grid& grid, const std::string& pattern, uint64_t seed)
+{
+	grid.ClearGrid();
+	if (pattern == "soup")
+		FillRandom(grid, 1, seed);
+	else if (pattern == "sparse")
+		FillRandom(grid, 5, seed);
+	else if (pattern == "gun")
+		FillCentered(grid, GosperGun);
+	else if (pattern == "acorn")
+		FillCentered(grid, Acorn);
+	else if (pattern == "still-life")
+		FillBlocks(grid);
+	else
+		throw std::runtime_error{ "Unknown pattern " + pattern };
+}
+
+BenchmarkOptions Benchmark::ParseArguments(int argc, char** argv)
+{
+	BenchmarkOptions options{};
+
+	//Comma separated lists
+	auto Split = [](const std::string& value)
+	{
+		std::vector<std::string> items;
+		std::istringstream stream{ value };
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			if (!item.empty())
+				items.push_back(item);
+		}
+		return items;
+	};
+
+	for (int i{ 1 }; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error{ "Missing value for " + argument };
+
+		std::string value = argv[++i];
+		try
+		{
+			if (argument == "--engines")
+				options.engines = Split(value);
+			else if (argument == "--patterns")
+				options.patterns = Split(value);
+			else if (argument == "--sizes")
+			{
+				options.sizes.clear();
+				for (const std::string& size : Split(value))
+					options.sizes.push_back(std::stoi(size));
+			}
+			else if (argument == "--min-time")
+				options.minSeconds = std::stod(value);
+			else if (argument == "--max-generations")
+				options.maxGenerations = std::stoull(value);
+			else if (argument == "--generations")
+				options.generations = std::stoull(value);
+			else if (argument == "--threads")
+				options.threadCount = std::stoi(value);
+			else if (argument == "--seed")
+				options.seed = std::stoull(value);
+			else if (argument == "--output")
+				options.outputPath = value;
+			else
+				throw std::runtime_error{ "Unknown argument " + argument };
+		}
+		catch (const std::logic_error&)
+		{
+			throw std::runtime_error{ "Invalid value \"" + value + "\" for " + argument };
+		}
+	}
+
+	for (int size : options.sizes)
+	{
+		if (size <= 0)
+			throw std::runtime_error{ "Invalid board size " + std::to_string(size) };
+	}
+
+	return options;
+}
+
+void Benchmark::PrintUsage(std::ostream& stream)
+{
+	stream << "Usage: LifeBenchmark [options]\n"
+		<< "  --engines A,B,...    engines to run, hashlife and sparse included (default all of them)\n"
+		<< "  --patterns A,B,...   soup, gun, acorn, sparse, still-life (default all of them)\n"
+		<< "  --sizes N,M,...      square board sizes (default 256,1024,4096)\n"
+		<< "  --min-time S         step every run for at least this many seconds (default 0.5)\n"
+		<< "  --max-generations N  but stop a run after this many generations (default 1000)\n"
+		<< "  --generations N      run exactly this many generations instead (default off)\n"
+		<< "  --threads N          simulation threads, 0 = all cores (default 1)\n"
+		<< "  --seed N             seed of the soup and sparse patterns (default 1)\n"
+		<< "  --output FILE        write the JSON to a file instead of stdout\n";
+}
+
+void Benchmark::WriteJson(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results, std::ostream& stream)
+{
+	//Names come from fixed lists, so nothing has to be escaped
+	stream << "{\n"
+		<< "  \"threads\": " << options.threadCount << ",\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"results\": [";
+
+	for (size_t i{ 0 }; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		stream << (i == 0 ? "\n" : ",\n")
+			<< "    {\"engine\": \"" << result.engine << "\""
+			<< ", \"pattern\": \"" << result.pattern << "\""
+			<< ", \"size\": " << result.size
+			<< ", \"generations\": " << result.generations
+			<< std::setprecision(9)
+			<< ", \"seconds\": " << result.seconds
+			<< ", \"nsPerCell\": " << result.nsPerCell
+			<< ", \"cellsPerSecond\": " << result.cellsPerSecond
+			<< ", \"allocations\": " << result.allocations
+			<< ", \"bytesAllocated\": " << result.bytesAllocated
+			<< ", \"bytesCopied\": " << result.bytesCopied
+			<< ", \"peakRssBytes\": " << result.peakRssBytes
+			<< ", \"peakRssScope\": \"" << (result.peakRssOfRun ? "run" : "process") << "\""
+			<< ", \"population\": " << result.population
+			<< ", \"hash\": \"" << std::hex << std::setw(16) << std::setfill('0') << result.hash << std::dec << std::setfill(' ') << "\"}";
+	}
+
+	stream << "\n  ]\n}\n";
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+class Grid;
+
+struct BenchmarkOptions
+{
+	std::vector<std::string> engines;	//Names from EngineFactory, hashlife or sparse, empty runs every engine
+	std::vector<std::string> patterns;	//Names from Benchmark::GetPatternNames, empty runs the whole corpus
+	std::vector<int> sizes = { 256, 1024, 4096 };	//Square boards
+	double minSeconds = 0.5;		//Every run steps at least this long...
+	uint64_t maxGenerations = 1000;	//...unless it reaches this many generations first
+	uint64_t generations = 0;		//A fixed number of generations for every run instead, 0 uses the time limits above
+	int threadCount = 1;			//0 uses every hardware thread
+	uint64_t seed = 1;
+	std::string outputPath;			//JSON goes to stdout when empty
+};
+
+struct BenchmarkResult
+{
+	std::string engine;
+	std::string pattern;
+	int size = 0;
+	uint64_t generations = 0;
+	double seconds = 0.0;
+	double nsPerCell = 0.0;
+	double cellsPerSecond = 0.0;
+	uint64_t allocations = 0;		//Summed GenerationCounters of all measured generations
+	uint64_t bytesAllocated = 0;
+	uint64_t bytesCopied = 0;
+	uint64_t peakRssBytes = 0;		//Peak resident set size while this run stepped, including what the process held before it...
+	bool peakRssOfRun = false;		//...or of the whole process so far where the peak can not be reset (anything but Linux)
+	uint64_t population = 0;
+	uint64_t hash = 0;
+};
+
+//Runs every engine over a fixed corpus of starting patterns and board sizes and reports the cost per cell update.
+//The corpus covers the cases the engines are tuned for differently: chaos everywhere, mostly empty space
+//around a small active region, and a board full of cells that never change.
+//The output is JSON so results of different versions can be compared by scripts.
+class Benchmark final
+{
+public:
+	Benchmark(const BenchmarkOptions& options);
+	~Benchmark() = default;
+	Benchmark(const Benchmark& other) = delete;
+	Benchmark(Benchmark&& other) = delete;
+	Benchmark& operator=(const Benchmark& other) = delete;
+	Benchmark& operator=(Benchmark&& other) = delete;
+
+	//Throws std::runtime_error for unknown engines or patterns
+	std::vector<BenchmarkResult> Run();
+
+	//soup, gun, acorn, sparse and still-life
+	static std::vector<std::string> GetPatternNames();
+	//Throws std::runtime_error for an unknown pattern
+	static void FillPattern(Grid& grid, const std::string& pattern, uint64_t seed);
+
+	//Throws std::runtime_error on unknown or malformed arguments
+	static BenchmarkOptions ParseArguments(int argc, char** argv);
+	static void PrintUsage(std::ostream& stream);
+	static void WriteJson(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results, std::ostream& stream);
+
+private:
+	BenchmarkOptions m_Options;
+
+	BenchmarkResult RunOne(const std::string& engine, const std::string& pattern, int size) const;
+};
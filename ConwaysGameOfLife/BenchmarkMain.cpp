@@ -0,0 +1,47 @@
+#include "Benchmark.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+//Entry point of the kernel benchmark, built by CMake on any platform.
+//The Visual Studio project keeps using Main.cpp, so this file is not part of it.
+int main(int argc, char** argv)
+{
+	for (int i{ 1 }; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h")
+		{
+			Benchmark::PrintUsage(std::cout);
+			return 0;
+		}
+	}
+
+	try
+	{
+		BenchmarkOptions options = Benchmark::ParseArguments(argc, argv);
+		Benchmark benchmark{ options };
+		std::vector<BenchmarkResult> results = benchmark.Run();
+
+		if (options.outputPath.empty())
+		{
+			Benchmark::WriteJson(options, results, std::cout);
+			return 0;
+		}
+
+		std::ofstream file{ options.outputPath };
+		Benchmark::WriteJson(options, results, file);
+		if (!file)
+			throw std::runtime_error{ "Could not write " + options.outputPath };
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		Benchmark::PrintUsage(std::cerr);
+		return 1;
+	}
+
+	return 0;
+}
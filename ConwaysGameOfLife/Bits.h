@@ -0,0 +1,117 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+//Small portable wrappers around the bit scan/count intrinsics used by the packed grid.
+//The MSVC 64 bit intrinsics do not exist on x86, so those builds split the word in two halves.
+
+//Number of set bits in the word
+inline int PopCount64(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	return int(__popcnt64(word));
+#elif defined(_MSC_VER)
+	return int(__popcnt(uint32_t(word)) + __popcnt(uint32_t(word >> 32)));
+#else
+	return __builtin_popcountll(word);
+#endif
+}
+
+//Index of the lowest set bit, the word must not be 0
+inline int CountTrailingZeros64(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return int(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, uint32_t(word)))
+		return int(index);
+	_BitScanForward(&index, uint32_t(word >> 32));
+	return int(index) + 32;
+#else
+	return __builtin_ctzll(word);
+#endif
+}
+
+//Number of zero bits above the highest set bit, the word must not be 0
+inline int CountLeadingZeros64(uint64_t word)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, word);
+	return 63 - int(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanReverse(&index, uint32_t(word >> 32)))
+		return 31 - int(index);
+	_BitScanReverse(&index, uint32_t(word));
+	return 63 - int(index);
+#else
+	return __builtin_clzll(word);
+#endif
+}
+
+//The word with its bits in the opposite order, bit 0 becomes bit 63
+inline uint64_t ReverseBits64(uint64_t word)
+{
+	word = ((word >> 1) & 0x5555555555555555ull) | ((word & 0x5555555555555555ull) << 1);
+	word = ((word >> 2) & 0x3333333333333333ull) | ((word & 0x3333333333333333ull) << 2);
+	word = ((word >> 4) & 0x0F0F0F0F0F0F0F0Full) | ((word & 0x0F0F0F0F0F0F0F0Full) << 4);
+	word = ((word >> 8) & 0x00FF00FF00FF00FFull) | ((word & 0x00FF00FF00FF00FFull) << 8);
+	word = ((word >> 16) & 0x0000FFFF0000FFFFull) | ((word & 0x0000FFFF0000FFFFull) << 16);
+	return (word >> 32) | (word << 32);
+}
+
+//Cell x of the target row is cell width - 1 - x of the source row, what a Klein bottle puts across the top and bottom.
+//Reverses the words, then drops the padding of the last source word that ended up in front. Bits past width stay 0.
+inline void MirrorRow(const uint64_t* pSource, uint64_t* pTarget, int width)
+{
+	int wordsPerRow = (width + 63) / 64;
+	int padding = wordsPerRow * 64 - width;
+	for (int w{ 0 }; w < wordsPerRow; w++)
+		pTarget[w] = ReverseBits64(pSource[wordsPerRow - 1 - w]);
+
+	if (padding != 0)
+	{
+		for (int w{ 0 }; w < wordsPerRow; w++)
+			pTarget[w] = (pTarget[w] >> padding) | (w + 1 < wordsPerRow ? pTarget[w + 1] << (64 - padding) : 0);
+	}
+}
+
+//Finalizer of MurmurHash3, every bit of the value ends up spread over the whole word
+inline uint64_t MixHash(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+//Hash of one word at its index among the words of the grid, empty words hash to 0.
+//CycleDetector xors these over all words, so a word that changed is swapped out of the hash with two xors.
+inline uint64_t HashWordAt(size_t index, uint64_t word)
+{
+	return word == 0 ? 0 : MixHash(word ^ (uint64_t(index + 1) * 0x9e3779b97f4a7c15ull));
+}
+
+//The grid hash of Grid::ComputeHash: start with the size, then chain the words of every row in with HashWords.
+//Anything that hashes packed rows goes through these two, so equal cells give equal hashes in every grid type.
+inline uint64_t BeginGridHash(int width, int height)
+{
+	return MixHash((uint64_t(width) << 32) | uint32_t(height));
+}
+
+inline uint64_t HashWords(uint64_t hash, const uint64_t* pWords, int wordCount)
+{
+	for (int w{ 0 }; w < wordCount; w++)
+		hash = MixHash(hash ^ pWords[w]) + uint64_t(w + 1);
+	return hash;
+}
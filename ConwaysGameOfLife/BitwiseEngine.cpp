@@ -0,0 +1,75 @@
+#include "BitwiseEngine.h"
+#include "CpuFeatures.h"
+#include "Cell.h"
+
+BitwiseEngine::BitwiseEngine(InstructionSet maxInstructionSet)
+	: m_InstructionSet(InstructionSet::Swar)
+	, m_pStepWords(nullptr)
+	, m_pStepWordsSwar(nullptr)
+{
+	//Pick the widest instruction set that is allowed and that this CPU can actually run
+	if (maxInstructionSet == InstructionSet::Avx512 && CpuFeatures::HasAvx512())
+		m_InstructionSet = InstructionSet::Avx512;
+	else if (maxInstructionSet != InstructionSet::Swar && CpuFeatures::HasAvx2())
+		m_InstructionSet = InstructionSet::Avx2;
+
+	SetRule(m_Rule);
+}
+
+void BitwiseEngine::SetRule(const Rule& rule)
+{
+	LifeEngine::SetRule(rule);
+
+	//Look up the kernels for the new rule once, stepping only goes through the function pointers
+	m_pStepWordsSwar = SelectStepWords<SwarOps>(rule);
+	switch (m_InstructionSet)
+	{
+	case InstructionSet::Avx512:
+		m_pStepWords = SelectStepWordsAvx512(rule);
+		break;
+	case InstructionSet::Avx2:
+		m_pStepWords = SelectStepWordsAvx2(rule);
+		break;
+	default:
+		m_pStepWords = m_pStepWordsSwar;
+		break;
+	}
+}
+
+void BitwiseEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	//Read the current generation and write straight into the next one, the rows above and below the grid are its halo
+	for (int y{ firstRow }; y < lastRow; y++)
+		StepRow(grid.GetRow(y - 1), grid.GetRow(y), grid.GetRow(y + 1), grid.GetNextRow(y), wordsPerRow, lastWordMask);
+}
+
+const char* BitwiseEngine::GetName() const
+{
+	switch (m_InstructionSet)
+	{
+	case InstructionSet::Avx512:
+		return "bitwise-avx512";
+	case InstructionSet::Avx2:
+		return "bitwise-avx2";
+	default:
+		return "bitwise-swar";
+	}
+}
+
+InstructionSet BitwiseEngine::GetInstructionSet() const
+{
+	return m_InstructionSet;
+}
+
+void BitwiseEngine::StepRow(const uint64_t* pAbove, const uint64_t* pRow, const uint64_t* pBelow, uint64_t* pOut, int wordsPerRow, uint64_t lastWordMask) const
+{
+	//Let the vector kernel do as much of the row as it can, the SWAR kernel picks up the remainder
+	int word = m_pStepWords(pAbove, pRow, pBelow, pOut, 0, wordsPerRow, m_Rule);
+	m_pStepWordsSwar(pAbove, pRow, pBelow, pOut, word, wordsPerRow, m_Rule);
+
+	//Cells past the width of the grid have to stay dead
+	pOut[wordsPerRow - 1] &= lastWordMask;
+}
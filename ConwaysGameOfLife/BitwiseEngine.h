@@ -0,0 +1,41 @@
+#pragma once
+#include "LifeEngine.h"
+#include "BitwiseKernel.h"
+#include <cstdint>
+
+enum class InstructionSet
+{
+	Swar,	//64 cells per operation in a plain uint64_t
+	Avx2,	//256 cells per operation
+	Avx512	//512 cells per operation
+};
+
+//Engine that steps the packed grid with the bit-sliced kernel from BitwiseKernel.h.
+//The widest instruction set that is both allowed and supported by the CPU is picked at construction.
+//Common rules have kernels compiled for them, other rules go through a kernel that reads the rule masks at runtime.
+//The halo of the grid makes every word look like an inner word, so all of them go through the same kernel.
+class BitwiseEngine final : public LifeEngine
+{
+public:
+	BitwiseEngine(InstructionSet maxInstructionSet = InstructionSet::Avx512);
+	virtual ~BitwiseEngine() = default;
+	BitwiseEngine(const BitwiseEngine& other) = delete;
+	BitwiseEngine(BitwiseEngine&& other) = delete;
+	BitwiseEngine& operator=(const BitwiseEngine& other) = delete;
+	BitwiseEngine& operator=(BitwiseEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+	virtual void SetRule(const Rule& rule) override;
+
+	InstructionSet GetInstructionSet() const;
+
+protected:
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+
+private:
+	InstructionSet m_InstructionSet;
+	StepWordsFunction m_pStepWords;
+	StepWordsFunction m_pStepWordsSwar;
+
+	void StepRow(const uint64_t* pAbove, const uint64_t* pRow, const uint64_t* pBelow, uint64_t* pOut, int wordsPerRow, uint64_t lastWordMask) const;
+};
@@ -0,0 +1,352 @@
+#pragma once
+#include <cstdint>
+#include "Rule.h"
+
+//Bit-sliced Life kernel shared by the SWAR and SIMD code paths.
+//Every bit of a vector is one cell, so a single pass of the adder network below
+//computes the next state of 64 (uint64_t), 256 (AVX2) or 512 (AVX-512) cells at once.
+//
+//The kernel is written against an Ops struct that provides the vector type and the handful of
+//operations it needs. Each instruction set gets its own Ops struct in its own translation unit,
+//so the SIMD code is only compiled with the matching compiler flags.
+
+//Sum of three one-bit inputs, split in a sum bit (weight 1) and a carry bit (weight 2)
+template <typename Ops, typename Vector>
+inline void FullAdd(Vector a, Vector b, Vector c, Vector& sum, Vector& carry)
+{
+	Vector partial = Ops::Xor(a, b);
+	sum = Ops::Xor(partial, c);
+	carry = Ops::Or(Ops::And(a, b), Ops::And(partial, c));
+}
+
+//Sum of two one-bit inputs, split in a sum bit (weight 1) and a carry bit (weight 2)
+template <typename Ops, typename Vector>
+inline void HalfAdd(Vector a, Vector b, Vector& sum, Vector& carry)
+{
+	sum = Ops::Xor(a, b);
+	carry = Ops::And(a, b);
+}
+
+//Neighbour count of every cell in a vector, one bit plane per binary digit
+template <typename Vector>
+struct NeighbourCount
+{
+	Vector ones, twos, fours, eights;
+};
+
+//Adds the 8 neighbours of every cell in 'center' given the 3 rows around them.
+//west/east hold the rows shifted so that the left/right neighbour of a cell sits in the cell's own bit.
+template <typename Ops, typename Vector>
+inline NeighbourCount<Vector> CountNeighbours(Vector aboveWest, Vector above, Vector aboveEast,
+	Vector west, Vector east,
+	Vector belowWest, Vector below, Vector belowEast)
+{
+	//Carry-save adder tree into a 4 bit count (ones, twos, fours, eights)
+	Vector sumAbove, carryAbove;
+	Vector sumBelow, carryBelow;
+	Vector sumSides, carrySides;
+	FullAdd<Ops>(aboveWest, above, aboveEast, sumAbove, carryAbove);
+	FullAdd<Ops>(belowWest, below, belowEast, sumBelow, carryBelow);
+	HalfAdd<Ops>(west, east, sumSides, carrySides);
+
+	NeighbourCount<Vector> count;
+	Vector carryOnes;
+	FullAdd<Ops>(sumAbove, sumBelow, sumSides, count.ones, carryOnes);
+
+	Vector twosPartial, foursPartial;
+	Vector foursCarry;
+	FullAdd<Ops>(carryAbove, carryBelow, carrySides, twosPartial, foursPartial);
+	HalfAdd<Ops>(twosPartial, carryOnes, count.twos, foursCarry);
+
+	HalfAdd<Ops>(foursPartial, foursCarry, count.fours, count.eights);
+	return count;
+}
+
+//Cells whose count is exactly n
+template <typename Ops, typename Vector>
+inline Vector CountEquals(const NeighbourCount<Vector>& count, int n)
+{
+	Vector ones = (n & 1) ? count.ones : Ops::Not(count.ones);
+	Vector twos = (n & 2) ? count.twos : Ops::Not(count.twos);
+	Vector fours = (n & 4) ? count.fours : Ops::Not(count.fours);
+	Vector eights = (n & 8) ? count.eights : Ops::Not(count.eights);
+	return Ops::And(Ops::And(ones, twos), Ops::And(fours, eights));
+}
+
+//Cells whose count has its bit set in the mask.
+//Written out per count so that a mask known at compile time folds down to only the terms it needs.
+template <typename Ops, typename Vector>
+inline Vector CountInMask(const NeighbourCount<Vector>& count, unsigned mask)
+{
+	Vector result = Ops::Zero();
+	if (mask & (1 << 0)) result = Ops::Or(result, CountEquals<Ops>(count, 0));
+	if (mask & (1 << 1)) result = Ops::Or(result, CountEquals<Ops>(count, 1));
+	if (mask & (1 << 2)) result = Ops::Or(result, CountEquals<Ops>(count, 2));
+	if (mask & (1 << 3)) result = Ops::Or(result, CountEquals<Ops>(count, 3));
+	if (mask & (1 << 4)) result = Ops::Or(result, CountEquals<Ops>(count, 4));
+	if (mask & (1 << 5)) result = Ops::Or(result, CountEquals<Ops>(count, 5));
+	if (mask & (1 << 6)) result = Ops::Or(result, CountEquals<Ops>(count, 6));
+	if (mask & (1 << 7)) result = Ops::Or(result, CountEquals<Ops>(count, 7));
+	if (mask & (1 << 8)) result = Ops::Or(result, CountEquals<Ops>(count, 8));
+	return result;
+}
+
+//Rule kernel for any rule, the masks are read from the Rule at runtime
+struct DynamicRule
+{
+	template <typename Ops, typename Vector>
+	static Vector Apply(const NeighbourCount<Vector>& count, Vector center, const Rule& rule)
+	{
+		Vector born = CountInMask<Ops>(count, rule.birthMask);
+		Vector survives = CountInMask<Ops>(count, rule.survivalMask);
+		return Ops::Or(Ops::AndNot(center, born), Ops::And(center, survives));
+	}
+};
+
+//Rule kernel with the masks baked in, every count that is not in a mask is compiled out
+template <unsigned BirthMask, unsigned SurvivalMask>
+struct StaticRule
+{
+	static const uint16_t Birth = BirthMask;
+	static const uint16_t Survival = SurvivalMask;
+
+	template <typename Ops, typename Vector>
+	static Vector Apply(const NeighbourCount<Vector>& count, Vector center, const Rule&)
+	{
+		Vector born = CountInMask<Ops>(count, BirthMask);
+		Vector survives = CountInMask<Ops>(count, SurvivalMask);
+		return Ops::Or(Ops::AndNot(center, born), Ops::And(center, survives));
+	}
+};
+
+//B3/S23 needs even less: alive with exactly 3 neighbours, or with 2 and already alive
+template <>
+struct StaticRule<0x008, 0x00C>
+{
+	static const uint16_t Birth = 0x008;
+	static const uint16_t Survival = 0x00C;
+
+	template <typename Ops, typename Vector>
+	static Vector Apply(const NeighbourCount<Vector>& count, Vector center, const Rule&)
+	{
+		Vector lessThanFour = Ops::AndNot(Ops::Or(count.fours, count.eights), count.twos);
+		return Ops::And(lessThanFour, Ops::Or(count.ones, center));
+	}
+};
+
+//Rules that get their own compiled kernels, everything else goes through DynamicRule
+using ConwayRule = StaticRule<0x008, 0x00C>;			//B3/S23
+using HighLifeRule = StaticRule<0x048, 0x00C>;			//B36/S23
+using DayAndNightRule = StaticRule<0x1C8, 0x1D8>;		//B3678/S34678
+using SeedsRule = StaticRule<0x004, 0x000>;				//B2/S
+using LifeWithoutDeathRule = StaticRule<0x008, 0x1FF>;	//B3/S012345678
+using MazeRule = StaticRule<0x008, 0x03E>;				//B3/S12345
+
+template <typename... RuleKernels>
+struct RuleKernelList
+{
+};
+
+//Every rule with a compiled kernel. Anything that dispatches on the rule goes through SelectRuleKernel with this list,
+//so a kernel added here reaches all of them.
+using CompiledRuleKernels = RuleKernelList<ConwayRule, HighLifeRule, DayAndNightRule, SeedsRule, LifeWithoutDeathRule, MazeRule>;
+
+//Returns selector.Select<RuleKernel>() for the compiled kernel of the rule, or for DynamicRule when the rule has none.
+//The selector names what it returns as Result.
+template <typename Selector>
+inline typename Selector::Result SelectRuleKernel(const Rule&, Selector& selector, RuleKernelList<>)
+{
+	return selector.template Select<DynamicRule>();
+}
+
+template <typename Selector, typename RuleKernel, typename... Others>
+inline typename Selector::Result SelectRuleKernel(const Rule& rule, Selector& selector, RuleKernelList<RuleKernel, Others...>)
+{
+	if (rule.birthMask == RuleKernel::Birth && rule.survivalMask == RuleKernel::Survival)
+		return selector.template Select<RuleKernel>();
+
+	return SelectRuleKernel(rule, selector, RuleKernelList<Others...>{});
+}
+
+template <typename Selector>
+inline typename Selector::Result SelectRuleKernel(const Rule& rule, Selector& selector)
+{
+	return SelectRuleKernel(rule, selector, CompiledRuleKernels{});
+}
+
+//Next generation of the cells in 'center' given the 3 rows around them
+template <typename Ops, typename RuleKernel, typename Vector>
+inline Vector NextGeneration(Vector aboveWest, Vector above, Vector aboveEast,
+	Vector west, Vector center, Vector east,
+	Vector belowWest, Vector below, Vector belowEast, const Rule& rule)
+{
+	NeighbourCount<Vector> count = CountNeighbours<Ops>(aboveWest, above, aboveEast, west, east, belowWest, below, belowEast);
+	return RuleKernel::template Apply<Ops>(count, center, rule);
+}
+
+//Steps the words [firstWord, lastWord) of a row, vector by vector.
+//Reads one word to the left and right of that range, so the caller keeps those in bounds.
+//Returns the first word that was not processed because it did not fill a whole vector.
+template <typename Ops, typename RuleKernel>
+inline int StepWords(const uint64_t* pAbove, const uint64_t* pRow, const uint64_t* pBelow, uint64_t* pOut, int firstWord, int lastWord, const Rule& rule)
+{
+	using Vector = typename Ops::Vector;
+
+	int w = firstWord;
+	for (; w + Ops::Lanes <= lastWord; w += Ops::Lanes)
+	{
+		//Shift the neighbouring cells into place, carrying the edge bit over from the neighbouring word
+		Vector above = Ops::Load(pAbove + w);
+		Vector aboveWest = Ops::Or(Ops::ShiftLeft1(above), Ops::ShiftRight63(Ops::Load(pAbove + w - 1)));
+		Vector aboveEast = Ops::Or(Ops::ShiftRight1(above), Ops::ShiftLeft63(Ops::Load(pAbove + w + 1)));
+
+		Vector center = Ops::Load(pRow + w);
+		Vector west = Ops::Or(Ops::ShiftLeft1(center), Ops::ShiftRight63(Ops::Load(pRow + w - 1)));
+		Vector east = Ops::Or(Ops::ShiftRight1(center), Ops::ShiftLeft63(Ops::Load(pRow + w + 1)));
+
+		Vector below = Ops::Load(pBelow + w);
+		Vector belowWest = Ops::Or(Ops::ShiftLeft1(below), Ops::ShiftRight63(Ops::Load(pBelow + w - 1)));
+		Vector belowEast = Ops::Or(Ops::ShiftRight1(below), Ops::ShiftLeft63(Ops::Load(pBelow + w + 1)));
+
+		Ops::Store(pOut + w, NextGeneration<Ops, RuleKernel>(aboveWest, above, aboveEast, west, center, east, belowWest, below, belowEast, rule));
+	}
+
+	return w;
+}
+
+using StepWordsFunction = int(*)(const uint64_t* pAbove, const uint64_t* pRow, const uint64_t* pBelow, uint64_t* pOut, int firstWord, int lastWord, const Rule& rule);
+
+//Picks the compiled kernel for the rule, or the runtime one when the rule has no kernel of its own
+template <typename Ops>
+struct StepWordsSelector
+{
+	using Result = StepWordsFunction;
+
+	template <typename RuleKernel>
+	Result Select() const
+	{
+		return &StepWords<Ops, RuleKernel>;
+	}
+};
+
+template <typename Ops>
+inline StepWordsFunction SelectStepWords(const Rule& rule)
+{
+	StepWordsSelector<Ops> selector{};
+	return SelectRuleKernel(rule, selector);
+}
+
+//Generations rules keep the dying states in extra bit planes next to the alive plane (the Grid itself).
+//A cell in dying state s (2 .. stateCount - 1) has the counter s - 1 stored across the planes, alive and dead cells have 0.
+static const int MaxDyingPlanes = 8;
+
+//Rows of one generation that a Generations kernel reads and writes
+struct GenerationsRows
+{
+	const uint64_t* pAbove;
+	const uint64_t* pRow;
+	const uint64_t* pBelow;
+	const uint64_t* pDying[MaxDyingPlanes];
+	uint64_t* pOut;
+	uint64_t* pDyingOut[MaxDyingPlanes];
+	int planeCount;
+};
+
+//Next alive state of the cells in 'center', the dying counters in pDying are advanced in place
+template <typename Ops, typename Vector>
+inline Vector NextGenerationsState(const NeighbourCount<Vector>& count, Vector center, Vector* pDying, int planeCount, const GenerationsRule& rule)
+{
+	Vector anyDying = Ops::Zero();
+	for (int plane{ 0 }; plane < planeCount; plane++)
+		anyDying = Ops::Or(anyDying, pDying[plane]);
+
+	//Only dead cells can be born, dying cells first have to run out their counter
+	Vector born = Ops::AndNot(Ops::Or(center, anyDying), CountInMask<Ops>(count, rule.rule.birthMask));
+	Vector survives = Ops::And(center, CountInMask<Ops>(count, rule.rule.survivalMask));
+	Vector startsDying = Ops::AndNot(survives, center);
+
+	//Cells in the last dying state become dead, every other dying cell moves one state on.
+	//The counter is incremented with a bit-sliced ripple carry and cleared where it was at its last value.
+	int lastCounter = rule.stateCount - 2;
+	Vector isLast = anyDying;
+	Vector carry = anyDying;
+	for (int plane{ 0 }; plane < planeCount; plane++)
+	{
+		isLast = Ops::And(isLast, ((lastCounter >> plane) & 1) ? pDying[plane] : Ops::Not(pDying[plane]));
+
+		Vector sum = Ops::Xor(pDying[plane], carry);
+		carry = Ops::And(pDying[plane], carry);
+		pDying[plane] = sum;
+	}
+
+	for (int plane{ 0 }; plane < planeCount; plane++)
+		pDying[plane] = Ops::AndNot(isLast, pDying[plane]);
+
+	//Alive cells that do not survive start at counter 1
+	if (planeCount > 0)
+		pDying[0] = Ops::Or(pDying[0], startsDying);
+
+	return Ops::Or(born, survives);
+}
+
+//Generations version of StepWords, the neighbour count only looks at the alive plane
+template <typename Ops>
+inline int StepGenerationsWords(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule)
+{
+	using Vector = typename Ops::Vector;
+
+	int w = firstWord;
+	for (; w + Ops::Lanes <= lastWord; w += Ops::Lanes)
+	{
+		Vector above = Ops::Load(rows.pAbove + w);
+		Vector aboveWest = Ops::Or(Ops::ShiftLeft1(above), Ops::ShiftRight63(Ops::Load(rows.pAbove + w - 1)));
+		Vector aboveEast = Ops::Or(Ops::ShiftRight1(above), Ops::ShiftLeft63(Ops::Load(rows.pAbove + w + 1)));
+
+		Vector center = Ops::Load(rows.pRow + w);
+		Vector west = Ops::Or(Ops::ShiftLeft1(center), Ops::ShiftRight63(Ops::Load(rows.pRow + w - 1)));
+		Vector east = Ops::Or(Ops::ShiftRight1(center), Ops::ShiftLeft63(Ops::Load(rows.pRow + w + 1)));
+
+		Vector below = Ops::Load(rows.pBelow + w);
+		Vector belowWest = Ops::Or(Ops::ShiftLeft1(below), Ops::ShiftRight63(Ops::Load(rows.pBelow + w - 1)));
+		Vector belowEast = Ops::Or(Ops::ShiftRight1(below), Ops::ShiftLeft63(Ops::Load(rows.pBelow + w + 1)));
+
+		Vector dying[MaxDyingPlanes];
+		for (int plane{ 0 }; plane < rows.planeCount; plane++)
+			dying[plane] = Ops::Load(rows.pDying[plane] + w);
+
+		auto count = CountNeighbours<Ops>(aboveWest, above, aboveEast, west, east, belowWest, below, belowEast);
+		Ops::Store(rows.pOut + w, NextGenerationsState<Ops>(count, center, dying, rows.planeCount, rule));
+
+		for (int plane{ 0 }; plane < rows.planeCount; plane++)
+			Ops::Store(rows.pDyingOut[plane] + w, dying[plane]);
+	}
+
+	return w;
+}
+
+//Plain 64 bit SWAR operations, used directly by the engine and as the fallback for the SIMD paths
+struct SwarOps
+{
+	using Vector = uint64_t;
+	static const int Lanes = 1;
+
+	static Vector Load(const uint64_t* pWords) { return *pWords; }
+	static void Store(uint64_t* pWords, Vector value) { *pWords = value; }
+	static Vector And(Vector a, Vector b) { return a & b; }
+	static Vector AndNot(Vector a, Vector b) { return ~a & b; }
+	static Vector Or(Vector a, Vector b) { return a | b; }
+	static Vector Xor(Vector a, Vector b) { return a ^ b; }
+	static Vector Not(Vector a) { return ~a; }
+	static Vector Zero() { return 0; }
+	static Vector ShiftLeft1(Vector a) { return a << 1; }
+	static Vector ShiftRight1(Vector a) { return a >> 1; }
+	static Vector ShiftLeft63(Vector a) { return a << 63; }
+	static Vector ShiftRight63(Vector a) { return a >> 63; }
+};
+
+//SIMD kernel selection, compiled in their own translation units with AVX2/AVX-512 code generation enabled.
+//Only call the returned kernels after CpuFeatures confirmed the instruction set is available.
+StepWordsFunction SelectStepWordsAvx2(const Rule& rule);
+StepWordsFunction SelectStepWordsAvx512(const Rule& rule);
+int StepGenerationsWordsAvx2(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule);
+int StepGenerationsWordsAvx512(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule);
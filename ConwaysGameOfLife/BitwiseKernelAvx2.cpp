@@ -0,0 +1,51 @@
+#include "BitwiseKernel.h"
+
+//This file is compiled with AVX2 code generation enabled (/arch:AVX2, -mavx2).
+//Nothing in here may run before CpuFeatures::HasAvx2() returned true.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+//4 words (256 cells) per vector
+struct Avx2Ops
+{
+	using Vector = __m256i;
+	static const int Lanes = 4;
+
+	static Vector Load(const uint64_t* pWords) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pWords)); }
+	static void Store(uint64_t* pWords, Vector value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(pWords), value); }
+	static Vector And(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+	static Vector AndNot(Vector a, Vector b) { return _mm256_andnot_si256(a, b); }
+	static Vector Or(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+	static Vector Xor(Vector a, Vector b) { return _mm256_xor_si256(a, b); }
+	static Vector Not(Vector a) { return _mm256_xor_si256(a, _mm256_set1_epi64x(-1)); }
+	static Vector Zero() { return _mm256_setzero_si256(); }
+	static Vector ShiftLeft1(Vector a) { return _mm256_slli_epi64(a, 1); }
+	static Vector ShiftRight1(Vector a) { return _mm256_srli_epi64(a, 1); }
+	static Vector ShiftLeft63(Vector a) { return _mm256_slli_epi64(a, 63); }
+	static Vector ShiftRight63(Vector a) { return _mm256_srli_epi64(a, 63); }
+};
+
+StepWordsFunction SelectStepWordsAvx2(const Rule& rule)
+{
+	return SelectStepWords<Avx2Ops>(rule);
+}
+
+int StepGenerationsWordsAvx2(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule)
+{
+	return StepGenerationsWords<Avx2Ops>(rows, firstWord, lastWord, rule);
+}
+
+#else
+
+//No AVX2 on this architecture, CpuFeatures never reports it so there is no kernel to hand out
+StepWordsFunction SelectStepWordsAvx2(const Rule&)
+{
+	return nullptr;
+}
+
+int StepGenerationsWordsAvx2(const GenerationsRows&, int firstWord, int, const GenerationsRule&)
+{
+	return firstWord;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#include "BitwiseKernel.h"
+
+//This file is compiled with AVX-512 code generation enabled (/arch:AVX512, -mavx512f).
+//Nothing in here may run before CpuFeatures::HasAvx512() returned true.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+//8 words (512 cells) per vector, only AVX-512F instructions are used
+struct Avx512Ops
+{
+	using Vector = __m512i;
+	static const int Lanes = 8;
+
+	static Vector Load(const uint64_t* pWords) { return _mm512_loadu_si512(pWords); }
+	static void Store(uint64_t* pWords, Vector value) { _mm512_storeu_si512(pWords, value); }
+	static Vector And(Vector a, Vector b) { return _mm512_and_si512(a, b); }
+	static Vector AndNot(Vector a, Vector b) { return _mm512_andnot_si512(a, b); }
+	static Vector Or(Vector a, Vector b) { return _mm512_or_si512(a, b); }
+	static Vector Xor(Vector a, Vector b) { return _mm512_xor_si512(a, b); }
+	static Vector Not(Vector a) { return _mm512_xor_si512(a, _mm512_set1_epi64(-1)); }
+	static Vector Zero() { return _mm512_setzero_si512(); }
+	static Vector ShiftLeft1(Vector a) { return _mm512_slli_epi64(a, 1); }
+	static Vector ShiftRight1(Vector a) { return _mm512_srli_epi64(a, 1); }
+	static Vector ShiftLeft63(Vector a) { return _mm512_slli_epi64(a, 63); }
+	static Vector ShiftRight63(Vector a) { return _mm512_srli_epi64(a, 63); }
+};
+
+StepWordsFunction SelectStepWordsAvx512(const Rule& rule)
+{
+	return SelectStepWords<Avx512Ops>(rule);
+}
+
+int StepGenerationsWordsAvx512(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule)
+{
+	return StepGenerationsWords<Avx512Ops>(rows, firstWord, lastWord, rule);
+}
+
+#else
+
+//No AVX-512 on this architecture, CpuFeatures never reports it so there is no kernel to hand out
+StepWordsFunction SelectStepWordsAvx512(const Rule&)
+{
+	return nullptr;
+}
+
+int StepGenerationsWordsAvx512(const GenerationsRows&, int firstWord, int, const GenerationsRule&)
+{
+	return firstWord;
+}
+
+#endif
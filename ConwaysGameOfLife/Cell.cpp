@@ -1,49 +1,302 @@
 #include "Cell.h"
 #include <algorithm>
+#include <cstddef>
+#include <atomic>
+#include <utility>
+
+//Every grid starts its own change history, copies continue the one of their original
+static uint64_t NewChangeLineage()
+{
+	static std::atomic<uint64_t> s_NextLineage{ 1 };
+	return s_NextLineage++;
+}
 
 Grid::Grid(int width, int height, int cellSize)
 	: m_Width(width)
 	, m_Height(height)
 	, m_CellSize(cellSize)
+	, m_WordsPerRow(0)
+	, m_Stride(0)
+	, m_Topology(Topology::DeadBorder)
+	, m_PaddingFilled(false)
+	, m_Generation(0)
+	, m_EditVersion(0)
+	, m_pWords(nullptr)
+	, m_pNextWords(nullptr)
+	, m_StatisticsEditVersion(0)
+	, m_HasStatistics(false)
+	, m_StepChangesEditVersion(0)
+	, m_StepChangesGeneration(0)
+	, m_RecordingChanges(false)
+	, m_HasStepChanges(false)
+	, m_ChangeLineage(NewChangeLineage())
+	, m_ChangeSequence(0)
+	, m_EverythingChangedSequence(0)
+	, m_OwnsLineage(true)
 {
 	//Clamp width and height to not be negative or 0
 	NegativeCheck(m_Width);
 	NegativeCheck(m_Height);
 	NegativeCheck(m_CellSize);
 
-	//Create a grid of cells with size width * height
-	m_Cells.reserve(m_Width * m_Height);
+	//Every row is padded to a whole number of 64 cell words so rows can be accessed with a fixed stride,
+	//plus a halo word on either side and a halo row above and below
+	m_WordsPerRow = (m_Width + 63) / 64;
+	m_Stride = m_WordsPerRow + 2;
+	m_Words.assign(GetBufferWordCount(), 0);
 
-	//Loop over the width and height and initialize all the cells with their proper position
-	for (int y{ 0 }; y < m_Height; y++)
+	//Allocate the buffer for the next generation up front so stepping never has to
+	m_NextWords.assign(m_Words.size(), 0);
+
+	m_pWords = m_Words.data();
+	m_pNextWords = m_NextWords.data();
+	m_ChunkChanges.assign(size_t(GetChangeChunksPerRow()) * m_Height, 0);
+}
+
+Grid::Grid(int width, int height, int cellSize, uint64_t* pExternalWords, uint64_t generation, Topology topology)
+	: m_Width(width)
+	, m_Height(height)
+	, m_CellSize(cellSize)
+	, m_WordsPerRow(0)
+	, m_Stride(0)
+	, m_Topology(topology)
+	, m_PaddingFilled(false)
+	, m_Generation(generation)
+	, m_EditVersion(0)
+	, m_pWords(pExternalWords)
+	, m_pNextWords(nullptr)
+	, m_StatisticsEditVersion(0)
+	, m_HasStatistics(false)
+	, m_StepChangesEditVersion(0)
+	, m_StepChangesGeneration(0)
+	, m_RecordingChanges(false)
+	, m_HasStepChanges(false)
+	, m_ChangeLineage(NewChangeLineage())
+	, m_ChangeSequence(0)
+	, m_EverythingChangedSequence(0)
+	, m_OwnsLineage(true)
+{
+	NegativeCheck(m_Width);
+	NegativeCheck(m_Height);
+	NegativeCheck(m_CellSize);
+
+	m_WordsPerRow = (m_Width + 63) / 64;
+	m_Stride = m_WordsPerRow + 2;
+	m_ChunkChanges.assign(size_t(GetChangeChunksPerRow()) * m_Height, 0);
+}
+
+Grid::Grid(const Grid& other)
+	: m_Width(other.m_Width)
+	, m_Height(other.m_Height)
+	, m_CellSize(other.m_CellSize)
+	, m_WordsPerRow(other.m_WordsPerRow)
+	, m_Stride(other.m_Stride)
+	, m_Topology(other.m_Topology)
+	, m_PaddingFilled(false)
+	, m_Generation(other.m_Generation)
+	, m_EditVersion(other.m_EditVersion)
+	, m_GenerationCounters(other.m_GenerationCounters)
+	, m_Statistics(other.m_Statistics)
+	, m_StatisticsEditVersion(other.m_StatisticsEditVersion)
+	, m_HasStatistics(other.m_HasStatistics)
+	, m_StepChanges(other.m_StepChanges)
+	, m_StepChangesEditVersion(other.m_StepChangesEditVersion)
+	, m_StepChangesGeneration(other.m_StepChangesGeneration)
+	, m_RecordingChanges(false)
+	, m_HasStepChanges(other.m_HasStepChanges)
+	, m_ChunkChanges(other.m_ChunkChanges)
+	, m_ChangeLineage(other.m_ChangeLineage)
+	, m_ChangeSequence(other.m_ChangeSequence)
+	, m_EverythingChangedSequence(other.m_EverythingChangedSequence)
+	, m_OwnsLineage(false)
+{
+	//A copy always owns its cells, even when the original lives on external memory
+	size_t size = other.GetBufferWordCount();
+	m_Words.assign(other.m_pWords, other.m_pWords + size);
+	m_NextWords.assign(size, 0);
+	m_pWords = m_Words.data();
+	m_pNextWords = m_NextWords.data();
+}
+
+Grid::Grid(Grid&& other)
+	: m_Width(other.m_Width)
+	, m_Height(other.m_Height)
+	, m_CellSize(other.m_CellSize)
+	, m_WordsPerRow(other.m_WordsPerRow)
+	, m_Stride(other.m_Stride)
+	, m_Topology(other.m_Topology)
+	, m_PaddingFilled(other.m_PaddingFilled)
+	, m_Generation(other.m_Generation)
+	, m_EditVersion(other.m_EditVersion)
+	, m_Words(std::move(other.m_Words))
+	, m_NextWords(std::move(other.m_NextWords))
+	, m_pWords(other.m_pWords)
+	, m_pNextWords(other.m_pNextWords)
+	, m_GenerationCounters(other.m_GenerationCounters)
+	, m_Statistics(other.m_Statistics)
+	, m_StatisticsEditVersion(other.m_StatisticsEditVersion)
+	, m_HasStatistics(other.m_HasStatistics)
+	, m_StepChanges(std::move(other.m_StepChanges))
+	, m_StepChangesEditVersion(other.m_StepChangesEditVersion)
+	, m_StepChangesGeneration(other.m_StepChangesGeneration)
+	, m_RecordingChanges(false)
+	, m_HasStepChanges(other.m_HasStepChanges)
+	, m_ChunkChanges(std::move(other.m_ChunkChanges))
+	, m_ChangeLineage(other.m_ChangeLineage)
+	, m_ChangeSequence(other.m_ChangeSequence)
+	, m_EverythingChangedSequence(other.m_EverythingChangedSequence)
+	, m_OwnsLineage(other.m_OwnsLineage)
+{
+	//Moving a vector keeps its buffer, so the pointers stay valid
+	other.m_pWords = nullptr;
+	other.m_pNextWords = nullptr;
+	other.m_OwnsLineage = false;
+}
+
+Grid& Grid::operator=(const Grid& other)
+{
+	if (this != &other)
+		*this = Grid{ other };
+
+	return *this;
+}
+
+Grid& Grid::operator=(Grid&& other)
+{
+	if (this == &other)
+		return *this;
+
+	m_Width = other.m_Width;
+	m_Height = other.m_Height;
+	m_CellSize = other.m_CellSize;
+	m_WordsPerRow = other.m_WordsPerRow;
+	m_Stride = other.m_Stride;
+	m_Topology = other.m_Topology;
+	m_PaddingFilled = other.m_PaddingFilled;
+	m_Generation = other.m_Generation;
+	m_EditVersion = other.m_EditVersion;
+	m_Words = std::move(other.m_Words);
+	m_NextWords = std::move(other.m_NextWords);
+	m_pWords = other.m_pWords;
+	m_pNextWords = other.m_pNextWords;
+	m_GenerationCounters = other.m_GenerationCounters;
+	m_Statistics = other.m_Statistics;
+	m_StatisticsEditVersion = other.m_StatisticsEditVersion;
+	m_HasStatistics = other.m_HasStatistics;
+	m_StepChanges = std::move(other.m_StepChanges);
+	m_StepChangesEditVersion = other.m_StepChangesEditVersion;
+	m_StepChangesGeneration = other.m_StepChangesGeneration;
+	m_RecordingChanges = false;
+	m_HasStepChanges = other.m_HasStepChanges;
+	m_ChunkChanges = std::move(other.m_ChunkChanges);
+	m_ChangeLineage = other.m_ChangeLineage;
+	m_ChangeSequence = other.m_ChangeSequence;
+	m_EverythingChangedSequence = other.m_EverythingChangedSequence;
+	m_OwnsLineage = other.m_OwnsLineage;
+
+	other.m_pWords = nullptr;
+	other.m_pNextWords = nullptr;
+	other.m_OwnsLineage = false;
+	return *this;
+}
+
+void Grid::CopyFrom(const Grid& other)
+{
+	if (this == &other)
+		return;
+
+	if (m_Width != other.m_Width || m_Height != other.m_Height || m_CellSize != other.m_CellSize)
 	{
-		for (int x{ 0 }; x < m_Width; x++)
-		{
-			m_Cells.push_back(Cell{ glm::ivec2{x, y}, m_CellSize });
-		}
+		*this = other;
+		return;
 	}
+
+	std::copy(other.m_pWords, other.m_pWords + other.GetBufferWordCount(), m_pWords);
+	m_Topology = other.m_Topology;
+	m_Generation = other.m_Generation;
+	++m_EditVersion;
+
+	//The frame continues the change history of the other grid, whoever saw an earlier frame of it only has to redo what changed since
+	std::copy(other.m_ChunkChanges.begin(), other.m_ChunkChanges.end(), m_ChunkChanges.begin());
+	m_ChangeLineage = other.m_ChangeLineage;
+	m_ChangeSequence = other.m_ChangeSequence;
+	m_EverythingChangedSequence = other.m_EverythingChangedSequence;
+	m_OwnsLineage = false;
+
+	//The cells are exactly those the statistics were counted on, so a copied frame keeps them
+	m_Statistics = other.m_Statistics;
+	m_HasStatistics = other.HasCurrentStatistics();
+	m_StatisticsEditVersion = m_EditVersion;
 }
 
-int Grid::GetWidth()
+int Grid::GetWidth() const
 {
 	return m_Width;
 }
 
-int Grid::GetHeight()
+int Grid::GetHeight() const
 {
 	return m_Height;
 }
 
-int Grid::GetCellSize()
+int Grid::GetCellSize() const
 {
 	return m_CellSize;
 }
 
-void Grid::ToggleCell(int x, int y)
+int Grid::GetWordsPerRow() const
 {
-	int idx = x  + y  * m_Width;
+	return m_WordsPerRow;
+}
 
-	m_Cells[idx].alive = !m_Cells[idx].alive;
+uint64_t Grid::GetLastWordMask() const
+{
+	//Mask of the bits in the last word of a row that belong to actual cells
+	int usedBits = m_Width % 64;
+	return usedBits == 0 ? ~uint64_t(0) : (uint64_t(1) << usedBits) - 1;
+}
+
+void Grid::SetTopology(Topology topology)
+{
+	//Whatever the old topology left in the halo must not leak into a dead border
+	m_Topology = topology;
+	ClearHalo(m_pWords);
+	if (m_pNextWords)
+		ClearHalo(m_pNextWords);
+
+	MarkEdited();
+}
+
+Topology Grid::GetTopology() const
+{
+	return m_Topology;
+}
+
+bool Grid::IsAlive(int x, int y) const
+{
+	//Shifting instead of dividing rounds column -1 down to the halo word
+	return (GetRow(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+void Grid::SetCell(int x, int y, bool alive)
+{
+	uint64_t bit = uint64_t(1) << (x % 64);
+	uint64_t& word = GetRow(y)[x / 64];
+
+	if (alive)
+		word |= bit;
+	else
+		word &= ~bit;
+
+	++m_EditVersion;
+	MarkCellChanged(x, y);
+}
+
+void Grid::ToggleCell(int x, int y)
+{
+	GetRow(y)[x / 64] ^= uint64_t(1) << (x % 64);
+	++m_EditVersion;
+	MarkCellChanged(x, y);
 }
 
 void Grid::ToggleCell(const glm::ivec2& position)
@@ -53,22 +306,317 @@ void Grid::ToggleCell(const glm::ivec2& position)
 
 void Grid::ClearGrid()
 {
-	std::for_each(m_Cells.begin(), m_Cells.end(), [](Cell& cell)
+	std::fill(m_pWords, m_pWords + GetBufferWordCount(), uint64_t(0));
+	MarkEdited();
+}
+
+uint64_t Grid::GetEditVersion() const
+{
+	return m_EditVersion;
+}
+
+void Grid::MarkEdited()
+{
+	++m_EditVersion;
+	m_EverythingChangedSequence = NextChangeSequence();
+}
+
+const uint64_t* Grid::GetRow(int y) const
+{
+	return m_pWords + ptrdiff_t(y + 1) * m_Stride + 1;
+}
+
+uint64_t* Grid::GetRow(int y)
+{
+	return m_pWords + ptrdiff_t(y + 1) * m_Stride + 1;
+}
+
+void Grid::FillHalo()
+{
+	//A dead border is a halo of zeros, which nothing ever writes to
+	if (m_Topology == Topology::DeadBorder)
+		return;
+
+	//Left and right wrap around for both topologies, the corners come along with the rows below
+	for (int y{ 0 }; y < m_Height; y++)
+		FillRowSides(GetRow(y));
+
+	size_t rowBytes = size_t(m_Stride) * sizeof(uint64_t);
+	if (m_Topology == Topology::Torus)
+	{
+		std::copy(GetRow(m_Height - 1) - 1, GetRow(m_Height - 1) - 1 + m_Stride, GetRow(-1) - 1);
+		std::copy(GetRow(0) - 1, GetRow(0) - 1 + m_Stride, GetRow(m_Height) - 1);
+	}
+	else
+	{
+		//Cell (x, -1) is cell (width - 1 - x, height - 1), the sides of the mirrored rows wrap around like any other row
+		MirrorRow(GetRow(m_Height - 1), GetRow(-1), m_Width);
+		MirrorRow(GetRow(0), GetRow(m_Height), m_Width);
+		FillRowSides(GetRow(-1));
+		FillRowSides(GetRow(m_Height));
+	}
+
+	RecordCopy(2 * rowBytes);
+	m_PaddingFilled = m_Width % 64 != 0;
+}
+
+int Grid::GetStride() const
+{
+	return m_Stride;
+}
+
+const uint64_t* Grid::GetBuffer() const
+{
+	return m_pWords;
+}
+
+size_t Grid::GetBufferWordCount() const
+{
+	return size_t(m_Stride) * (size_t(m_Height) + 2);
+}
+
+uint64_t* Grid::GetNextRow(int y)
+{
+	return m_pNextWords + ptrdiff_t(y + 1) * m_Stride + 1;
+}
+
+void Grid::BeginGeneration()
+{
+	m_GenerationCounters = GenerationCounters{};
+
+	if (!m_pNextWords)
+	{
+		m_NextWords.assign(GetBufferWordCount(), 0);
+		m_pNextWords = m_NextWords.data();
+		RecordAllocation(m_NextWords.size() * sizeof(uint64_t));
+	}
+}
+
+void Grid::SwapBuffers()
+{
+	//Only the buffer pointers are exchanged, the old generation becomes the buffer for the next one
+	std::swap(m_pWords, m_pNextWords);
+
+	//What was recorded while stepping describes the generation that just became current,
+	//RecordRowChanges already stamped the chunks with the sequence of this step
+	uint64_t sequence = NextChangeSequence();
+	if (!m_RecordingChanges)
+		m_EverythingChangedSequence = sequence;
+	m_HasStepChanges = m_RecordingChanges;
+	m_RecordingChanges = false;
+
+	//The previous generation has to look exactly like it did before it was stepped
+	if (m_PaddingFilled)
+	{
+		ClearPadding(m_pNextWords);
+		m_PaddingFilled = false;
+	}
+	++m_Generation;
+	m_StepChangesGeneration = m_Generation;
+	m_StepChangesEditVersion = m_EditVersion;
+}
+
+uint64_t Grid::GetGeneration() const
+{
+	return m_Generation;
+}
+
+const uint64_t* Grid::GetPreviousRow(int y) const
+{
+	return m_pNextWords + ptrdiff_t(y + 1) * m_Stride + 1;
+}
+
+bool Grid::HasPreviousGeneration() const
+{
+	//A grid on external memory has no back buffer before its first step
+	return m_pNextWords != nullptr;
+}
+
+void Grid::SkipGenerations(uint64_t generations)
+{
+	m_Generation += generations;
+}
+
+void Grid::SetGeneration(uint64_t generation)
+{
+	m_Generation = generation;
+}
+
+void Grid::RecordAllocation(size_t bytes)
+{
+	++m_GenerationCounters.allocations;
+	m_GenerationCounters.bytesAllocated += bytes;
+}
+
+void Grid::RecordCopy(size_t bytes)
+{
+	m_GenerationCounters.bytesCopied += bytes;
+}
+
+const GenerationCounters& Grid::GetGenerationCounters() const
+{
+	return m_GenerationCounters;
+}
+
+void Grid::SetStatistics(const GenerationStatistics& statistics)
+{
+	m_Statistics = statistics;
+	m_StatisticsEditVersion = m_EditVersion;
+	m_HasStatistics = true;
+}
+
+bool Grid::HasCurrentStatistics() const
+{
+	return m_HasStatistics && m_StatisticsEditVersion == m_EditVersion && m_Statistics.generation == m_Generation;
+}
+
+GenerationStatistics Grid::GetStatistics() const
+{
+	if (HasCurrentStatistics())
+		return m_Statistics;
+
+	GenerationStatistics statistics{};
+	statistics.generation = m_Generation;
+	statistics.minX = m_Width;
+	statistics.minY = m_Height;
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		const uint64_t* pRow = GetRow(y);
+		for (int w{ 0 }; w < m_WordsPerRow; w++)
 		{
-			if (cell.alive)
-				cell.alive = false;
+			if (pRow[w] == 0)
+				continue;
+
+			statistics.population += PopCount64(pRow[w]);
+			statistics.minX = std::min(statistics.minX, w * 64 + CountTrailingZeros64(pRow[w]));
+			statistics.maxX = std::max(statistics.maxX, w * 64 + 63 - CountLeadingZeros64(pRow[w]));
+			statistics.minY = std::min(statistics.minY, y);
+			statistics.maxY = y;
 		}
-	);
+	}
+
+	if (statistics.population == 0)
+	{
+		statistics.minX = 0;
+		statistics.minY = 0;
+	}
+
+	return statistics;
 }
 
-const std::vector<Cell>& Grid::GetCells()
+void Grid::BeginRecordingChanges()
 {
-	return m_Cells;
+	size_t size = size_t(GetChangeChunksPerRow()) * m_Height;
+	if (m_StepChanges.size() != size)
+	{
+		m_StepChanges.assign(size, 0);
+		RecordAllocation(size * sizeof(uint64_t));
+	}
+	m_RecordingChanges = true;
+}
+
+void Grid::RecordRowChanges(int y)
+{
+	//The padding bits of the current row may hold the halo column, they are not part of the grid
+	const uint64_t* pRow = GetRow(y);
+	const uint64_t* pNext = m_pNextWords + ptrdiff_t(y + 1) * m_Stride + 1;
+	uint64_t* pChanges = m_StepChanges.data() + size_t(y) * GetChangeChunksPerRow();
+	uint64_t* pChunkChanges = m_ChunkChanges.data() + size_t(y) * GetChangeChunksPerRow();
+	uint64_t sequence = m_ChangeSequence + 1;
+	uint64_t lastWordMask = GetLastWordMask();
+
+	for (int first{ 0 }; first < m_WordsPerRow; first += 64)
+	{
+		int last = std::min(m_WordsPerRow, first + 64);
+		uint64_t changes{ 0 };
+		for (int w{ first }; w < last; w++)
+		{
+			uint64_t difference = pRow[w] ^ pNext[w];
+			if (w == m_WordsPerRow - 1)
+				difference &= lastWordMask;
+			changes |= uint64_t(difference != 0) << (w - first);
+		}
+		pChanges[first / 64] = changes;
+		if (changes != 0)
+			pChunkChanges[first / 64] = sequence;
+	}
 }
 
-std::vector<Cell> Grid::GetCellsCopy()
+bool Grid::HasStepChanges() const
 {
-	return m_Cells;
+	return m_HasStepChanges && m_StepChangesEditVersion == m_EditVersion && m_StepChangesGeneration == m_Generation;
+}
+
+int Grid::GetChangeChunksPerRow() const
+{
+	return (m_WordsPerRow + 63) / 64;
+}
+
+const uint64_t* Grid::GetStepChanges(int y) const
+{
+	return m_StepChanges.data() + size_t(y) * GetChangeChunksPerRow();
+}
+
+ChangeMark Grid::GetChangeMark() const
+{
+	return ChangeMark{ m_ChangeLineage, m_ChangeSequence };
+}
+
+bool Grid::IsEverythingChangedSince(const ChangeMark& mark) const
+{
+	return mark.lineage != m_ChangeLineage || mark.sequence > m_ChangeSequence || m_EverythingChangedSequence > mark.sequence;
+}
+
+bool Grid::IsChunkChangedSince(const ChangeMark& mark, int y, int chunk) const
+{
+	return m_ChunkChanges[size_t(y) * GetChangeChunksPerRow() + chunk] > mark.sequence;
+}
+
+uint64_t Grid::NextChangeSequence()
+{
+	//The first change of a copy starts a history of its own, its marks no longer describe the cells of the original
+	if (!m_OwnsLineage)
+	{
+		m_ChangeLineage = NewChangeLineage();
+		m_OwnsLineage = true;
+	}
+	return ++m_ChangeSequence;
+}
+
+void Grid::MarkCellChanged(int x, int y)
+{
+	//Cells of the halo are not part of any chunk
+	uint64_t sequence = NextChangeSequence();
+	if (x >= 0 && x < m_Width && y >= 0 && y < m_Height)
+		m_ChunkChanges[size_t(y) * GetChangeChunksPerRow() + x / 64 / 64] = sequence;
+}
+
+uint64_t Grid::ComputeHash() const
+{
+	//Padding bits are always 0 so they do not matter
+	uint64_t hash = BeginGridHash(m_Width, m_Height);
+	for (int y{ 0 }; y < m_Height; y++)
+		hash = HashWords(hash, GetRow(y), m_WordsPerRow);
+
+	return hash;
+}
+
+uint64_t Grid::GetPopulation() const
+{
+	uint64_t population = 0;
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		const uint64_t* pRow = GetRow(y);
+		for (int w{ 0 }; w < m_WordsPerRow; w++)
+			population += PopCount64(pRow[w]);
+	}
+
+	return population;
+}
+
+Cell Grid::GetCell(int x, int y) const
+{
+	return Cell{ glm::ivec2{x, y}, m_CellSize, IsAlive(x, y) };
 }
 
 void Grid::NegativeCheck(int& value)
@@ -77,6 +625,42 @@ void Grid::NegativeCheck(int& value)
 		value = 1;
 }
 
+void Grid::FillRowSides(uint64_t* pRow)
+{
+	//Column -1 is the last column, column width is the first one
+	int lastWord = m_WordsPerRow - 1;
+	int eastBit = m_Width % 64;
+	pRow[-1] = ((pRow[(m_Width - 1) / 64] >> ((m_Width - 1) % 64)) & 1) << 63;
+
+	uint64_t first = pRow[0] & 1;
+	if (eastBit == 0)
+		pRow[m_WordsPerRow] = first;
+	else
+		pRow[lastWord] = (pRow[lastWord] & GetLastWordMask()) | (first << eastBit);
+}
+
+void Grid::ClearHalo(uint64_t* pWords)
+{
+	uint64_t* pFirstRow = pWords + m_Stride + 1;
+	std::fill(pWords, pWords + m_Stride, uint64_t(0));
+	std::fill(pWords + size_t(m_Height + 1) * m_Stride, pWords + GetBufferWordCount(), uint64_t(0));
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		pFirstRow[size_t(y) * m_Stride - 1] = 0;
+		pFirstRow[size_t(y) * m_Stride + m_WordsPerRow] = 0;
+	}
+
+	ClearPadding(pWords);
+}
+
+void Grid::ClearPadding(uint64_t* pWords)
+{
+	uint64_t mask = GetLastWordMask();
+	uint64_t* pLastWord = pWords + m_Stride + m_WordsPerRow;
+	for (int y{ 0 }; y < m_Height; y++)
+		pLastWord[size_t(y) * m_Stride] &= mask;
+}
+
 Cell::Cell(const glm::ivec2& position, int size, bool alive)
 	: position(position)
 	, size(size)
@@ -1,43 +1,229 @@
 #pragma once
 #include <glm.hpp>
 #include <vector>
+#include <cstdint>
+#include "Bits.h"
 
 struct Cell;
+
+//Heap work done by one generation, engines are expected to keep all of these at 0 once warmed up
+struct GenerationCounters
+{
+	uint64_t allocations = 0;
+	uint64_t bytesAllocated = 0;
+	uint64_t bytesCopied = 0;
+};
+
+//What one step did to the grid, counted by the engine while the rows it wrote were still in the cache.
+//The bounding box is inclusive, maxX/maxY are -1 when no cell is alive.
+struct GenerationStatistics
+{
+	uint64_t generation = 0;
+	uint64_t population = 0;
+	uint64_t births = 0;
+	uint64_t deaths = 0;
+	int minX = 0;
+	int minY = 0;
+	int maxX = -1;
+	int maxY = -1;
+};
+
+//A point in the change history of a grid, see Grid::GetChangeMark. The default mark comes before every change.
+struct ChangeMark
+{
+	uint64_t lineage = 0;
+	uint64_t sequence = 0;
+};
+
+//What lies beyond the edges of the grid. Engines never look at this, it only decides how the halo is filled.
+enum class Topology
+{
+	DeadBorder,		//Everything outside of the grid is dead
+	Torus,			//Leaving one edge enters at the opposite edge
+	KleinBottle		//Like a torus, but crossing the top or bottom edge also mirrors left and right
+};
+
 class Grid final
 {
 public:
 	Grid(int width, int height, int cellSize);
+	//Uses rows in external memory with the same layout as the current generation, e.g. a mapped snapshot.
+	//Nothing is copied, the memory has to stay writable and alive for as long as the grid uses it.
+	//The external memory holds the whole buffer as GetBuffer returns it, halo included.
+	Grid(int width, int height, int cellSize, uint64_t* pExternalWords, uint64_t generation, Topology topology = Topology::DeadBorder);
 	virtual ~Grid() = default;
-	Grid(const Grid & other) = default;
-	Grid(Grid && other) = default;
-	Grid& operator=(const Grid & other) = default;
-	Grid& operator=(Grid && other) = default;
-
-	int GetWidth();
-	int GetHeight();
-	int GetCellSize();
+	Grid(const Grid & other);
+	Grid(Grid && other);
+	Grid& operator=(const Grid & other);
+	Grid& operator=(Grid && other);
+
+	//Takes over the cells, generation and topology of the other grid.
+	//Reuses the own buffer when both grids have the same size, so handing frames between threads does not allocate.
+	void CopyFrom(const Grid& other);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetCellSize() const;
+	int GetWordsPerRow() const;
+	uint64_t GetLastWordMask() const;
+
+	//Switching topology counts as an edit
+	void SetTopology(Topology topology);
+	Topology GetTopology() const;
+
+	//Also valid for the halo, x in [-1, width] and y in [-1, height]
+	bool IsAlive(int x, int y) const;
+	//Only for cells of the grid itself, the halo is filled from the grid by FillHalo
+	void SetCell(int x, int y, bool alive);
 	void ToggleCell(int x, int y);
 	void ToggleCell(const glm::ivec2& position);
 	void ClearGrid();
-	const std::vector<Cell>& GetCells();
-	std::vector<Cell> GetCellsCopy();
+
+	//Counts edits made outside of stepping so incremental engines know their cached state is stale.
+	//SetCell, ToggleCell and ClearGrid bump it, code that writes through GetRow has to call MarkEdited.
+	//MarkEdited also counts as a change of every cell, see GetChangeMark.
+	uint64_t GetEditVersion() const;
+	void MarkEdited();
+
+	//Rows are stored as 64 cells per word, cell x lives in bit (x % 64) of word (x / 64).
+	//Bits past the width in the last word of a row are 0 outside of stepping.
+	//
+	//Around the cells lies a halo: one word left and right of every row and one row above and below the grid,
+	//so GetRow(-1) up to GetRow(height) and pRow[-1] up to pRow[wordsPerRow] can be read without any checks.
+	//Column -1 is bit 63 of pRow[-1] and column width is the first bit past the width.
+	//FillHalo copies the cells across the border into it at the start of every step, that is all a topology is.
+	const uint64_t* GetRow(int y) const;
+	uint64_t* GetRow(int y);
+	void FillHalo();
+
+	//Distance in words between two rows, and the whole current buffer including the halo
+	int GetStride() const;
+	const uint64_t* GetBuffer() const;
+	size_t GetBufferWordCount() const;
+
+	//The grid is double buffered: engines read the current generation through GetRow
+	//and write the next one into GetNextRow, SwapBuffers then makes it current without copying.
+	//A grid on external memory allocates its second buffer in the first BeginGeneration.
+	uint64_t* GetNextRow(int y);
+	void BeginGeneration();
+	void SwapBuffers();
+	uint64_t GetGeneration() const;
+	//After a step the back buffer still holds the generation before the current one (its halo is stale).
+	//Only meaningful when there was no edit since that step.
+	const uint64_t* GetPreviousRow(int y) const;
+	bool HasPreviousGeneration() const;
+	//Moves the generation counter without stepping, for patterns that are known to repeat
+	void SkipGenerations(uint64_t generations);
+	//Sets the generation counter, for cells that were put back to an earlier generation
+	void SetGeneration(uint64_t generation);
+
+	//Engines report any heap allocation or bulk copy they do while stepping
+	void RecordAllocation(size_t bytes);
+	void RecordCopy(size_t bytes);
+	const GenerationCounters& GetGenerationCounters() const;
+
+	//LifeEngine stores the statistics of every step it made. They stay current until the next edit or generation change,
+	//after that GetStatistics counts the population and bounding box itself in one pass, with births and deaths at 0.
+	void SetStatistics(const GenerationStatistics& statistics);
+	bool HasCurrentStatistics() const;
+	GenerationStatistics GetStatistics() const;
+
+	//Rows are split into chunks of 64 words for keeping track of changes
+	int GetChangeChunksPerRow() const;
+
+	//Words the last step changed, one bit per word: word w of row y changed when bit w % 64 of GetStepChanges(y)[w / 64] is set.
+	//LifeEngine records them right after stepping a row, while it is still in the cache, when SetRecordChanges is on.
+	//Like the statistics they stay current until the next edit or generation change.
+	void BeginRecordingChanges();
+	//Compares row y of the next generation with the current one, may be called from several threads for different rows
+	void RecordRowChanges(int y);
+	bool HasStepChanges() const;
+	const uint64_t* GetStepChanges(int y) const;
+
+	//Every change of the cells moves the grid along its change history, and every chunk remembers the last change that touched it.
+	//Code that shows the cells keeps the mark of what it last saw and only redoes the chunks that changed since,
+	//instead of keeping a copy of the cells to compare with. Copies and CopyFrom take the history along,
+	//so the frames a simulation thread hands out can be compared with the mark of an earlier frame.
+	//SetCell and ToggleCell change a single chunk, so does a step that recorded its changes.
+	//Anything else, like MarkEdited or a step that did not record, changes every chunk.
+	ChangeMark GetChangeMark() const;
+	//True for a mark of another history or when every chunk changed since the mark
+	bool IsEverythingChangedSince(const ChangeMark& mark) const;
+	bool IsChunkChangedSince(const ChangeMark& mark, int y, int chunk) const;
+
+	//Hash of the size and the alive cells, equal grids give equal hashes no matter how they got there
+	uint64_t ComputeHash() const;
+	uint64_t GetPopulation() const;
+
+	Cell GetCell(int x, int y) const;
+
+	//Calls func(x, y) for every alive cell, skipping empty words without touching their cells
+	template <typename Function>
+	void ForEachAliveCell(Function func) const;
 
 private:
 	int m_Width;
 	int m_Height;
 	int m_CellSize;
-	std::vector<Cell> m_Cells;
+	int m_WordsPerRow;
+	int m_Stride;
+	Topology m_Topology;
+	bool m_PaddingFilled;		//FillHalo put the east column into the padding bits, they are cleared again on swap
+	uint64_t m_Generation;
+	uint64_t m_EditVersion;
+	std::vector<uint64_t> m_Words;
+	std::vector<uint64_t> m_NextWords;
+	uint64_t* m_pWords;			//Current generation, points into one of the vectors or into external memory
+	uint64_t* m_pNextWords;
+	GenerationCounters m_GenerationCounters;
+	GenerationStatistics m_Statistics;
+	uint64_t m_StatisticsEditVersion;	//Edit version the statistics were stored at, they are stale once it moved on
+	bool m_HasStatistics;
+	std::vector<uint64_t> m_StepChanges;
+	uint64_t m_StepChangesEditVersion;
+	uint64_t m_StepChangesGeneration;
+	bool m_RecordingChanges;
+	bool m_HasStepChanges;
+	std::vector<uint64_t> m_ChunkChanges;	//Sequence of the last change of every chunk, GetChangeChunksPerRow per row
+	uint64_t m_ChangeLineage;
+	uint64_t m_ChangeSequence;
+	uint64_t m_EverythingChangedSequence;
+	bool m_OwnsLineage;		//Copies share the history of the original until they change on their own
+
+	uint64_t NextChangeSequence();
+	void MarkCellChanged(int x, int y);
 
 	void NegativeCheck(int& value);
+	void FillRowSides(uint64_t* pRow);
+	void ClearHalo(uint64_t* pWords);
+	void ClearPadding(uint64_t* pWords);
 };
 
 struct Cell
 {
 public:
 	explicit Cell(const glm::ivec2& position, int size, bool alive = false);
-	
+
 	glm::ivec2 position;
 	int size;
 	bool alive;
 };
 
+template <typename Function>
+void Grid::ForEachAliveCell(Function func) const
+{
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		const uint64_t* pRow = GetRow(y);
+		for (int w{ 0 }; w < m_WordsPerRow; w++)
+		{
+			//Pop the lowest set bit until the word is empty
+			uint64_t word = pRow[w];
+			while (word)
+			{
+				func(w * 64 + CountTrailingZeros64(word), y);
+				word &= word - 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,177 @@
+#include "ChangeTrackingEngine.h"
+#include "Cell.h"
+
+#include <algorithm>
+
+ChangeTrackingEngine::ChangeTrackingEngine()
+	: m_pLastGrid(nullptr)
+	, m_ExpectedGeneration(0)
+	, m_ExpectedEditVersion(0)
+	, m_FullPass(true)
+	, m_CurrentMap(0)
+	, m_MapWordsPerRow(0)
+	, m_WakeBorder(false)
+	, m_BorderChanged(false)
+	, m_EvaluatedWords(0)
+	, m_pStepWords(SelectStepWords<SwarOps>(m_Rule))
+{
+}
+
+const char* ChangeTrackingEngine::GetName() const
+{
+	return "change-tracking";
+}
+
+void ChangeTrackingEngine::SetRule(const Rule& rule)
+{
+	LifeEngine::SetRule(rule);
+	m_pStepWords = SelectStepWords<SwarOps>(rule);
+
+	//Words that were skipped under the old rule are not necessarily stable under the new one
+	m_pLastGrid = nullptr;
+}
+
+uint64_t ChangeTrackingEngine::GetEvaluatedCellCount() const
+{
+	return m_EvaluatedWords.load() * 64;
+}
+
+bool ChangeTrackingEngine::WasFullPass() const
+{
+	return m_FullPass;
+}
+
+void ChangeTrackingEngine::BeginStep(Grid& grid)
+{
+	int wordsPerRow = grid.GetWordsPerRow();
+	int mapWordsPerRow = (wordsPerRow + 63) / 64;
+	size_t mapSize = size_t(mapWordsPerRow) * grid.GetHeight();
+
+	//The skipped words are only valid if the back buffer still holds what this engine wrote last time
+	m_FullPass = m_pLastGrid != &grid
+		|| grid.GetGeneration() != m_ExpectedGeneration
+		|| grid.GetEditVersion() != m_ExpectedEditVersion
+		|| m_ChangedMaps[0].size() != mapSize
+		|| m_MapWordsPerRow != mapWordsPerRow;
+
+	if (m_ChangedMaps[0].size() != mapSize)
+	{
+		m_ChangedMaps[0].assign(mapSize, 0);
+		m_ChangedMaps[1].assign(mapSize, 0);
+		grid.RecordAllocation(2 * mapSize * sizeof(uint64_t));
+	}
+
+	//On a torus or Klein bottle a change at one border is a neighbour of the opposite border
+	m_WakeBorder = grid.GetTopology() != Topology::DeadBorder && m_BorderChanged.load();
+	m_BorderChanged = false;
+
+	m_MapWordsPerRow = mapWordsPerRow;
+	m_CurrentMap ^= 1;
+	m_EvaluatedWords = 0;
+
+	//Step swaps the buffers right after the rows are done, which is the state the next call expects
+	m_pLastGrid = &grid;
+	m_ExpectedGeneration = grid.GetGeneration() + 1;
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+void ChangeTrackingEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	int height = grid.GetHeight();
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	const uint64_t* pPrevious = m_ChangedMaps[m_CurrentMap ^ 1].data();
+	uint64_t* pCurrent = m_ChangedMaps[m_CurrentMap].data();
+
+	int lastMapWord = m_MapWordsPerRow - 1;
+	uint64_t lastWordBit = uint64_t(1) << ((wordsPerRow - 1) % 64);
+
+	uint64_t evaluatedWords = 0;
+	bool borderChanged = false;
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		const uint64_t* pAbove = grid.GetRow(y - 1);
+		const uint64_t* pRow = grid.GetRow(y);
+		const uint64_t* pBelow = grid.GetRow(y + 1);
+		uint64_t* pOut = grid.GetNextRow(y);
+		bool borderRow = y == 0 || y == height - 1;
+		uint64_t* pChanged = pCurrent + size_t(y) * m_MapWordsPerRow;
+
+		for (int mapWord{ 0 }; mapWord < m_MapWordsPerRow; mapWord++)
+		{
+			int remaining = wordsPerRow - mapWord * 64;
+			uint64_t validWords = remaining >= 64 ? ~uint64_t(0) : (uint64_t(1) << remaining) - 1;
+			uint64_t active = m_FullPass ? validWords : GetActiveWords(pPrevious, y, height, mapWord) & validWords;
+			if (m_WakeBorder)
+			{
+				uint64_t border = borderRow ? validWords : 0;
+				if (mapWord == 0)
+					border |= 1;
+				if (mapWord == lastMapWord)
+					border |= lastWordBit;
+				active |= border;
+			}
+
+			uint64_t changed = 0;
+			evaluatedWords += PopCount64(active);
+			while (active)
+			{
+				//Runs of active words go through the compiled kernel of the rule in one call
+				int firstBit = CountTrailingZeros64(active);
+				uint64_t run = active >> firstBit;
+				int length = ~run == 0 ? 64 : CountTrailingZeros64(~run);
+				int firstWord = mapWord * 64 + firstBit;
+				m_pStepWords(pAbove, pRow, pBelow, pOut, firstWord, firstWord + length, m_Rule);
+
+				for (int bit{ firstBit }; bit < firstBit + length; bit++)
+				{
+					//The padding bits of the current row may hold the halo column, they are not part of the grid
+					int word = mapWord * 64 + bit;
+					uint64_t next = pOut[word];
+					uint64_t current = pRow[word];
+					if (word == wordsPerRow - 1)
+					{
+						next &= lastWordMask;
+						current &= lastWordMask;
+						pOut[word] = next;
+					}
+
+					if (next != current)
+						changed |= uint64_t(1) << bit;
+				}
+
+				active = length == 64 ? 0 : active & ~(((uint64_t(1) << length) - 1) << firstBit);
+			}
+
+			pChanged[mapWord] = changed;
+			if (changed && (borderRow || (mapWord == 0 && (changed & 1)) || (mapWord == lastMapWord && (changed & lastWordBit))))
+				borderChanged = true;
+		}
+	}
+
+	m_EvaluatedWords += evaluatedWords;
+	if (borderChanged)
+		m_BorderChanged = true;
+}
+
+uint64_t ChangeTrackingEngine::GetActiveWords(const uint64_t* pPrevious, int y, int height, int mapWord) const
+{
+	//Changes in the rows above, at and below this one
+	auto Vertical = [this, pPrevious, y, height](int word) -> uint64_t
+	{
+		if (word < 0 || word >= m_MapWordsPerRow)
+			return 0;
+
+		uint64_t bits = pPrevious[size_t(y) * m_MapWordsPerRow + word];
+		if (y > 0)
+			bits |= pPrevious[size_t(y - 1) * m_MapWordsPerRow + word];
+		if (y < height - 1)
+			bits |= pPrevious[size_t(y + 1) * m_MapWordsPerRow + word];
+		return bits;
+	};
+
+	//Spread them one word to the left and right, carrying across map words
+	uint64_t bits = Vertical(mapWord);
+	return bits | (bits << 1) | (bits >> 1) | (Vertical(mapWord - 1) >> 63) | (Vertical(mapWord + 1) << 63);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "LifeEngine.h"
+#include "BitwiseKernel.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//Incremental engine that only re-evaluates the words (64 cells) next to words that changed in the previous generation.
+//Changes are kept in a bitmap with one bit per grid word, a word is evaluated when it or one of its 8 neighbouring words changed.
+//
+//Words that are skipped are already correct in the back buffer: it holds the generation before the current one,
+//and every word where that differs from the current generation changed and is therefore evaluated again.
+//That only holds while this engine did the previous step, after an edit or a step by someone else a full pass is done.
+//When the grid wraps around, a change anywhere on its border wakes up the whole border in the next generation.
+class ChangeTrackingEngine final : public LifeEngine
+{
+public:
+	ChangeTrackingEngine();
+	virtual ~ChangeTrackingEngine() = default;
+	ChangeTrackingEngine(const ChangeTrackingEngine& other) = delete;
+	ChangeTrackingEngine(ChangeTrackingEngine&& other) = delete;
+	ChangeTrackingEngine& operator=(const ChangeTrackingEngine& other) = delete;
+	ChangeTrackingEngine& operator=(ChangeTrackingEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+	virtual void SetRule(const Rule& rule) override;
+
+	//Number of cells that were evaluated in the last generation, counted in whole words of 64 cells
+	uint64_t GetEvaluatedCellCount() const;
+	bool WasFullPass() const;
+
+protected:
+	virtual void BeginStep(Grid& grid) override;
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+
+private:
+	const Grid* m_pLastGrid;
+	uint64_t m_ExpectedGeneration;
+	uint64_t m_ExpectedEditVersion;
+	bool m_FullPass;
+
+	//Changed word bitmaps of the previous and the current generation, each row padded to whole uint64_t's
+	std::vector<uint64_t> m_ChangedMaps[2];
+	int m_CurrentMap;
+	int m_MapWordsPerRow;
+
+	//Whether a border word changed in the last generation, and whether this generation has to evaluate the border for it
+	bool m_WakeBorder;
+	std::atomic<bool> m_BorderChanged;
+	std::atomic<uint64_t> m_EvaluatedWords;
+
+	//The SWAR kernel compiled for the rule, or the runtime one
+	StepWordsFunction m_pStepWords;
+
+	uint64_t GetActiveWords(const uint64_t* pPrevious, int y, int height, int mapWord) const;
+};
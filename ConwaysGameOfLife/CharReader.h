@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <string>
+
+//Hands out the characters of a stream from a fixed buffer, so big files are parsed without copying them line by line
+class CharReader final
+{
+public:
+	CharReader(std::istream& stream)
+		: m_Stream(stream)
+		, m_Position(0)
+		, m_Size(0)
+		, m_Line(1)
+	{
+	}
+	~CharReader() = default;
+	CharReader(const CharReader& other) = delete;
+	CharReader(CharReader&& other) = delete;
+	CharReader& operator=(const CharReader& other) = delete;
+	CharReader& operator=(CharReader&& other) = delete;
+
+	//Next character, or -1 at the end of the stream
+	int Get()
+	{
+		if (m_Position == m_Size && !Fill())
+			return -1;
+
+		char c = m_Buffer[m_Position++];
+		if (c == '\n')
+			++m_Line;
+		return (unsigned char)c;
+	}
+
+	void SkipLine()
+	{
+		int c = Get();
+		while (c != -1 && c != '\n')
+			c = Get();
+	}
+
+	//Only meant for short lines like headers and comments
+	void ReadLine(std::string& line)
+	{
+		line.clear();
+		for (int c = Get(); c != -1 && c != '\n'; c = Get())
+		{
+			if (c != '\r')
+				line.push_back(char(c));
+		}
+	}
+
+	size_t GetLine() const
+	{
+		return m_Line;
+	}
+
+private:
+	static const size_t BufferSize = 64 * 1024;
+
+	std::istream& m_Stream;
+	char m_Buffer[BufferSize];
+	size_t m_Position;
+	size_t m_Size;
+	size_t m_Line;
+
+	bool Fill()
+	{
+		m_Stream.read(m_Buffer, BufferSize);
+		m_Size = size_t(m_Stream.gcount());
+		m_Position = 0;
+		return m_Size != 0;
+	}
+};
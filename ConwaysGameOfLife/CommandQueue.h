@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+//Bounded queue from exactly one producer thread to exactly one consumer thread, without locks.
+//Each side only writes its own index, so pushing and popping are a load, a copy and a store.
+template <typename T>
+class CommandQueue final
+{
+public:
+	//The capacity is rounded up to a power of two
+	CommandQueue(size_t capacity);
+	~CommandQueue() = default;
+	CommandQueue(const CommandQueue& other) = delete;
+	CommandQueue(CommandQueue&& other) = delete;
+	CommandQueue& operator=(const CommandQueue& other) = delete;
+	CommandQueue& operator=(CommandQueue&& other) = delete;
+
+	//Producer side, returns false when the queue is full
+	bool TryPush(const T& value);
+	//Consumer side, returns false when the queue is empty
+	bool TryPop(T& value);
+
+private:
+	std::vector<T> m_Items;
+	size_t m_Mask;
+	std::atomic<size_t> m_Head;	//Next item to pop, only written by the consumer
+	std::atomic<size_t> m_Tail;	//Next item to push, only written by the producer
+};
+
+template <typename T>
+CommandQueue<T>::CommandQueue(size_t capacity)
+	: m_Mask(0)
+	, m_Head(0)
+	, m_Tail(0)
+{
+	size_t size = 1;
+	while (size < capacity)
+		size *= 2;
+
+	m_Items.resize(size);
+	m_Mask = size - 1;
+}
+
+template <typename T>
+bool CommandQueue<T>::TryPush(const T& value)
+{
+	//The indices only grow, the slot is the index modulo the size
+	size_t tail = m_Tail.load(std::memory_order_relaxed);
+	if (tail - m_Head.load(std::memory_order_acquire) == m_Items.size())
+		return false;
+
+	m_Items[tail & m_Mask] = value;
+	m_Tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+template <typename T>
+bool CommandQueue<T>::TryPop(T& value)
+{
+	size_t head = m_Head.load(std::memory_order_relaxed);
+	if (head == m_Tail.load(std::memory_order_acquire))
+		return false;
+
+	value = m_Items[head & m_Mask];
+	m_Head.store(head + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,94 @@
+#include "CpuFeatures.h"
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LIFE_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define LIFE_X86 0
+#endif
+
+#if LIFE_X86
+static void CpuId(int leaf, int subLeaf, uint32_t registers[4])
+{
+#if defined(_MSC_VER)
+	int values[4];
+	__cpuidex(values, leaf, subLeaf);
+	for (int i{ 0 }; i < 4; i++)
+		registers[i] = uint32_t(values[i]);
+#else
+	__cpuid_count(leaf, subLeaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+static uint64_t ReadXCR0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (uint64_t(edx) << 32) | eax;
+#endif
+}
+#endif
+
+bool CpuFeatures::HasAvx2()
+{
+	return Get().m_Avx2;
+}
+
+bool CpuFeatures::HasAvx512()
+{
+	return Get().m_Avx512;
+}
+
+bool CpuFeatures::HasPopcnt()
+{
+	return Get().m_Popcnt;
+}
+
+CpuFeatures::CpuFeatures()
+	: m_Avx2(false)
+	, m_Avx512(false)
+	, m_Popcnt(false)
+{
+#if LIFE_X86
+	uint32_t registers[4];
+	CpuId(0, 0, registers);
+	uint32_t maxLeaf = registers[0];
+	if (maxLeaf < 1)
+		return;
+
+	CpuId(1, 0, registers);
+	m_Popcnt = (registers[2] >> 23) & 1;
+	if (maxLeaf < 7)
+		return;
+
+	//The OS has to support XSAVE before we can ask it which register states it preserves
+	bool osxsave = (registers[2] >> 27) & 1;
+	bool avx = (registers[2] >> 28) & 1;
+	if (!osxsave || !avx)
+		return;
+
+	uint64_t xcr0 = ReadXCR0();
+	bool ymmEnabled = (xcr0 & 0x6) == 0x6;	//SSE and AVX state
+	bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;	//opmask, upper ZMM and high ZMM state as well
+
+	CpuId(7, 0, registers);
+	m_Avx2 = ymmEnabled && ((registers[1] >> 5) & 1);
+	m_Avx512 = zmmEnabled && ((registers[1] >> 16) & 1);
+#endif
+}
+
+const CpuFeatures& CpuFeatures::Get()
+{
+	//Detected once, the first time anyone asks
+	static CpuFeatures features;
+	return features;
+}
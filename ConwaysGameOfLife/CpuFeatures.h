@@ -0,0 +1,20 @@
+#pragma once
+
+//Runtime detection of the SIMD and bit counting instructions the Life kernels can use.
+//Checks both the CPU flags and whether the OS saves the wide registers on a context switch.
+class CpuFeatures final
+{
+public:
+	static bool HasAvx2();
+	static bool HasAvx512();
+	static bool HasPopcnt();
+
+private:
+	CpuFeatures();
+
+	bool m_Avx2;
+	bool m_Avx512;
+	bool m_Popcnt;
+
+	static const CpuFeatures& Get();
+};
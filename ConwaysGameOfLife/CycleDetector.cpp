@@ -0,0 +1,209 @@
+#include "CycleDetector.h"
+#include "Bits.h"
+#include "Cell.h"
+#include "GenerationsEngine.h"
+
+#include <algorithm>
+
+CycleDetector::CycleDetector(int historySize, int confirmations)
+	: m_History(size_t(std::max(historySize, 2)))
+	, m_Confirmations(std::max(confirmations, 1))
+{
+	Reset();
+}
+
+int CycleDetector::GetConfirmations(const LifeEngine& engine)
+{
+	//Generations rules keep dying cells outside of the grid, those repeat once the grid did for stateCount - 1 generations
+	const GenerationsEngine* pGenerations = dynamic_cast<const GenerationsEngine*>(&engine);
+	return pGenerations ? std::max(2, pGenerations->GetGenerationsRule().stateCount - 1) : 2;
+}
+
+void CycleDetector::Reset()
+{
+	m_HistoryCount = 0;
+	m_Next = 0;
+	m_pLastGrid = nullptr;
+	m_ExpectedGeneration = 0;
+	m_ExpectedEditVersion = 0;
+	m_Hash = 0;
+	m_HashedWords = 0;
+	m_CandidatePeriod = 0;
+	m_Matches = 0;
+	m_Period = 0;
+	m_CycleStart = 0;
+}
+
+bool CycleDetector::Update(const Grid& grid)
+{
+	//Diffing against the back buffer only works when it holds the generation we saw last time
+	bool incremental = m_pLastGrid == &grid
+		&& grid.GetGeneration() == m_ExpectedGeneration
+		&& grid.GetEditVersion() == m_ExpectedEditVersion
+		&& grid.HasPreviousGeneration();
+
+	if (incremental && grid.HasStepChanges())
+	{
+		UpdateStepChanges(grid);
+	}
+	else if (incremental)
+	{
+		UpdateChangedWords(grid);
+	}
+	else
+	{
+		Reset();
+		Rebuild(grid);
+	}
+
+	m_pLastGrid = &grid;
+	m_ExpectedGeneration = grid.GetGeneration() + 1;
+	m_ExpectedEditVersion = grid.GetEditVersion();
+
+	FindPeriod(grid.GetGeneration());
+	return IsCycleDetected();
+}
+
+bool CycleDetector::Update(uint64_t generation, uint64_t hash)
+{
+	if (m_pLastGrid != nullptr || generation != m_ExpectedGeneration)
+		Reset();
+
+	m_Hash = hash;
+	m_HashedWords = 0;
+	m_ExpectedGeneration = generation + 1;
+
+	FindPeriod(generation);
+	return IsCycleDetected();
+}
+
+bool CycleDetector::IsCycleDetected() const
+{
+	return m_Period != 0;
+}
+
+uint64_t CycleDetector::GetPeriod() const
+{
+	return m_Period;
+}
+
+uint64_t CycleDetector::GetCycleStart() const
+{
+	return m_CycleStart;
+}
+
+uint64_t CycleDetector::GetHash() const
+{
+	return m_Hash;
+}
+
+uint64_t CycleDetector::GetHashedWordCount() const
+{
+	return m_HashedWords;
+}
+
+uint64_t CycleDetector::FastForward(Grid& grid, uint64_t generations)
+{
+	if (m_Period == 0 || m_pLastGrid != &grid)
+		return generations;
+
+	//Every whole period ends in the state we are in now
+	uint64_t skipped = generations - generations % m_Period;
+	grid.SkipGenerations(skipped);
+	m_ExpectedGeneration += skipped;
+
+	//The history moves along, so the next update still finds the same period
+	for (Entry& entry : m_History)
+		entry.generation += skipped;
+
+	return generations - skipped;
+}
+
+void CycleDetector::Rebuild(const Grid& grid)
+{
+	m_Hash = 0;
+	size_t wordsPerRow = size_t(grid.GetWordsPerRow());
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		for (size_t w{ 0 }; w < wordsPerRow; w++)
+			m_Hash ^= HashWordAt(y * wordsPerRow + w, pRow[w]);
+	}
+
+	m_HashedWords = uint64_t(wordsPerRow) * grid.GetHeight();
+}
+
+void CycleDetector::UpdateStepChanges(const Grid& grid)
+{
+	//The engine marked the words it changed, only those are read from both generations
+	m_HashedWords = 0;
+	size_t wordsPerRow = size_t(grid.GetWordsPerRow());
+	int chunksPerRow = grid.GetChangeChunksPerRow();
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pChanges = grid.GetStepChanges(y);
+		for (int c{ 0 }; c < chunksPerRow; c++)
+		{
+			for (uint64_t bits{ pChanges[c] }; bits != 0; bits &= bits - 1)
+			{
+				size_t w = size_t(c) * 64 + CountTrailingZeros64(bits);
+				size_t index = y * wordsPerRow + w;
+				m_Hash ^= HashWordAt(index, grid.GetPreviousRow(y)[w]) ^ HashWordAt(index, grid.GetRow(y)[w]);
+				++m_HashedWords;
+			}
+		}
+	}
+}
+
+void CycleDetector::UpdateChangedWords(const Grid& grid)
+{
+	m_HashedWords = 0;
+	size_t wordsPerRow = size_t(grid.GetWordsPerRow());
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		const uint64_t* pPrevious = grid.GetPreviousRow(y);
+		for (size_t w{ 0 }; w < wordsPerRow; w++)
+		{
+			if (pRow[w] == pPrevious[w])
+				continue;
+
+			size_t index = y * wordsPerRow + w;
+			m_Hash ^= HashWordAt(index, pPrevious[w]) ^ HashWordAt(index, pRow[w]);
+			++m_HashedWords;
+		}
+	}
+}
+
+void CycleDetector::FindPeriod(uint64_t generation)
+{
+	//Smallest period whose hash matches, periods larger than the history can not be seen
+	uint64_t period = 0;
+	for (size_t i{ 1 }; i <= m_HistoryCount && period == 0; i++)
+	{
+		const Entry& entry = m_History[(m_Next + m_History.size() - i) % m_History.size()];
+		if (entry.hash == m_Hash && entry.generation < generation)
+			period = generation - entry.generation;
+	}
+
+	if (period != 0 && period == m_CandidatePeriod)
+	{
+		++m_Matches;
+	}
+	else
+	{
+		m_CandidatePeriod = period;
+		m_Matches = period != 0 ? 1 : 0;
+		m_Period = 0;
+	}
+
+	if (m_Matches >= m_Confirmations && m_Period == 0)
+	{
+		m_Period = period;
+		m_CycleStart = generation - period - uint64_t(m_Matches - 1);
+	}
+
+	m_History[m_Next] = Entry{ generation, m_Hash };
+	m_Next = (m_Next + 1) % m_History.size();
+	m_HistoryCount = std::min(m_HistoryCount + 1, m_History.size());
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Grid;
+class LifeEngine;
+
+//Notices when a grid starts repeating itself, like a soup that settled into still lifes and oscillators.
+//A hash of the grid is kept up to date from the words that changed since the previous generation,
+//and compared with a short history of earlier hashes to find the period.
+//The changed words come from the step itself when the engine records them (LifeEngine::SetRecordChanges),
+//so a settled grid costs as much as its oscillators. Without that every word is compared with the previous generation.
+class CycleDetector final
+{
+public:
+	//The longest period that can be found is historySize - 1.
+	//A period is only reported after it held for `confirmations` generations in a row, which rules out hash collisions
+	//and covers engines with state outside of the grid: Generations rules need at least their number of states - 1.
+	CycleDetector(int historySize = 64, int confirmations = 2);
+	~CycleDetector() = default;
+	CycleDetector(const CycleDetector& other) = delete;
+	CycleDetector(CycleDetector&& other) = delete;
+	CycleDetector& operator=(const CycleDetector& other) = delete;
+	CycleDetector& operator=(CycleDetector&& other) = delete;
+
+	//Confirmations a detector needs for the grids the engine steps: 2, or more for Generations rules that keep dying cells outside of the grid
+	static int GetConfirmations(const LifeEngine& engine);
+
+	void Reset();
+
+	//Call after every step. After an edit or when generations were missed the hash is rebuilt from scratch
+	//and the history starts over. Returns true while the grid is in a confirmed cycle.
+	bool Update(const Grid& grid);
+	//Same for cells that are not in a Grid, like a FixedGrid: pass the hash of every generation in order.
+	//Any hash works as long as equal cells give equal hashes, a generation that does not follow the last one starts over.
+	bool Update(uint64_t generation, uint64_t hash);
+
+	bool IsCycleDetected() const;
+	//Period of the cycle, 1 for a grid that no longer changes
+	uint64_t GetPeriod() const;
+	//First generation that was part of the cycle
+	uint64_t GetCycleStart() const;
+
+	uint64_t GetHash() const;
+	//Words hashed by the last update, all words after a rebuild and only the changed ones otherwise
+	uint64_t GetHashedWordCount() const;
+
+	//Skips every whole period of the generations that are left to run: moves the generation counter of the grid
+	//and returns how many generations still have to be stepped to end up in the same state.
+	uint64_t FastForward(Grid& grid, uint64_t generations);
+
+private:
+	struct Entry
+	{
+		uint64_t generation;
+		uint64_t hash;
+	};
+
+	std::vector<Entry> m_History;	//Ring buffer of the last generations
+	size_t m_HistoryCount;
+	size_t m_Next;
+	int m_Confirmations;
+
+	const Grid* m_pLastGrid;
+	uint64_t m_ExpectedGeneration;
+	uint64_t m_ExpectedEditVersion;
+	uint64_t m_Hash;
+	uint64_t m_HashedWords;
+
+	uint64_t m_CandidatePeriod;
+	int m_Matches;
+	uint64_t m_Period;
+	uint64_t m_CycleStart;
+
+	void Rebuild(const Grid& grid);
+	void UpdateStepChanges(const Grid& grid);
+	//Fallback for steps that did not record their changes, compares every word with the back buffer
+	void UpdateChangedWords(const Grid& grid);
+	void FindPeriod(uint64_t generation);
+};
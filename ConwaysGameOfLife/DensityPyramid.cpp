@@ -0,0 +1,241 @@
+#include "DensityPyramid.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <utility>
+
+DensityPyramid::DensityPyramid()
+	: m_pGrid(nullptr)
+	, m_Width(0)
+	, m_Height(0)
+	, m_Valid(false)
+	, m_UpdatedWords(0)
+{
+}
+
+void DensityPyramid::Update(const Grid& grid)
+{
+	bool rebuild = !m_Valid || grid.GetWidth() != m_Width || grid.GetHeight() != m_Height;
+	if (rebuild)
+		Resize(grid);
+
+	m_pGrid = &grid;
+	m_UpdatedWords = 0;
+	if (m_Levels.empty())
+	{
+		m_Mark = grid.GetChangeMark();
+		m_Valid = true;
+		return;
+	}
+
+	//A chunk of 64 words in a row is exactly one group of level 1
+	Level& pairs = m_Levels[0];
+	if (rebuild || grid.IsEverythingChangedSince(m_Mark))
+	{
+		std::fill(pairs.dirtyGroups.begin(), pairs.dirtyGroups.end(), uint8_t(1));
+	}
+	else
+	{
+		for (int y{ 0 }; y < m_Height; y++)
+		{
+			for (int chunk{ 0 }; chunk < pairs.groupsPerRow; chunk++)
+			{
+				if (grid.IsChunkChangedSince(m_Mark, y, chunk))
+					pairs.dirtyGroups[size_t(y / 2) * pairs.groupsPerRow + chunk] = 1;
+			}
+		}
+	}
+
+	//Every recounted group makes the group above it dirty, so each level only reads the level below where it changed
+	int levelCount = int(m_Levels.size());
+	for (int level{ 1 }; level <= levelCount; level++)
+	{
+		Level& counts = m_Levels[level - 1];
+		for (int y{ 0 }; y < counts.height; y++)
+		{
+			for (int group{ 0 }; group < counts.groupsPerRow; group++)
+			{
+				uint8_t& dirty = counts.dirtyGroups[size_t(y) * counts.groupsPerRow + group];
+				if (!dirty)
+					continue;
+
+				dirty = 0;
+				if (level == 1)
+					CountPairs(grid, y, group);
+				else
+					CountQuads(level, y, group);
+
+				if (level < levelCount)
+				{
+					Level& above = m_Levels[level];
+					int aboveGroup = int(group * counts.groupCells / above.groupCells);
+					above.dirtyGroups[size_t(y / 2) * above.groupsPerRow + aboveGroup] = 1;
+				}
+			}
+		}
+	}
+
+	m_Mark = grid.GetChangeMark();
+	m_Valid = true;
+}
+
+void DensityPyramid::Invalidate()
+{
+	m_Valid = false;
+}
+
+int DensityPyramid::GetWidth() const
+{
+	return m_Width;
+}
+
+int DensityPyramid::GetHeight() const
+{
+	return m_Height;
+}
+
+int DensityPyramid::GetLevelCount() const
+{
+	return int(m_Levels.size());
+}
+
+int DensityPyramid::GetLevelWidth(int level) const
+{
+	return level == 0 ? m_Width : m_Levels[level - 1].width;
+}
+
+int DensityPyramid::GetLevelHeight(int level) const
+{
+	return level == 0 ? m_Height : m_Levels[level - 1].height;
+}
+
+uint32_t DensityPyramid::GetPopulation(int level, int x, int y) const
+{
+	if (level < 0 || level > int(m_Levels.size()) || x < 0 || y < 0 || x >= GetLevelWidth(level) || y >= GetLevelHeight(level))
+		return 0;
+
+	if (level == 0)
+		return m_pGrid->IsAlive(x, y) ? 1 : 0;
+
+	const Level& counts = m_Levels[level - 1];
+	size_t index = size_t(y) * counts.width + x;
+	return level <= SmallLevels ? counts.smallCounts[index] : counts.largeCounts[index];
+}
+
+void DensityPyramid::GetRowPopulations(int level, int y, int firstX, int count, uint32_t* pPopulations) const
+{
+	std::fill(pPopulations, pPopulations + count, 0u);
+	if (level < 0 || level > int(m_Levels.size()) || y < 0 || y >= GetLevelHeight(level))
+		return;
+
+	int begin = std::max(0, -firstX);
+	int end = std::min(count, GetLevelWidth(level) - firstX);
+	if (level == 0)
+	{
+		const uint64_t* pRow = m_pGrid->GetRow(y);
+		for (int i{ begin }; i < end; i++)
+			pPopulations[i] = uint32_t((pRow[(firstX + i) / 64] >> ((firstX + i) % 64)) & 1);
+		return;
+	}
+
+	const Level& counts = m_Levels[level - 1];
+	size_t rowIndex = size_t(y) * counts.width + firstX;
+	if (level <= SmallLevels)
+		std::copy(counts.smallCounts.begin() + (rowIndex + begin), counts.smallCounts.begin() + (rowIndex + end), pPopulations + begin);
+	else
+		std::copy(counts.largeCounts.begin() + (rowIndex + begin), counts.largeCounts.begin() + (rowIndex + end), pPopulations + begin);
+}
+
+uint64_t DensityPyramid::GetUpdatedWordCount() const
+{
+	return m_UpdatedWords;
+}
+
+void DensityPyramid::Resize(const Grid& grid)
+{
+	m_Width = grid.GetWidth();
+	m_Height = grid.GetHeight();
+
+	//Halve the size until a single block is left
+	m_Levels.clear();
+	int width = m_Width;
+	int height = m_Height;
+	while (width > 1 || height > 1)
+	{
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+
+		Level counts{ width, height, {}, {}, 0, 0, {} };
+		if (int(m_Levels.size()) < SmallLevels)
+			counts.smallCounts.assign(size_t(width) * height, 0);
+		else
+			counts.largeCounts.assign(size_t(width) * height, 0);
+
+		counts.groupCells = std::max(int64_t(ChunkCells), int64_t(1) << (m_Levels.size() + 1));
+		counts.groupsPerRow = int((m_Width + counts.groupCells - 1) / counts.groupCells);
+		counts.dirtyGroups.assign(size_t(height) * counts.groupsPerRow, 0);
+		m_Levels.push_back(std::move(counts));
+	}
+}
+
+void DensityPyramid::CountPairs(const Grid& grid, int y, int group)
+{
+	//Level 1 is counted straight from the cells, two rows of them
+	const uint64_t* pTop = grid.GetRow(y * 2);
+	const uint64_t* pBottom = y * 2 + 1 < m_Height ? grid.GetRow(y * 2 + 1) : nullptr;
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	Level& counts = m_Levels[0];
+	uint8_t* pCounts = counts.smallCounts.data() + size_t(y) * counts.width;
+	const uint64_t pairBits = 0x5555555555555555ull;
+	const uint64_t quadBits = 0x3333333333333333ull;
+
+	int lastWord = std::min(wordsPerRow, (group + 1) * 64);
+	for (int w{ group * 64 }; w < lastWord; w++)
+	{
+		uint64_t top = pTop[w];
+		uint64_t bottom = pBottom ? pBottom[w] : 0;
+		if (w == wordsPerRow - 1)
+		{
+			top &= lastWordMask;
+			bottom &= lastWordMask;
+		}
+
+		//Two bit counts of every pair of cells in a row, then four bit counts of the even and the odd 2x2 blocks
+		uint64_t topPairs = (top & pairBits) + ((top >> 1) & pairBits);
+		uint64_t bottomPairs = (bottom & pairBits) + ((bottom >> 1) & pairBits);
+		uint64_t even = (topPairs & quadBits) + (bottomPairs & quadBits);
+		uint64_t odd = ((topPairs >> 2) & quadBits) + ((bottomPairs >> 2) & quadBits);
+
+		int firstBlock = w * 32;
+		int blockCount = std::min(32, counts.width - firstBlock);
+		for (int block{ 0 }; block < blockCount; block++)
+			pCounts[firstBlock + block] = uint8_t((((block & 1) ? odd : even) >> (block / 2 * 4)) & 15);
+	}
+
+	m_UpdatedWords += uint64_t(lastWord - group * 64) * (pBottom ? 2 : 1);
+}
+
+void DensityPyramid::CountQuads(int level, int y, int group)
+{
+	//Every level above the first adds up 2x2 blocks of the one below
+	Level& counts = m_Levels[level - 1];
+	int firstX = int((group * counts.groupCells) >> level);
+	int lastX = int(std::min(int64_t(counts.width), ((group + 1) * counts.groupCells) >> level));
+	for (int x{ firstX }; x < lastX; x++)
+	{
+		uint32_t sum = GetPopulation(level - 1, x * 2, y * 2) + GetPopulation(level - 1, x * 2 + 1, y * 2)
+			+ GetPopulation(level - 1, x * 2, y * 2 + 1) + GetPopulation(level - 1, x * 2 + 1, y * 2 + 1);
+		SetCount(level, size_t(y) * counts.width + x, sum);
+	}
+}
+
+void DensityPyramid::SetCount(int level, size_t index, uint32_t count)
+{
+	Level& counts = m_Levels[level - 1];
+	if (level <= SmallLevels)
+		counts.smallCounts[index] = uint8_t(count);
+	else
+		counts.largeCounts[index] = count;
+}
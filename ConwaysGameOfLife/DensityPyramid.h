@@ -0,0 +1,75 @@
+#pragma once
+#include "Cell.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Population counts of square blocks of cells at every power of two size, for drawing boards far larger than the window.
+//Level 1 counts 2x2 blocks, level 2 4x4 blocks and so on up to the level where one block covers the whole grid,
+//so a zoomed out view reads one count per pixel no matter how many cells that pixel covers.
+//The pyramid keeps no copy of the cells: Update asks the grid which chunks of 64 words changed since the last update
+//(Grid::GetChangeMark) and recounts the blocks above them, level by level. Level 0 reads the grid itself.
+class DensityPyramid final
+{
+public:
+	DensityPyramid();
+	~DensityPyramid() = default;
+	DensityPyramid(const DensityPyramid& other) = delete;
+	DensityPyramid(DensityPyramid&& other) = delete;
+	DensityPyramid& operator=(const DensityPyramid& other) = delete;
+	DensityPyramid& operator=(DensityPyramid&& other) = delete;
+
+	//Any grid can be passed, also another frame of the same size or one that skipped generations.
+	//The first call, a grid of another size or a call after Invalidate counts every block from scratch,
+	//so does a grid that can not tell what changed since the last update.
+	//The grid has to stay alive and unchanged for as long as level 0 is read.
+	void Update(const Grid& grid);
+	void Invalidate();
+
+	int GetWidth() const;
+	int GetHeight() const;
+	//Levels above the cells, the last one has a single block
+	int GetLevelCount() const;
+	int GetLevelWidth(int level) const;
+	int GetLevelHeight(int level) const;
+
+	//Alive cells in block (x, y) of the level, which covers (1 << level) x (1 << level) cells.
+	//Level 0 are the cells themselves. Blocks outside of the level count 0.
+	uint32_t GetPopulation(int level, int x, int y) const;
+	//GetPopulation of count blocks of one row starting at firstX, for drawing a whole row of pixels at once
+	void GetRowPopulations(int level, int y, int firstX, int count, uint32_t* pPopulations) const;
+
+	//Words recounted by the last Update: the chunks of 64 words that changed, all of them after a rebuild
+	uint64_t GetUpdatedWordCount() const;
+
+private:
+	//Counts up to 8x8 blocks fit in a byte, which keeps the fine levels at a third of a byte per cell together.
+	//Blocks are recounted in groups: a row of blocks over one chunk of cells, or a single block once it is wider than that.
+	struct Level
+	{
+		int width;
+		int height;
+		std::vector<uint8_t> smallCounts;
+		std::vector<uint32_t> largeCounts;
+		int64_t groupCells;
+		int groupsPerRow;
+		std::vector<uint8_t> dirtyGroups;
+	};
+
+	static const int SmallLevels = 3;
+	static const int ChunkCells = 64 * 64;
+
+	std::vector<Level> m_Levels;		//m_Levels[0] is level 1
+	const Grid* m_pGrid;
+	ChangeMark m_Mark;
+	int m_Width;
+	int m_Height;
+	bool m_Valid;
+	uint64_t m_UpdatedWords;
+
+	void Resize(const Grid& grid);
+	void CountPairs(const Grid& grid, int y, int group);
+	void CountQuads(int level, int y, int group);
+	void SetCount(int level, size_t index, uint32_t count);
+};
@@ -0,0 +1,45 @@
+#include "EngineFactory.h"
+#include "BitwiseEngine.h"
+#include "ChangeTrackingEngine.h"
+#include "GenerationsEngine.h"
+#include "LargerThanLifeEngine.h"
+#include "NeighbourCountEngine.h"
+#include "ScalarEngine.h"
+
+#include <stdexcept>
+
+std::vector<std::string> EngineFactory::GetEngineNames()
+{
+	return { "scalar", "bitwise", "bitwise-swar", "bitwise-avx2", "bitwise-avx512", "change-tracking", "neighbour-count", "generations", "larger-than-life" };
+}
+
+LifeEngine* EngineFactory::Create(const std::string& name, const std::string& rulestring)
+{
+	//Engines with their own rule notation parse the rule before they are created, so a bad rule leaks nothing
+	if (name == "generations")
+		return new GenerationsEngine{ rulestring.empty() ? GenerationsRule::BriansBrain() : GenerationsRule::Parse(rulestring) };
+
+	if (name == "larger-than-life")
+		return new LargerThanLifeEngine{ rulestring.empty() ? LargerThanLifeRule{} : LargerThanLifeRule::Parse(rulestring) };
+
+	Rule rule = rulestring.empty() ? Rule::Conway() : Rule::Parse(rulestring);
+
+	LifeEngine* pEngine = nullptr;
+	if (name == "scalar")
+		pEngine = new ScalarEngine{};
+	else if (name == "bitwise" || name == "bitwise-avx512")
+		pEngine = new BitwiseEngine{ InstructionSet::Avx512 };
+	else if (name == "bitwise-avx2")
+		pEngine = new BitwiseEngine{ InstructionSet::Avx2 };
+	else if (name == "bitwise-swar")
+		pEngine = new BitwiseEngine{ InstructionSet::Swar };
+	else if (name == "change-tracking")
+		pEngine = new ChangeTrackingEngine{};
+	else if (name == "neighbour-count")
+		pEngine = new NeighbourCountEngine{};
+	else
+		throw std::runtime_error{ "Unknown engine \"" + name + "\"" };
+
+	pEngine->SetRule(rule);
+	return pEngine;
+}
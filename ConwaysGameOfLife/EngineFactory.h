@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class LifeEngine;
+
+//Creates engines by name, so tools like the headless runner can pick one from the command line
+class EngineFactory final
+{
+public:
+	EngineFactory() = delete;
+
+	//Names accepted by Create, "bitwise" picks the widest instruction set the CPU supports
+	static std::vector<std::string> GetEngineNames();
+
+	//The rule string is parsed in the notation of the engine (B3/S23, B2/S/C3 or R5,C0,M1,S34..58,B34..45,NM),
+	//an empty string keeps the default rule of the engine.
+	//The caller owns the returned engine. Throws std::runtime_error for an unknown engine or an invalid rule.
+	static LifeEngine* Create(const std::string& name, const std::string& rulestring = "");
+};
@@ -0,0 +1,314 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include "Bits.h"
+#include "BitwiseKernel.h"
+#include "Cell.h"
+
+//Grid with its size fixed at compile time, for the tiny arenas of soup searches where millions of steps are run.
+//The cells live in two std::arrays inside the object, so nothing is allocated and every loop over a row has a constant length:
+//the compiler unrolls them and vectorizes the bit-sliced kernel across the words of a row.
+//The layout of a row is the same as in Grid. Only the rows above and below are kept as halo, the columns across the left and right
+//edge are shifted in while stepping.
+//
+//CopyFrom and CopyTo convert from and to a Grid of the same size, ComputeHash gives the same hash as Grid::ComputeHash.
+template <int Width, int Height>
+class FixedGrid final
+{
+public:
+	static_assert(Width > 0 && Height > 0, "A FixedGrid needs at least one cell");
+	static const int WordsPerRow = (Width + 63) / 64;
+
+	FixedGrid();
+	~FixedGrid() = default;
+	FixedGrid(const FixedGrid& other) = default;
+	FixedGrid(FixedGrid&& other) = default;
+	FixedGrid& operator=(const FixedGrid& other) = default;
+	FixedGrid& operator=(FixedGrid&& other) = default;
+
+	static constexpr int GetWidth() { return Width; }
+	static constexpr int GetHeight() { return Height; }
+	static constexpr int GetWordsPerRow() { return WordsPerRow; }
+	static constexpr uint64_t GetLastWordMask() { return Width % 64 == 0 ? ~uint64_t(0) : (uint64_t(1) << (Width % 64)) - 1; }
+
+	//Takes over the cells, generation and topology, throws std::runtime_error when the grid has another size
+	void CopyFrom(const Grid& grid);
+	//Writes the cells, generation and topology into a grid of the same size, which counts as an edit there.
+	//Throws std::runtime_error when the grid has another size.
+	void CopyTo(Grid& grid) const;
+
+	void SetTopology(Topology topology);
+	Topology GetTopology() const;
+
+	//Only valid inside the grid, x in [0, width) and y in [0, height)
+	bool IsAlive(int x, int y) const;
+	void SetCell(int x, int y, bool alive);
+	void ToggleCell(int x, int y);
+	void ClearGrid();
+
+	//Same layout as Grid::GetRow, bits past the width in the last word are always 0
+	const uint64_t* GetRow(int y) const;
+	uint64_t* GetRow(int y);
+
+	//Advances one generation. The rules in CompiledRuleKernels of BitwiseKernel.h are compiled for this size,
+	//any other rule goes through DynamicRule.
+	void Step(const Rule& rule);
+	template <typename RuleKernel>
+	void Step(const Rule& rule);
+	uint64_t GetGeneration() const;
+
+	uint64_t ComputeHash() const;
+	//Hash for CycleDetector that mixes every word on its own instead of in a chain, several times faster than ComputeHash.
+	//It is the hash CycleDetector keeps for a Grid with the same cells.
+	uint64_t ComputeCycleHash() const;
+	uint64_t GetPopulation() const;
+
+private:
+	//Every buffer has a row above and below the grid, which Step fills from the topology
+	using Words = std::array<uint64_t, size_t(WordsPerRow) * (Height + 2)>;
+
+	//Calls Step<RuleKernel> with the kernel SelectRuleKernel picked
+	struct StepSelector
+	{
+		using Result = void;
+
+		FixedGrid& grid;
+		const Rule& rule;
+
+		template <typename RuleKernel>
+		void Select() const
+		{
+			grid.template Step<RuleKernel>(rule);
+		}
+	};
+
+	Words m_Buffers[2];
+	int m_Current;
+	uint64_t m_Generation;
+	Topology m_Topology;
+
+	void FillHaloRows(uint64_t* pCells) const;
+	//Cell x - 1 and x + 1 moved into bit x of every word, the cells across the left and right edge are dead or wrap around
+	static void ShiftRow(const uint64_t* pRow, bool wraps, uint64_t* pWest, uint64_t* pEast);
+	static void CheckSize(const Grid& grid);
+};
+
+template <int Width, int Height>
+FixedGrid<Width, Height>::FixedGrid()
+	: m_Buffers{}
+	, m_Current(0)
+	, m_Generation(0)
+	, m_Topology(Topology::DeadBorder)
+{
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::CopyFrom(const Grid& grid)
+{
+	CheckSize(grid);
+	for (int y{ 0 }; y < Height; y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		uint64_t* pCells = GetRow(y);
+		for (int w{ 0 }; w < WordsPerRow; w++)
+			pCells[w] = w == WordsPerRow - 1 ? pRow[w] & GetLastWordMask() : pRow[w];
+	}
+
+	m_Generation = grid.GetGeneration();
+	m_Topology = grid.GetTopology();
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::CopyTo(Grid& grid) const
+{
+	CheckSize(grid);
+	for (int y{ 0 }; y < Height; y++)
+		std::copy(GetRow(y), GetRow(y) + WordsPerRow, grid.GetRow(y));
+
+	grid.SetTopology(m_Topology);
+	grid.SetGeneration(m_Generation);
+	grid.MarkEdited();
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::SetTopology(Topology topology)
+{
+	m_Topology = topology;
+}
+
+template <int Width, int Height>
+Topology FixedGrid<Width, Height>::GetTopology() const
+{
+	return m_Topology;
+}
+
+template <int Width, int Height>
+bool FixedGrid<Width, Height>::IsAlive(int x, int y) const
+{
+	return (GetRow(y)[x / 64] >> (x % 64)) & 1;
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::SetCell(int x, int y, bool alive)
+{
+	uint64_t bit = uint64_t(1) << (x % 64);
+	uint64_t& word = GetRow(y)[x / 64];
+
+	if (alive)
+		word |= bit;
+	else
+		word &= ~bit;
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::ToggleCell(int x, int y)
+{
+	GetRow(y)[x / 64] ^= uint64_t(1) << (x % 64);
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::ClearGrid()
+{
+	std::fill(GetRow(0), GetRow(0) + WordsPerRow * Height, uint64_t(0));
+}
+
+template <int Width, int Height>
+const uint64_t* FixedGrid<Width, Height>::GetRow(int y) const
+{
+	return m_Buffers[m_Current].data() + size_t(y + 1) * WordsPerRow;
+}
+
+template <int Width, int Height>
+uint64_t* FixedGrid<Width, Height>::GetRow(int y)
+{
+	return m_Buffers[m_Current].data() + size_t(y + 1) * WordsPerRow;
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::Step(const Rule& rule)
+{
+	StepSelector selector{ *this, rule };
+	SelectRuleKernel(rule, selector);
+}
+
+template <int Width, int Height>
+template <typename RuleKernel>
+void FixedGrid<Width, Height>::Step(const Rule& rule)
+{
+	uint64_t* pCells = m_Buffers[m_Current].data();
+	uint64_t* pNext = m_Buffers[m_Current ^ 1].data();
+	FillHaloRows(pCells);
+
+	//All rows are shifted in one pass first, after that every word of the grid is the same independent
+	//kernel on words at fixed distances, one loop the compiler can vectorize from the first word to the last
+	const int wordCount = WordsPerRow * Height;
+	Words west;
+	Words east;
+	bool wraps = m_Topology != Topology::DeadBorder;
+	for (int y{ 0 }; y < Height + 2; y++)
+		ShiftRow(pCells + y * WordsPerRow, wraps, west.data() + y * WordsPerRow, east.data() + y * WordsPerRow);
+
+	for (int i{ 0 }; i < wordCount; i++)
+	{
+		pNext[WordsPerRow + i] = NextGeneration<SwarOps, RuleKernel>(west[i], pCells[i], east[i],
+			west[WordsPerRow + i], pCells[WordsPerRow + i], east[WordsPerRow + i],
+			west[2 * WordsPerRow + i], pCells[2 * WordsPerRow + i], east[2 * WordsPerRow + i], rule);
+	}
+
+	if (GetLastWordMask() != ~uint64_t(0))
+	{
+		for (int y{ 1 }; y <= Height; y++)
+			pNext[y * WordsPerRow + WordsPerRow - 1] &= GetLastWordMask();
+	}
+
+	m_Current ^= 1;
+	++m_Generation;
+}
+
+template <int Width, int Height>
+uint64_t FixedGrid<Width, Height>::GetGeneration() const
+{
+	return m_Generation;
+}
+
+template <int Width, int Height>
+uint64_t FixedGrid<Width, Height>::ComputeHash() const
+{
+	//The hash of Grid::ComputeHash, so a FixedGrid and a Grid with the same cells can be compared
+	uint64_t hash = BeginGridHash(Width, Height);
+	for (int y{ 0 }; y < Height; y++)
+		hash = HashWords(hash, GetRow(y), WordsPerRow);
+
+	return hash;
+}
+
+template <int Width, int Height>
+uint64_t FixedGrid<Width, Height>::ComputeCycleHash() const
+{
+	//The words are stored without padding between the rows, so the index of a word is the same as in CycleDetector
+	const uint64_t* pCells = GetRow(0);
+	uint64_t hash = 0;
+	for (int i{ 0 }; i < WordsPerRow * Height; i++)
+		hash ^= HashWordAt(size_t(i), pCells[i]);
+
+	return hash;
+}
+
+template <int Width, int Height>
+uint64_t FixedGrid<Width, Height>::GetPopulation() const
+{
+	uint64_t population = 0;
+	const uint64_t* pCells = GetRow(0);
+	for (int i{ 0 }; i < WordsPerRow * Height; i++)
+		population += PopCount64(pCells[i]);
+	return population;
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::FillHaloRows(uint64_t* pCells) const
+{
+	uint64_t* pTop = pCells;
+	uint64_t* pFirst = pCells + WordsPerRow;
+	uint64_t* pLast = pCells + Height * WordsPerRow;
+	uint64_t* pBottom = pCells + (Height + 1) * WordsPerRow;
+	if (m_Topology == Topology::DeadBorder)
+	{
+		std::fill(pTop, pTop + WordsPerRow, uint64_t(0));
+		std::fill(pBottom, pBottom + WordsPerRow, uint64_t(0));
+	}
+	else if (m_Topology == Topology::Torus)
+	{
+		std::copy(pLast, pLast + WordsPerRow, pTop);
+		std::copy(pFirst, pFirst + WordsPerRow, pBottom);
+	}
+	else
+	{
+		MirrorRow(pLast, pTop, Width);
+		MirrorRow(pFirst, pBottom, Width);
+	}
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::ShiftRow(const uint64_t* pRow, bool wraps, uint64_t* pWest, uint64_t* pEast)
+{
+	const int lastBit = (Width - 1) % 64;
+	uint64_t lastCell = wraps ? (pRow[WordsPerRow - 1] >> lastBit) & 1 : 0;
+	uint64_t firstCell = wraps ? pRow[0] & 1 : 0;
+
+	for (int w{ 0 }; w < WordsPerRow; w++)
+	{
+		pWest[w] = (pRow[w] << 1) | (w > 0 ? pRow[w - 1] >> 63 : lastCell);
+		pEast[w] = (pRow[w] >> 1) | (w + 1 < WordsPerRow ? pRow[w + 1] << 63 : firstCell << lastBit);
+	}
+}
+
+template <int Width, int Height>
+void FixedGrid<Width, Height>::CheckSize(const Grid& grid)
+{
+	if (grid.GetWidth() != Width || grid.GetHeight() != Height)
+		throw std::runtime_error{ "A " + std::to_string(grid.GetWidth()) + "x" + std::to_string(grid.GetHeight())
+			+ " grid does not match a FixedGrid of " + std::to_string(Width) + "x" + std::to_string(Height) };
+}
@@ -0,0 +1,280 @@
+#include "GenerationHistory.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+//A delta is a list of runs: a header word with the number of unchanged words to skip in the high half
+//and the number of XOR words that follow it in the low half
+static const uint64_t MaxRunLength = 0xFFFFFFFF;
+
+GenerationHistory::GenerationHistory(size_t memoryBudget, int keyframeInterval)
+	: m_MemoryBudget(memoryBudget)
+	, m_MemoryUsage(0)
+	, m_KeyframeInterval(std::max(1, keyframeInterval))
+	, m_Width(0)
+	, m_Height(0)
+	, m_pLastGrid(nullptr)
+	, m_Cursor(0)
+	, m_ExpectedEditVersion(0)
+{
+}
+
+void GenerationHistory::Clear()
+{
+	m_Frames.clear();
+	m_MemoryUsage = 0;
+	m_pLastGrid = nullptr;
+	m_Cursor = 0;
+}
+
+void GenerationHistory::Record(const Grid& grid)
+{
+	if (grid.GetWidth() != m_Width || grid.GetHeight() != m_Height)
+	{
+		Clear();
+		m_Width = grid.GetWidth();
+		m_Height = grid.GetHeight();
+	}
+
+	if (IsAtCursor(grid))
+		return;
+
+	//The delta can be taken from the back buffer when the grid was stepped once from the generation at the cursor
+	bool continuous = m_pLastGrid == &grid
+		&& grid.GetEditVersion() == m_ExpectedEditVersion
+		&& grid.HasPreviousGeneration()
+		&& grid.GetGeneration() == m_Frames[m_Cursor].generation + 1;
+
+	while (!m_Frames.empty() && m_Frames.back().generation >= grid.GetGeneration())
+	{
+		m_MemoryUsage -= GetFrameBytes(m_Frames.back());
+		m_Frames.pop_back();
+	}
+
+	m_Frames.push_back(Frame{});
+	Frame& frame = m_Frames.back();
+	frame.generation = grid.GetGeneration();
+	frame.hasDelta = continuous;
+	if (continuous)
+	{
+		EncodeDelta(grid);
+		frame.delta.assign(m_Scratch.begin(), m_Scratch.end());
+	}
+
+	//Frames since the last keyframe, a frame without a delta always is one
+	size_t sinceKeyframe{ 0 };
+	for (size_t i{ m_Frames.size() - 1 }; i > 0 && m_Frames[i - 1].keyframe.empty(); i--)
+		++sinceKeyframe;
+	if (!continuous || m_Frames.size() == 1 || sinceKeyframe + 1 >= size_t(m_KeyframeInterval))
+		StoreKeyframe(grid, frame.keyframe);
+
+	m_MemoryUsage += GetFrameBytes(frame);
+	DropOldest();
+
+	m_pLastGrid = &grid;
+	m_Cursor = m_Frames.size() - 1;
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+bool GenerationHistory::IsEmpty() const
+{
+	return m_Frames.empty();
+}
+
+bool GenerationHistory::Contains(uint64_t generation) const
+{
+	return FindFrame(generation) != m_Frames.size();
+}
+
+uint64_t GenerationHistory::GetOldestGeneration() const
+{
+	return m_Frames.empty() ? 0 : m_Frames.front().generation;
+}
+
+uint64_t GenerationHistory::GetNewestGeneration() const
+{
+	return m_Frames.empty() ? 0 : m_Frames.back().generation;
+}
+
+size_t GenerationHistory::GetGenerationCount() const
+{
+	return m_Frames.size();
+}
+
+size_t GenerationHistory::GetMemoryUsage() const
+{
+	return m_MemoryUsage;
+}
+
+void GenerationHistory::Rewind(Grid& grid, uint64_t generation)
+{
+	size_t target = FindFrame(generation);
+	if (target == m_Frames.size())
+		throw std::runtime_error{ "Generation " + std::to_string(generation) + " is not in the history" };
+	if (grid.GetWidth() != m_Width || grid.GetHeight() != m_Height)
+		throw std::runtime_error{ "The history was recorded for a grid of another size" };
+
+	//Replaying from the keyframe at or before the target is always possible, frames without a delta are keyframes themselves
+	size_t keyframe = target;
+	while (m_Frames[keyframe].keyframe.empty())
+		--keyframe;
+	size_t keyframeCost = m_Frames[keyframe].keyframe.size();
+	for (size_t i{ keyframe + 1 }; i <= target; i++)
+		keyframeCost += m_Frames[i].delta.size();
+
+	//Walking from the generation the grid holds only works without an edit or a gap in between
+	bool fromCursor = IsAtCursor(grid);
+	size_t first = std::min(target, m_Cursor) + 1;
+	size_t last = std::max(target, m_Cursor);
+	size_t cursorCost{ 0 };
+	for (size_t i{ first }; fromCursor && i <= last; i++)
+	{
+		fromCursor = m_Frames[i].hasDelta;
+		cursorCost += m_Frames[i].delta.size();
+	}
+
+	if (fromCursor && cursorCost <= keyframeCost)
+	{
+		//Deltas work both ways, so rewinding and going forward again apply the same frames
+		for (size_t i{ first }; i <= last; i++)
+			ApplyDelta(grid, m_Frames[i].delta);
+	}
+	else
+	{
+		LoadKeyframe(grid, m_Frames[keyframe].keyframe);
+		for (size_t i{ keyframe + 1 }; i <= target; i++)
+			ApplyDelta(grid, m_Frames[i].delta);
+	}
+
+	grid.SetGeneration(generation);
+	grid.MarkEdited();
+
+	m_pLastGrid = &grid;
+	m_Cursor = target;
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+bool GenerationHistory::IsAtCursor(const Grid& grid) const
+{
+	return m_pLastGrid == &grid
+		&& grid.GetEditVersion() == m_ExpectedEditVersion
+		&& m_Cursor < m_Frames.size()
+		&& grid.GetGeneration() == m_Frames[m_Cursor].generation;
+}
+
+size_t GenerationHistory::FindFrame(uint64_t generation) const
+{
+	//Generations only grow from front to back, but they can have gaps where generations were skipped
+	auto it = std::lower_bound(m_Frames.begin(), m_Frames.end(), generation,
+		[](const Frame& frame, uint64_t value) { return frame.generation < value; });
+	if (it == m_Frames.end() || it->generation != generation)
+		return m_Frames.size();
+
+	return size_t(it - m_Frames.begin());
+}
+
+size_t GenerationHistory::GetFrameBytes(const Frame& frame) const
+{
+	return sizeof(Frame) + (frame.delta.capacity() + frame.keyframe.capacity()) * sizeof(uint64_t);
+}
+
+void GenerationHistory::DropOldest()
+{
+	while (m_MemoryUsage > m_MemoryBudget)
+	{
+		//The newest keyframe and the deltas after it are always kept
+		size_t next{ 1 };
+		while (next < m_Frames.size() && m_Frames[next].keyframe.empty())
+			++next;
+		if (next == m_Frames.size())
+			return;
+
+		for (size_t i{ 0 }; i < next; i++)
+		{
+			m_MemoryUsage -= GetFrameBytes(m_Frames.front());
+			m_Frames.pop_front();
+		}
+		m_Cursor -= std::min(m_Cursor, next);
+
+		//Nothing is left to apply the delta of the new oldest frame to
+		Frame& oldest = m_Frames.front();
+		m_MemoryUsage -= GetFrameBytes(oldest);
+		std::vector<uint64_t>{}.swap(oldest.delta);
+		oldest.hasDelta = false;
+		m_MemoryUsage += GetFrameBytes(oldest);
+	}
+}
+
+void GenerationHistory::EncodeDelta(const Grid& grid)
+{
+	m_Scratch.clear();
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+	uint64_t skipped{ 0 };
+	size_t header{ 0 };
+	bool inRun = false;
+
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		const uint64_t* pPrevious = grid.GetPreviousRow(y);
+		for (int w{ 0 }; w < wordsPerRow; w++)
+		{
+			uint64_t changed = pRow[w] ^ pPrevious[w];
+			if (w == wordsPerRow - 1)
+				changed &= lastWordMask;
+
+			if (changed == 0)
+			{
+				inRun = false;
+				if (++skipped == MaxRunLength)
+				{
+					m_Scratch.push_back(skipped << 32);
+					skipped = 0;
+				}
+				continue;
+			}
+
+			if (!inRun || (m_Scratch[header] & MaxRunLength) == MaxRunLength)
+			{
+				header = m_Scratch.size();
+				m_Scratch.push_back(skipped << 32);
+				skipped = 0;
+				inRun = true;
+			}
+			++m_Scratch[header];
+			m_Scratch.push_back(changed);
+		}
+	}
+}
+
+void GenerationHistory::ApplyDelta(Grid& grid, const std::vector<uint64_t>& delta)
+{
+	size_t wordsPerRow = size_t(grid.GetWordsPerRow());
+	size_t index{ 0 };
+	size_t position{ 0 };
+	while (position < delta.size())
+	{
+		uint64_t header = delta[position++];
+		index += size_t(header >> 32);
+		for (uint64_t i{ 0 }; i < (header & MaxRunLength); i++, index++)
+			grid.GetRow(int(index / wordsPerRow))[index % wordsPerRow] ^= delta[position++];
+	}
+}
+
+void GenerationHistory::StoreKeyframe(const Grid& grid, std::vector<uint64_t>& words)
+{
+	int wordsPerRow = grid.GetWordsPerRow();
+	words.resize(size_t(wordsPerRow) * grid.GetHeight());
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+		std::copy(grid.GetRow(y), grid.GetRow(y) + wordsPerRow, words.begin() + size_t(y) * wordsPerRow);
+}
+
+void GenerationHistory::LoadKeyframe(Grid& grid, const std::vector<uint64_t>& words)
+{
+	int wordsPerRow = grid.GetWordsPerRow();
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+		std::copy(words.begin() + size_t(y) * wordsPerRow, words.begin() + size_t(y + 1) * wordsPerRow, grid.GetRow(y));
+}
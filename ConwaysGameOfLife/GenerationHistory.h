@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class Grid;
+
+//Remembers earlier generations of a grid, so it can be rewound and stepped forward again without recomputing anything.
+//Every generation is stored as the XOR of its words with those of the generation before it, run-length encoded
+//so the words that did not change cost nothing. Every keyframeInterval generations, and after every edit,
+//all words of the grid are stored as well as a keyframe to replay the deltas from.
+//Once everything together takes more memory than the budget, the oldest keyframe and the deltas up to the next one are dropped.
+class GenerationHistory final
+{
+public:
+	GenerationHistory(size_t memoryBudget = size_t(64) << 20, int keyframeInterval = 64);
+	~GenerationHistory() = default;
+	GenerationHistory(const GenerationHistory& other) = delete;
+	GenerationHistory(GenerationHistory&& other) = delete;
+	GenerationHistory& operator=(const GenerationHistory& other) = delete;
+	GenerationHistory& operator=(GenerationHistory&& other) = delete;
+
+	void Clear();
+
+	//Call before and after every step. Records the generation the grid holds unless it already is the current one.
+	//Generations after it that were kept from before a rewind or edit are dropped, they are not the future of this grid anymore.
+	void Record(const Grid& grid);
+
+	bool IsEmpty() const;
+	bool Contains(uint64_t generation) const;
+	uint64_t GetOldestGeneration() const;
+	uint64_t GetNewestGeneration() const;
+	size_t GetGenerationCount() const;
+	size_t GetMemoryUsage() const;
+
+	//Puts the cells and generation counter of a recorded generation back into the grid, which counts as an edit.
+	//Only the deltas between the generation the grid holds and the target are applied, or those after the closest
+	//keyframe when that is less work. The topology stays as it is, and so does state engines keep outside of the grid.
+	//Throws std::runtime_error when the generation is not in the history or the grid has another size.
+	void Rewind(Grid& grid, uint64_t generation);
+
+private:
+	struct Frame
+	{
+		uint64_t generation;
+		std::vector<uint64_t> delta;		//Runs of XORed words against the frame before, empty for a change-less generation
+		std::vector<uint64_t> keyframe;		//All words of the grid, only for keyframes
+		bool hasDelta;						//False when the frame before is not the generation before, e.g. after an edit
+	};
+
+	std::deque<Frame> m_Frames;
+	std::vector<uint64_t> m_Scratch;
+	size_t m_MemoryBudget;
+	size_t m_MemoryUsage;
+	int m_KeyframeInterval;
+	int m_Width;
+	int m_Height;
+
+	//The frame the grid held at the last Record or Rewind
+	const Grid* m_pLastGrid;
+	size_t m_Cursor;
+	uint64_t m_ExpectedEditVersion;
+
+	bool IsAtCursor(const Grid& grid) const;
+	size_t FindFrame(uint64_t generation) const;
+	size_t GetFrameBytes(const Frame& frame) const;
+	void DropOldest();
+
+	void EncodeDelta(const Grid& grid);
+	static void ApplyDelta(Grid& grid, const std::vector<uint64_t>& delta);
+	static void StoreKeyframe(const Grid& grid, std::vector<uint64_t>& words);
+	static void LoadKeyframe(Grid& grid, const std::vector<uint64_t>& words);
+};
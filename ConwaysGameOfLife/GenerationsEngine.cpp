@@ -0,0 +1,195 @@
+#include "GenerationsEngine.h"
+#include "CpuFeatures.h"
+#include "Cell.h"
+
+#include <algorithm>
+
+GenerationsEngine::GenerationsEngine(const GenerationsRule& rule, InstructionSet maxInstructionSet)
+	: m_GenerationsRule(rule)
+	, m_InstructionSet(InstructionSet::Swar)
+	, m_pStepWords(&StepGenerationsWords<SwarOps>)
+	, m_PlaneCount(0)
+	, m_FrontPlanes(0)
+	, m_pLastGrid(nullptr)
+	, m_ExpectedGeneration(0)
+	, m_ExpectedEditVersion(0)
+{
+	//Pick the widest kernel that is allowed and that this CPU can actually run
+	if (maxInstructionSet == InstructionSet::Avx512 && CpuFeatures::HasAvx512())
+	{
+		m_InstructionSet = InstructionSet::Avx512;
+		m_pStepWords = &StepGenerationsWordsAvx512;
+	}
+	else if (maxInstructionSet != InstructionSet::Swar && CpuFeatures::HasAvx2())
+	{
+		m_InstructionSet = InstructionSet::Avx2;
+		m_pStepWords = &StepGenerationsWordsAvx2;
+	}
+
+	SetGenerationsRule(rule);
+}
+
+const char* GenerationsEngine::GetName() const
+{
+	return "generations";
+}
+
+std::string GenerationsEngine::GetRuleString() const
+{
+	return m_GenerationsRule.ToString();
+}
+
+void GenerationsEngine::SetRule(const Rule& rule)
+{
+	//A plain Life-like rule keeps the current number of states
+	GenerationsRule generationsRule = m_GenerationsRule;
+	generationsRule.rule = rule;
+	SetGenerationsRule(generationsRule);
+}
+
+void GenerationsEngine::SetGenerationsRule(const GenerationsRule& rule)
+{
+	LifeEngine::SetRule(rule.rule);
+	m_GenerationsRule = rule;
+
+	//Enough planes to count up to the last dying state
+	m_PlaneCount = 0;
+	while ((1 << m_PlaneCount) <= rule.stateCount - 2)
+		++m_PlaneCount;
+
+	//The old dying states do not mean anything under the new rule
+	m_pLastGrid = nullptr;
+}
+
+const GenerationsRule& GenerationsEngine::GetGenerationsRule() const
+{
+	return m_GenerationsRule;
+}
+
+InstructionSet GenerationsEngine::GetInstructionSet() const
+{
+	return m_InstructionSet;
+}
+
+int GenerationsEngine::GetState(const Grid& grid, int x, int y) const
+{
+	if (grid.IsAlive(x, y))
+		return 1;
+
+	if (m_pLastGrid != &grid)
+		return 0;
+
+	int counter = 0;
+	for (int plane{ 0 }; plane < m_PlaneCount; plane++)
+		counter |= int((GetPlaneRow(m_FrontPlanes, grid, plane, y)[x / 64] >> (x % 64)) & 1) << plane;
+
+	return counter == 0 ? 0 : counter + 1;
+}
+
+void GenerationsEngine::SetState(Grid& grid, int x, int y, int state)
+{
+	ResizePlanes(grid);
+
+	int counter = state >= 2 ? state - 1 : 0;
+	uint64_t bit = uint64_t(1) << (x % 64);
+	for (int plane{ 0 }; plane < m_PlaneCount; plane++)
+	{
+		uint64_t& word = GetPlaneRow(m_FrontPlanes, grid, plane, y)[x / 64];
+		if ((counter >> plane) & 1)
+			word |= bit;
+		else
+			word &= ~bit;
+	}
+
+	grid.SetCell(x, y, state == 1);
+}
+
+void GenerationsEngine::BeginStep(Grid& grid)
+{
+	bool edited = grid.GetGeneration() != m_ExpectedGeneration || grid.GetEditVersion() != m_ExpectedEditVersion;
+	ResizePlanes(grid);
+
+	//Cells that were made alive from outside might still have a dying counter
+	if (edited)
+		ClearDyingUnderAlive(grid);
+}
+
+void GenerationsEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		//Only the alive plane needs neighbours, and those come from the halo of the grid at the edges.
+		//The dying planes are read one word at a time and have no halo.
+		GenerationsRows rows{};
+		rows.pAbove = grid.GetRow(y - 1);
+		rows.pRow = grid.GetRow(y);
+		rows.pBelow = grid.GetRow(y + 1);
+		rows.pOut = grid.GetNextRow(y);
+		rows.planeCount = m_PlaneCount;
+		for (int plane{ 0 }; plane < m_PlaneCount; plane++)
+		{
+			rows.pDying[plane] = GetPlaneRow(m_FrontPlanes, grid, plane, y);
+			rows.pDyingOut[plane] = GetPlaneRow(m_FrontPlanes ^ 1, grid, plane, y);
+		}
+
+		//Same split as the binary engine: the vector kernel for as much as it can, SWAR for the rest
+		int word = m_pStepWords(rows, 0, wordsPerRow, m_GenerationsRule);
+		StepGenerationsWords<SwarOps>(rows, word, wordsPerRow, m_GenerationsRule);
+
+		//Cells past the width of the grid have to stay dead, in every plane
+		rows.pOut[wordsPerRow - 1] &= lastWordMask;
+		for (int plane{ 0 }; plane < m_PlaneCount; plane++)
+			rows.pDyingOut[plane][wordsPerRow - 1] &= lastWordMask;
+	}
+}
+
+void GenerationsEngine::EndStep(Grid& grid)
+{
+	//The grid already swapped its alive plane, swap the dying planes along with it
+	m_FrontPlanes ^= 1;
+	m_ExpectedGeneration = grid.GetGeneration();
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+void GenerationsEngine::ResizePlanes(Grid& grid)
+{
+	size_t planeSize = size_t(m_PlaneCount) * grid.GetHeight() * grid.GetWordsPerRow();
+	if (m_pLastGrid == &grid && m_Planes[0].size() == planeSize)
+		return;
+
+	//A different grid or rule, start without any dying cells
+	m_Planes[0].assign(planeSize, 0);
+	m_Planes[1].assign(planeSize, 0);
+	grid.RecordAllocation(2 * planeSize * sizeof(uint64_t));
+
+	m_pLastGrid = &grid;
+	m_ExpectedGeneration = grid.GetGeneration();
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+void GenerationsEngine::ClearDyingUnderAlive(const Grid& grid)
+{
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pAlive = grid.GetRow(y);
+		for (int plane{ 0 }; plane < m_PlaneCount; plane++)
+		{
+			uint64_t* pDying = GetPlaneRow(m_FrontPlanes, grid, plane, y);
+			for (int w{ 0 }; w < grid.GetWordsPerRow(); w++)
+				pDying[w] &= ~pAlive[w];
+		}
+	}
+}
+
+const uint64_t* GenerationsEngine::GetPlaneRow(int buffer, const Grid& grid, int plane, int y) const
+{
+	return m_Planes[buffer].data() + (size_t(plane) * grid.GetHeight() + y) * grid.GetWordsPerRow();
+}
+
+uint64_t* GenerationsEngine::GetPlaneRow(int buffer, const Grid& grid, int plane, int y)
+{
+	return m_Planes[buffer].data() + (size_t(plane) * grid.GetHeight() + y) * grid.GetWordsPerRow();
+}
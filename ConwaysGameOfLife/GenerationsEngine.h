@@ -0,0 +1,59 @@
+#pragma once
+#include "LifeEngine.h"
+#include "BitwiseEngine.h"
+#include "BitwiseKernel.h"
+#include <cstdint>
+#include <vector>
+
+//Engine for Generations rules (Brian's Brain B2/S/C3, Star Wars B2/S345/C4, ...).
+//The Grid holds the alive cells, so renderers and other tools keep working on it unchanged.
+//The dying states are kept by the engine as extra bit planes, log2(stateCount - 1) of them,
+//and are stepped with the same bit-sliced kernel as the alive plane.
+class GenerationsEngine final : public LifeEngine
+{
+public:
+	GenerationsEngine(const GenerationsRule& rule = GenerationsRule::BriansBrain(), InstructionSet maxInstructionSet = InstructionSet::Avx512);
+	virtual ~GenerationsEngine() = default;
+	GenerationsEngine(const GenerationsEngine& other) = delete;
+	GenerationsEngine(GenerationsEngine&& other) = delete;
+	GenerationsEngine& operator=(const GenerationsEngine& other) = delete;
+	GenerationsEngine& operator=(GenerationsEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+	virtual void SetRule(const Rule& rule) override;
+	virtual std::string GetRuleString() const override;
+
+	void SetGenerationsRule(const GenerationsRule& rule);
+	const GenerationsRule& GetGenerationsRule() const;
+	InstructionSet GetInstructionSet() const;
+
+	//0 is dead, 1 is alive and 2 up to the state count are the dying states
+	int GetState(const Grid& grid, int x, int y) const;
+	void SetState(Grid& grid, int x, int y, int state);
+
+protected:
+	virtual void BeginStep(Grid& grid) override;
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+	virtual void EndStep(Grid& grid) override;
+
+private:
+	using StepGenerationsFunction = int(*)(const GenerationsRows& rows, int firstWord, int lastWord, const GenerationsRule& rule);
+
+	GenerationsRule m_GenerationsRule;
+	InstructionSet m_InstructionSet;
+	StepGenerationsFunction m_pStepWords;
+	int m_PlaneCount;
+
+	//Dying planes of the current and the next generation, plane p of row y starts at (p * height + y) * wordsPerRow
+	std::vector<uint64_t> m_Planes[2];
+	int m_FrontPlanes;
+
+	const Grid* m_pLastGrid;
+	uint64_t m_ExpectedGeneration;
+	uint64_t m_ExpectedEditVersion;
+
+	void ResizePlanes(Grid& grid);
+	void ClearDyingUnderAlive(const Grid& grid);
+	const uint64_t* GetPlaneRow(int buffer, const Grid& grid, int plane, int y) const;
+	uint64_t* GetPlaneRow(int buffer, const Grid& grid, int plane, int y);
+};
@@ -0,0 +1,974 @@
+#include "HashLife.h"
+#include "Cell.h"
+#include "CharReader.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <stdexcept>
+
+const uint32_t HashLife::NoNode;
+const uint8_t HashLife::NoStep;
+const int HashLife::MaxLevel;
+
+HashLife::HashLife(size_t memoryCapBytes)
+	: m_Root(NoNode)
+	, m_Generation(0)
+	, m_StepLog2(0)
+	, m_MemoryCap(memoryCapBytes)
+{
+	BuildRuleTable();
+	Clear();
+}
+
+void HashLife::Clear()
+{
+	m_Nodes.clear();
+	m_EmptyNodes.clear();
+	m_Buckets.assign(size_t(1) << 16, NoNode);
+
+	//Node 0 and 1 are the dead and the alive cell, every other node is built out of these two
+	m_Nodes.push_back(Node{ NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, 0, 0, NoStep });
+	m_Nodes.push_back(Node{ NoNode, NoNode, NoNode, NoNode, NoNode, NoNode, 1, 0, NoStep });
+
+	m_Root = GetEmptyNode(3);
+	m_Generation = 0;
+}
+
+void HashLife::SetRule(const Rule& rule)
+{
+	if (rule.IsBorn(0))
+		throw std::runtime_error("HashLife: rules with B0 are not supported");
+
+	m_Rule = rule;
+	BuildRuleTable();
+
+	//Every memoized result was computed with the old rule
+	for (Node& node : m_Nodes)
+	{
+		node.result = NoNode;
+		node.resultStep = NoStep;
+	}
+}
+
+const Rule& HashLife::GetRule() const
+{
+	return m_Rule;
+}
+
+void HashLife::LoadGrid(const Grid& grid)
+{
+	Clear();
+
+	//Find the smallest root where the grid fits in the bottom right quadrant, which starts at (0, 0)
+	int level = 3;
+	int64_t size = std::max(grid.GetWidth(), grid.GetHeight());
+	while ((int64_t(1) << (level - 1)) < size)
+		++level;
+
+	int64_t half = int64_t(1) << (level - 1);
+	m_Root = BuildFromGrid(grid, -half, -half, level);
+	m_Generation = grid.GetGeneration();
+}
+
+void HashLife::SetCell(int64_t x, int64_t y, bool alive)
+{
+	//Grow the universe until the cell is inside the root
+	while (true)
+	{
+		int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+		if (x >= -half && x < half && y >= -half && y < half)
+			break;
+
+		if (m_Nodes[m_Root].level >= MaxLevel)
+			throw std::runtime_error("HashLife: cell is outside of the largest supported universe");
+
+		m_Root = Expand(m_Root);
+	}
+
+	int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+	m_Root = SetCell(m_Root, x + half, y + half, alive);
+}
+
+bool HashLife::IsAlive(int64_t x, int64_t y) const
+{
+	int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+	if (x < -half || x >= half || y < -half || y >= half)
+		return false;
+
+	//Walk down the quadtree, every level halves the region the coordinates are relative to
+	x += half;
+	y += half;
+	uint32_t node = m_Root;
+	while (m_Nodes[node].level > 0)
+	{
+		const Node& current = m_Nodes[node];
+		if (current.population == 0)
+			return false;
+
+		int64_t childHalf = int64_t(1) << (current.level - 1);
+		bool east = x >= childHalf;
+		bool south = y >= childHalf;
+		node = south ? (east ? current.se : current.sw) : (east ? current.ne : current.nw);
+		x -= east ? childHalf : 0;
+		y -= south ? childHalf : 0;
+	}
+
+	return node == 1;
+}
+
+void HashLife::Advance(int stepLog2)
+{
+	if (stepLog2 < 0 || stepLog2 > MaxLevel - 3)
+		throw std::runtime_error("HashLife: step size out of range");
+
+	//The memory cap is enforced between steps, while a step is running every node is still in use
+	if (GetMemoryUsage() > m_MemoryCap)
+		CollectGarbage();
+
+	m_StepLog2 = stepLog2;
+
+	//Pad the universe with empty space until the pattern cannot reach the edge of the result.
+	//The result of a level k node is its center after 2^(k-2) generations, so keep the pattern in the
+	//center of the center and the root at least 3 levels above the step size.
+	while (m_Nodes[m_Root].level < stepLog2 + 3 || !FitsInCenter(m_Root))
+	{
+		if (m_Nodes[m_Root].level >= MaxLevel)
+			throw std::runtime_error("HashLife: pattern grew past the largest supported universe");
+
+		m_Root = Expand(m_Root);
+	}
+
+	m_Root = Result(m_Root);
+	m_Generation += uint64_t(1) << stepLog2;
+}
+
+void HashLife::AdvanceBy(uint64_t generations)
+{
+	for (int bit{ 0 }; bit < 64; bit++)
+	{
+		if ((generations >> bit) & 1)
+			Advance(bit);
+	}
+}
+
+void HashLife::WriteToGrid(Grid& grid, int64_t originX, int64_t originY) const
+{
+	grid.ClearGrid();
+
+	int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+	WriteNode(m_Root, -half, -half, grid, originX, originY);
+}
+
+void HashLife::LoadBlocks(const std::vector<Block>& blocks)
+{
+	Clear();
+	if (blocks.empty())
+		return;
+
+	//Grow the root until every block is inside it
+	int level = 7;
+	for (const Block& block : blocks)
+	{
+		while (true)
+		{
+			int64_t half = int64_t(1) << (level - 1);
+			if (block.x >= -half && block.x + 64 <= half && block.y >= -half && block.y + 64 <= half)
+				break;
+
+			++level;
+		}
+	}
+
+	//Blocks are addressed with 32 bit coordinates relative to the root corner
+	if (level > 38)
+		throw std::runtime_error("HashLife: blocks are spread out too far to load");
+
+	//Sorting the blocks along a Z-order curve puts the blocks of every quadrant next to each other
+	int64_t half = int64_t(1) << (level - 1);
+	std::vector<std::pair<uint64_t, size_t>> codes;
+	codes.reserve(blocks.size());
+	for (size_t index{ 0 }; index < blocks.size(); index++)
+	{
+		uint64_t blockX = uint64_t(blocks[index].x + half) / 64;
+		uint64_t blockY = uint64_t(blocks[index].y + half) / 64;
+
+		uint64_t code = 0;
+		for (int bit{ 0 }; bit < 32; bit++)
+			code |= (((blockX >> bit) & 1) << (2 * bit)) | (((blockY >> bit) & 1) << (2 * bit + 1));
+
+		codes.emplace_back(code, index);
+	}
+
+	std::sort(codes.begin(), codes.end());
+	m_Root = BuildFromBlocks(blocks, codes, 0, codes.size(), 0, level);
+}
+
+bool HashLife::GetBoundingBox(int64_t& left, int64_t& top, int64_t& right, int64_t& bottom) const
+{
+	if (m_Nodes[m_Root].population == 0)
+		return false;
+
+	//Bounds only depend on the node, so shared subtrees are only visited once
+	std::unordered_map<uint32_t, Bounds> cache;
+	Bounds bounds = GetNodeBounds(m_Root, cache);
+
+	int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+	left = bounds.left - half;
+	top = bounds.top - half;
+	right = bounds.right - half;
+	bottom = bounds.bottom - half;
+	return true;
+}
+
+void HashLife::GetRowRuns(int64_t y, std::vector<std::pair<int64_t, int64_t>>& runs) const
+{
+	int64_t half = int64_t(1) << (m_Nodes[m_Root].level - 1);
+	if (y < -half || y >= half)
+		return;
+
+	GetNodeRowRuns(m_Root, -half, -half, y, runs);
+}
+
+void HashLife::ReadMacrocell(std::istream& stream)
+{
+	Clear();
+
+	//Line n of the file defines node n, 0 stands for an empty node of whatever level is needed.
+	//The lines are parsed straight from the reader's buffer, only the short comment lines are copied.
+	std::vector<uint32_t> nodes{ NoNode };
+	uint64_t generation = 0;
+	CharReader reader{ stream };
+	std::string line;
+
+	for (int c = reader.Get(); c != -1; c = reader.Get())
+	{
+		size_t lineNumber = reader.GetLine();
+		auto Fail = [lineNumber]()
+		{
+			throw std::runtime_error("HashLife: invalid macrocell line " + std::to_string(lineNumber));
+		};
+
+		if (c == '\n' || c == '\r')
+			continue;
+
+		if (c == '[')
+		{
+			reader.SkipLine();
+			continue;
+		}
+
+		if (c == '#')
+		{
+			//#R holds the rule and #G the generation, every other comment is skipped
+			reader.ReadLine(line);
+			if (line.size() > 1 && line[0] == 'R')
+				SetRule(Rule::Parse(line.substr(1)));
+			else if (line.size() > 1 && line[0] == 'G')
+				generation = std::strtoull(line.c_str() + 1, nullptr, 10);
+			continue;
+		}
+
+		if (c == '.' || c == '*' || c == '$')
+		{
+			//An 8x8 leaf, rows end with $ and trailing dead cells are left out
+			uint64_t rows[8] = {};
+			int x = 0;
+			int y = 0;
+			for (; c != -1 && c != '\n'; c = reader.Get())
+			{
+				if (c == '\r')
+					continue;
+
+				if (c == '$')
+				{
+					++y;
+					x = 0;
+					continue;
+				}
+
+				if ((c != '.' && c != '*') || x >= 8 || y >= 8)
+					Fail();
+
+				if (c == '*')
+					rows[y] |= uint64_t(1) << x;
+				++x;
+			}
+
+			nodes.push_back(BuildFromRows(rows, 0, 0, 3));
+			continue;
+		}
+
+		//"level nw ne sw se" with the line numbers of the children.
+		//Numbers stop growing once they are too large to be valid, so they can not wrap around into a valid one.
+		auto ReadNumber = [&reader, &c](uint64_t& value)
+		{
+			const uint64_t tooLarge = uint64_t(1) << 40;
+			while (c == ' ' || c == '\t')
+				c = reader.Get();
+			if (c < '0' || c > '9')
+				return false;
+
+			for (value = 0; c >= '0' && c <= '9'; c = reader.Get())
+				value = value >= tooLarge ? value : value * 10 + uint64_t(c - '0');
+			return true;
+		};
+
+		uint64_t level = 0;
+		if (!ReadNumber(level) || level < 4 || level > uint64_t(MaxLevel))
+			Fail();
+
+		uint32_t children[4];
+		for (uint32_t& child : children)
+		{
+			uint64_t childLine = 0;
+			if (!ReadNumber(childLine) || childLine >= nodes.size())
+				Fail();
+
+			child = childLine == 0 ? GetEmptyNode(int(level) - 1) : nodes[size_t(childLine)];
+			if (m_Nodes[child].level != level - 1)
+				Fail();
+		}
+
+		nodes.push_back(GetNode(children[0], children[1], children[2], children[3]));
+		if (c != '\n' && c != -1)
+			reader.SkipLine();
+	}
+
+	//The last node is the root, centered on (0, 0) like our own root
+	if (nodes.size() > 1)
+		m_Root = nodes.back();
+
+	m_Generation = generation;
+}
+
+void HashLife::WriteMacrocell(std::ostream& stream) const
+{
+	stream << "[M2] (ConwaysGameOfLife)\n";
+	stream << "#R " << m_Rule.ToString() << "\n";
+	if (m_Generation != 0)
+		stream << "#G " << m_Generation << "\n";
+
+	std::unordered_map<uint32_t, uint32_t> lines;
+	uint32_t nextLine = 1;
+	WriteMacrocellNode(m_Root, stream, lines, nextLine);
+}
+
+uint64_t HashLife::GetGeneration() const
+{
+	return m_Generation;
+}
+
+uint64_t HashLife::GetPopulation() const
+{
+	return m_Nodes[m_Root].population;
+}
+
+int HashLife::GetRootLevel() const
+{
+	return m_Nodes[m_Root].level;
+}
+
+size_t HashLife::GetNodeCount() const
+{
+	return m_Nodes.size();
+}
+
+size_t HashLife::GetMemoryUsage() const
+{
+	return m_Nodes.capacity() * sizeof(Node) + m_Buckets.capacity() * sizeof(uint32_t);
+}
+
+size_t HashLife::GetMemoryCap() const
+{
+	return m_MemoryCap;
+}
+
+void HashLife::SetMemoryCap(size_t memoryCapBytes)
+{
+	m_MemoryCap = memoryCapBytes;
+}
+
+void HashLife::CollectGarbage()
+{
+	std::vector<uint8_t> marked(m_Nodes.size(), 0);
+	marked[0] = 1;
+	marked[1] = 1;
+
+	//First try to keep the memoized results of the live tree, they are what makes the next step fast
+	Mark(m_Root, marked, true);
+	size_t liveNodes = size_t(std::count(marked.begin(), marked.end(), uint8_t(1)));
+
+	//If that still does not leave enough headroom under the cap, only keep the tree itself
+	if (liveNodes * sizeof(Node) > m_MemoryCap / 4 * 3)
+	{
+		std::fill(marked.begin(), marked.end(), uint8_t(0));
+		marked[0] = 1;
+		marked[1] = 1;
+		Mark(m_Root, marked, false);
+	}
+
+	Compact(marked);
+}
+
+uint32_t HashLife::GetNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+	//Return the existing node if this combination of children was seen before
+	size_t bucket = Hash(nw, ne, sw, se) & (m_Buckets.size() - 1);
+	for (uint32_t index = m_Buckets[bucket]; index != NoNode; index = m_Nodes[index].next)
+	{
+		const Node& node = m_Nodes[index];
+		if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se)
+			return index;
+	}
+
+	uint64_t population = m_Nodes[nw].population + m_Nodes[ne].population + m_Nodes[sw].population + m_Nodes[se].population;
+	uint8_t level = uint8_t(m_Nodes[nw].level + 1);
+
+	uint32_t index = uint32_t(m_Nodes.size());
+	if (index == NoNode)
+		throw std::runtime_error("HashLife: node store is full");
+
+	m_Nodes.push_back(Node{ nw, ne, sw, se, NoNode, m_Buckets[bucket], population, level, NoStep });
+	m_Buckets[bucket] = index;
+
+	if (m_Nodes.size() > m_Buckets.size())
+		GrowBuckets();
+
+	return index;
+}
+
+uint32_t HashLife::GetEmptyNode(int level)
+{
+	if (level == 0)
+		return 0;
+
+	if (int(m_EmptyNodes.size()) <= level)
+		m_EmptyNodes.resize(level + 1, NoNode);
+
+	if (m_EmptyNodes[level] == NoNode)
+	{
+		uint32_t child = GetEmptyNode(level - 1);
+		m_EmptyNodes[level] = GetNode(child, child, child, child);
+	}
+
+	return m_EmptyNodes[level];
+}
+
+void HashLife::GrowBuckets()
+{
+	m_Buckets.assign(m_Buckets.size() * 2, NoNode);
+
+	for (uint32_t index{ 2 }; index < uint32_t(m_Nodes.size()); index++)
+	{
+		Node& node = m_Nodes[index];
+		size_t bucket = Hash(node.nw, node.ne, node.sw, node.se) & (m_Buckets.size() - 1);
+		node.next = m_Buckets[bucket];
+		m_Buckets[bucket] = index;
+	}
+}
+
+uint32_t HashLife::Hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se)
+{
+	uint64_t hash = nw;
+	hash = hash * 0x9E3779B97F4A7C15ull + ne;
+	hash = hash * 0x9E3779B97F4A7C15ull + sw;
+	hash = hash * 0x9E3779B97F4A7C15ull + se;
+	return uint32_t(hash ^ (hash >> 32));
+}
+
+uint32_t HashLife::Expand(uint32_t node)
+{
+	//Surround the node with empty space, the old node ends up in the center of a node one level higher
+	Node current = m_Nodes[node];
+	uint32_t empty = GetEmptyNode(current.level - 1);
+
+	uint32_t nw = GetNode(empty, empty, empty, current.nw);
+	uint32_t ne = GetNode(empty, empty, current.ne, empty);
+	uint32_t sw = GetNode(empty, current.sw, empty, empty);
+	uint32_t se = GetNode(current.se, empty, empty, empty);
+	return GetNode(nw, ne, sw, se);
+}
+
+bool HashLife::FitsInCenter(uint32_t node) const
+{
+	//True when every alive cell is inside the centered square of a quarter of the node's width
+	const Node& current = m_Nodes[node];
+	uint64_t centerPopulation = m_Nodes[m_Nodes[m_Nodes[current.nw].se].se].population
+		+ m_Nodes[m_Nodes[m_Nodes[current.ne].sw].sw].population
+		+ m_Nodes[m_Nodes[m_Nodes[current.sw].ne].ne].population
+		+ m_Nodes[m_Nodes[m_Nodes[current.se].nw].nw].population;
+
+	return centerPopulation == current.population;
+}
+
+uint32_t HashLife::Center(uint32_t node)
+{
+	Node current = m_Nodes[node];
+	return GetNode(m_Nodes[current.nw].se, m_Nodes[current.ne].sw, m_Nodes[current.sw].ne, m_Nodes[current.se].nw);
+}
+
+uint32_t HashLife::HorizontalCenter(uint32_t west, uint32_t east)
+{
+	Node w = m_Nodes[west];
+	Node e = m_Nodes[east];
+	return GetNode(w.ne, e.nw, w.se, e.sw);
+}
+
+uint32_t HashLife::VerticalCenter(uint32_t north, uint32_t south)
+{
+	Node n = m_Nodes[north];
+	Node s = m_Nodes[south];
+	return GetNode(n.sw, n.se, s.nw, s.ne);
+}
+
+uint32_t HashLife::Result(uint32_t node)
+{
+	//Nodes only hold indices, so copy what is needed: m_Nodes can reallocate while the children are computed
+	Node current = m_Nodes[node];
+	int step = std::min(m_StepLog2, current.level - 2);
+	if (current.result != NoNode && current.resultStep == step)
+		return current.result;
+
+	uint32_t result;
+	if (current.population == 0)
+	{
+		result = GetEmptyNode(current.level - 1);
+	}
+	else if (current.level == 2)
+	{
+		result = BaseResult(node);
+	}
+	else
+	{
+		//Nine overlapping subnodes of half the size, each stepped forward
+		uint32_t r00 = Result(current.nw);
+		uint32_t r01 = Result(HorizontalCenter(current.nw, current.ne));
+		uint32_t r02 = Result(current.ne);
+		uint32_t r10 = Result(VerticalCenter(current.nw, current.sw));
+		uint32_t r11 = Result(Center(node));
+		uint32_t r12 = Result(VerticalCenter(current.ne, current.se));
+		uint32_t r20 = Result(current.sw);
+		uint32_t r21 = Result(HorizontalCenter(current.sw, current.se));
+		uint32_t r22 = Result(current.se);
+
+		uint32_t nw = GetNode(r00, r01, r10, r11);
+		uint32_t ne = GetNode(r01, r02, r11, r12);
+		uint32_t sw = GetNode(r10, r11, r20, r21);
+		uint32_t se = GetNode(r11, r12, r21, r22);
+
+		if (step == current.level - 2)
+		{
+			//Full speed: step the four combined nodes again, which doubles the distance in time
+			uint32_t resultNw = Result(nw);
+			uint32_t resultNe = Result(ne);
+			uint32_t resultSw = Result(sw);
+			uint32_t resultSe = Result(se);
+			result = GetNode(resultNw, resultNe, resultSw, resultSe);
+		}
+		else
+		{
+			//Smaller steps: the subnodes already moved far enough, only cut out the centers
+			uint32_t centerNw = Center(nw);
+			uint32_t centerNe = Center(ne);
+			uint32_t centerSw = Center(sw);
+			uint32_t centerSe = Center(se);
+			result = GetNode(centerNw, centerNe, centerSw, centerSe);
+		}
+	}
+
+	m_Nodes[node].result = result;
+	m_Nodes[node].resultStep = uint8_t(step);
+	return result;
+}
+
+uint32_t HashLife::BaseResult(uint32_t node)
+{
+	//Gather the 4x4 cells of a level 2 node in a 16 bit pattern, bit (x + y * 4)
+	const Node& current = m_Nodes[node];
+	uint32_t quadrants[4] = { current.nw, current.ne, current.sw, current.se };
+
+	uint32_t pattern = 0;
+	for (int quadrant{ 0 }; quadrant < 4; quadrant++)
+	{
+		const Node& child = m_Nodes[quadrants[quadrant]];
+		uint32_t cells[4] = { child.nw, child.ne, child.sw, child.se };
+		int baseX = (quadrant % 2) * 2;
+		int baseY = (quadrant / 2) * 2;
+
+		for (int cell{ 0 }; cell < 4; cell++)
+		{
+			if (cells[cell] == 1)
+				pattern |= 1u << ((baseX + cell % 2) + (baseY + cell / 2) * 4);
+		}
+	}
+
+	//The table holds the next state of the 2x2 center in the order nw, ne, sw, se
+	uint8_t next = m_Level2Rule[pattern];
+	return GetNode(next & 1, (next >> 1) & 1, (next >> 2) & 1, (next >> 3) & 1);
+}
+
+uint32_t HashLife::SetCell(uint32_t node, int64_t x, int64_t y, bool alive)
+{
+	Node current = m_Nodes[node];
+	if (current.level == 0)
+		return alive ? 1 : 0;
+
+	//Rebuild the path down to the cell, every other subtree is shared with the old node
+	int64_t half = int64_t(1) << (current.level - 1);
+	if (y < half)
+	{
+		if (x < half)
+			current.nw = SetCell(current.nw, x, y, alive);
+		else
+			current.ne = SetCell(current.ne, x - half, y, alive);
+	}
+	else
+	{
+		if (x < half)
+			current.sw = SetCell(current.sw, x, y - half, alive);
+		else
+			current.se = SetCell(current.se, x - half, y - half, alive);
+	}
+
+	return GetNode(current.nw, current.ne, current.sw, current.se);
+}
+
+uint32_t HashLife::BuildFromGrid(const Grid& grid, int64_t x, int64_t y, int level)
+{
+	int64_t size = int64_t(1) << level;
+	int64_t width = grid.GetWidth();
+	int64_t height = grid.GetHeight();
+
+	//Everything outside of the grid is dead
+	if (x >= width || y >= height || x + size <= 0 || y + size <= 0)
+		return GetEmptyNode(level);
+
+	if (level == 0)
+		return grid.IsAlive(int(x), int(y)) ? 1 : 0;
+
+	//A 64x64 node lines up with one word per row, skip it in one go when all of those words are 0
+	if (level == 6 && x % 64 == 0)
+	{
+		bool empty = true;
+		for (int64_t row = std::max<int64_t>(y, 0); row < std::min(y + size, height) && empty; row++)
+			empty = grid.GetRow(int(row))[x / 64] == 0;
+
+		if (empty)
+			return GetEmptyNode(level);
+	}
+
+	int64_t half = size / 2;
+	uint32_t nw = BuildFromGrid(grid, x, y, level - 1);
+	uint32_t ne = BuildFromGrid(grid, x + half, y, level - 1);
+	uint32_t sw = BuildFromGrid(grid, x, y + half, level - 1);
+	uint32_t se = BuildFromGrid(grid, x + half, y + half, level - 1);
+	return GetNode(nw, ne, sw, se);
+}
+
+void HashLife::WriteNode(uint32_t node, int64_t x, int64_t y, Grid& grid, int64_t originX, int64_t originY) const
+{
+	const Node& current = m_Nodes[node];
+	if (current.population == 0)
+		return;
+
+	//Skip nodes that do not overlap the region the grid shows
+	int64_t size = int64_t(1) << current.level;
+	if (x >= originX + grid.GetWidth() || y >= originY + grid.GetHeight() || x + size <= originX || y + size <= originY)
+		return;
+
+	if (current.level == 0)
+	{
+		grid.SetCell(int(x - originX), int(y - originY), true);
+		return;
+	}
+
+	int64_t half = size / 2;
+	WriteNode(current.nw, x, y, grid, originX, originY);
+	WriteNode(current.ne, x + half, y, grid, originX, originY);
+	WriteNode(current.sw, x, y + half, grid, originX, originY);
+	WriteNode(current.se, x + half, y + half, grid, originX, originY);
+}
+
+uint32_t HashLife::BuildFromRows(const uint64_t* pRows, int x, int y, int level)
+{
+	if (level == 0)
+		return (pRows[y] >> x) & 1;
+
+	//Skip empty parts without creating any nodes
+	int size = 1 << level;
+	uint64_t mask = size == 64 ? ~uint64_t(0) : ((uint64_t(1) << size) - 1) << x;
+	bool empty = true;
+	for (int row{ y }; row < y + size && empty; row++)
+		empty = (pRows[row] & mask) == 0;
+
+	if (empty)
+		return GetEmptyNode(level);
+
+	int half = size / 2;
+	uint32_t nw = BuildFromRows(pRows, x, y, level - 1);
+	uint32_t ne = BuildFromRows(pRows, x + half, y, level - 1);
+	uint32_t sw = BuildFromRows(pRows, x, y + half, level - 1);
+	uint32_t se = BuildFromRows(pRows, x + half, y + half, level - 1);
+	return GetNode(nw, ne, sw, se);
+}
+
+uint32_t HashLife::BuildFromBlocks(const std::vector<Block>& blocks, const std::vector<std::pair<uint64_t, size_t>>& codes,
+	size_t first, size_t last, uint64_t firstCode, int level)
+{
+	if (first == last)
+		return GetEmptyNode(level);
+
+	if (level == 6)
+		return BuildFromRows(blocks[codes[first].second].rows, 0, 0, 6);
+
+	//Each quadrant covers a quarter of the Z-order codes of this node, in the order nw, ne, sw, se
+	uint64_t quadrantCodes = uint64_t(1) << (2 * (level - 7));
+	uint32_t children[4];
+	size_t begin = first;
+	for (int quadrant{ 0 }; quadrant < 4; quadrant++)
+	{
+		uint64_t endCode = firstCode + (quadrant + 1) * quadrantCodes;
+		size_t end = size_t(std::lower_bound(codes.begin() + begin, codes.begin() + last, std::make_pair(endCode, size_t(0))) - codes.begin());
+		children[quadrant] = BuildFromBlocks(blocks, codes, begin, end, firstCode + quadrant * quadrantCodes, level - 1);
+		begin = end;
+	}
+
+	return GetNode(children[0], children[1], children[2], children[3]);
+}
+
+HashLife::Bounds HashLife::GetNodeBounds(uint32_t node, std::unordered_map<uint32_t, Bounds>& cache) const
+{
+	const Node& current = m_Nodes[node];
+	if (current.level == 0)
+		return Bounds{ 0, 0, 1, 1 };
+
+	auto it = cache.find(node);
+	if (it != cache.end())
+		return it->second;
+
+	//Bounds of the alive children, moved to where they sit in this node
+	int64_t half = int64_t(1) << (current.level - 1);
+	const uint32_t children[4] = { current.nw, current.ne, current.sw, current.se };
+	Bounds bounds{ INT64_MAX, INT64_MAX, INT64_MIN, INT64_MIN };
+	for (int quadrant{ 0 }; quadrant < 4; quadrant++)
+	{
+		if (m_Nodes[children[quadrant]].population == 0)
+			continue;
+
+		Bounds child = GetNodeBounds(children[quadrant], cache);
+		int64_t offsetX = (quadrant % 2) * half;
+		int64_t offsetY = (quadrant / 2) * half;
+		bounds.left = std::min(bounds.left, child.left + offsetX);
+		bounds.top = std::min(bounds.top, child.top + offsetY);
+		bounds.right = std::max(bounds.right, child.right + offsetX);
+		bounds.bottom = std::max(bounds.bottom, child.bottom + offsetY);
+	}
+
+	cache[node] = bounds;
+	return bounds;
+}
+
+void HashLife::GetNodeRowRuns(uint32_t node, int64_t x, int64_t y, int64_t row, std::vector<std::pair<int64_t, int64_t>>& runs) const
+{
+	const Node& current = m_Nodes[node];
+	if (current.population == 0)
+		return;
+
+	if (current.level == 0)
+	{
+		//Extend the last run when this cell touches it
+		if (!runs.empty() && runs.back().first + runs.back().second == x)
+			++runs.back().second;
+		else
+			runs.emplace_back(x, 1);
+		return;
+	}
+
+	int64_t half = int64_t(1) << (current.level - 1);
+	if (row < y + half)
+	{
+		GetNodeRowRuns(current.nw, x, y, row, runs);
+		GetNodeRowRuns(current.ne, x + half, y, row, runs);
+	}
+	else
+	{
+		GetNodeRowRuns(current.sw, x, y + half, row, runs);
+		GetNodeRowRuns(current.se, x + half, y + half, row, runs);
+	}
+}
+
+uint32_t HashLife::WriteMacrocellNode(uint32_t node, std::ostream& stream, std::unordered_map<uint32_t, uint32_t>& lines, uint32_t& nextLine) const
+{
+	const Node& current = m_Nodes[node];
+	if (current.population == 0)
+		return 0;
+
+	auto it = lines.find(node);
+	if (it != lines.end())
+		return it->second;
+
+	if (current.level == 3)
+	{
+		uint64_t rows[8] = {};
+		GetNodeBits(node, 0, 0, rows);
+
+		//Every row ends with $, dead cells at the end of a row and empty rows at the end are left out
+		int lastRow = 7;
+		while (rows[lastRow] == 0)
+			--lastRow;
+
+		for (int y{ 0 }; y <= lastRow; y++)
+		{
+			for (int x{ 0 }; x < 8 && (rows[y] >> x) != 0; x++)
+				stream << (((rows[y] >> x) & 1) ? '*' : '.');
+			stream << '$';
+		}
+		stream << '\n';
+	}
+	else
+	{
+		//Children first, a line can only refer to lines before it
+		uint32_t nw = WriteMacrocellNode(current.nw, stream, lines, nextLine);
+		uint32_t ne = WriteMacrocellNode(current.ne, stream, lines, nextLine);
+		uint32_t sw = WriteMacrocellNode(current.sw, stream, lines, nextLine);
+		uint32_t se = WriteMacrocellNode(current.se, stream, lines, nextLine);
+		stream << int(current.level) << ' ' << nw << ' ' << ne << ' ' << sw << ' ' << se << '\n';
+	}
+
+	lines[node] = nextLine;
+	return nextLine++;
+}
+
+void HashLife::GetNodeBits(uint32_t node, int x, int y, uint64_t* pRows) const
+{
+	const Node& current = m_Nodes[node];
+	if (current.population == 0)
+		return;
+
+	if (current.level == 0)
+	{
+		pRows[y] |= uint64_t(1) << x;
+		return;
+	}
+
+	int half = 1 << (current.level - 1);
+	GetNodeBits(current.nw, x, y, pRows);
+	GetNodeBits(current.ne, x + half, y, pRows);
+	GetNodeBits(current.sw, x, y + half, pRows);
+	GetNodeBits(current.se, x + half, y + half, pRows);
+}
+
+void HashLife::BuildRuleTable()
+{
+	//For every 4x4 pattern precompute the next generation of the 2x2 cells in its center
+	for (uint32_t pattern{ 0 }; pattern < (1u << 16); pattern++)
+	{
+		uint8_t next = 0;
+		for (int cell{ 0 }; cell < 4; cell++)
+		{
+			int cellX = 1 + cell % 2;
+			int cellY = 1 + cell / 2;
+
+			int neighbours = 0;
+			for (int offsetY{ -1 }; offsetY <= 1; offsetY++)
+			{
+				for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+				{
+					if (offsetX != 0 || offsetY != 0)
+						neighbours += (pattern >> ((cellX + offsetX) + (cellY + offsetY) * 4)) & 1;
+				}
+			}
+
+			bool alive = (pattern >> (cellX + cellY * 4)) & 1;
+			if (alive ? m_Rule.Survives(neighbours) : m_Rule.IsBorn(neighbours))
+				next |= uint8_t(1 << cell);
+		}
+
+		m_Level2Rule[pattern] = next;
+	}
+}
+
+void HashLife::Mark(uint32_t node, std::vector<uint8_t>& marked, bool keepResults) const
+{
+	if (marked[node])
+		return;
+
+	marked[node] = 1;
+
+	const Node& current = m_Nodes[node];
+	if (current.level == 0)
+		return;
+
+	Mark(current.nw, marked, keepResults);
+	Mark(current.ne, marked, keepResults);
+	Mark(current.sw, marked, keepResults);
+	Mark(current.se, marked, keepResults);
+
+	if (keepResults && current.result != NoNode)
+		Mark(current.result, marked, keepResults);
+}
+
+void HashLife::Compact(const std::vector<uint8_t>& marked)
+{
+	size_t liveNodes = size_t(std::count(marked.begin(), marked.end(), uint8_t(1)));
+
+	//Children are always created before their parents, so remapping in index order sees every child first
+	std::vector<uint32_t> newIndices(m_Nodes.size(), NoNode);
+	std::vector<Node> nodes;
+	nodes.reserve(liveNodes + liveNodes / 2);
+
+	for (size_t index{ 0 }; index < m_Nodes.size(); index++)
+	{
+		if (!marked[index])
+			continue;
+
+		Node node = m_Nodes[index];
+		if (node.level > 0)
+		{
+			node.nw = newIndices[node.nw];
+			node.ne = newIndices[node.ne];
+			node.sw = newIndices[node.sw];
+			node.se = newIndices[node.se];
+		}
+
+		newIndices[index] = uint32_t(nodes.size());
+		nodes.push_back(node);
+	}
+
+	//Results can point to newer nodes, so those are remapped once every node has its new index
+	for (Node& node : nodes)
+	{
+		if (node.result != NoNode)
+			node.result = newIndices[node.result];
+
+		if (node.result == NoNode)
+			node.resultStep = NoStep;
+	}
+
+	m_Nodes.swap(nodes);
+	m_Root = newIndices[m_Root];
+
+	for (uint32_t& emptyNode : m_EmptyNodes)
+	{
+		if (emptyNode != NoNode)
+			emptyNode = newIndices[emptyNode];
+	}
+
+	//Rebuild the hash table for the surviving nodes
+	size_t bucketCount = size_t(1) << 16;
+	while (bucketCount < m_Nodes.size())
+		bucketCount *= 2;
+
+	m_Buckets = std::vector<uint32_t>(bucketCount, NoNode);
+	for (uint32_t index{ 2 }; index < uint32_t(m_Nodes.size()); index++)
+	{
+		Node& node = m_Nodes[index];
+		size_t bucket = Hash(node.nw, node.ne, node.sw, node.se) & (m_Buckets.size() - 1);
+		node.next = m_Buckets[bucket];
+		m_Buckets[bucket] = index;
+	}
+}
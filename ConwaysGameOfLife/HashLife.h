@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Rule.h"
+
+class Grid;
+
+//HashLife engine (Gosper's algorithm) for advancing huge or long running patterns.
+//The universe is an unbounded quadtree where identical subtrees are stored only once (hash-consing)
+//and every node remembers the result of stepping its center, so repeating structures are only ever computed once.
+//
+//The root spans [-2^(level-1), 2^(level-1)) in both directions, a Grid is loaded with its top left cell at (0, 0).
+//Unlike the dense engines there is no border, cells that leave a grid region keep living in the universe.
+class HashLife final
+{
+public:
+	//When the node store grows past the memory cap, garbage is collected before the next step
+	HashLife(size_t memoryCapBytes = size_t(512) * 1024 * 1024);
+	~HashLife() = default;
+	HashLife(const HashLife& other) = delete;
+	HashLife(HashLife&& other) = delete;
+	HashLife& operator=(const HashLife& other) = delete;
+	HashLife& operator=(HashLife&& other) = delete;
+
+	void Clear();
+
+	//Rules with birth on 0 neighbours would fill the infinite empty space and are rejected with std::runtime_error
+	void SetRule(const Rule& rule);
+	const Rule& GetRule() const;
+
+	void LoadGrid(const Grid& grid);
+	void SetCell(int64_t x, int64_t y, bool alive);
+	bool IsAlive(int64_t x, int64_t y) const;
+
+	//Advances the universe by 2^stepLog2 generations
+	void Advance(int stepLog2);
+	//Advances by any number of generations as a sum of power of two steps
+	void AdvanceBy(uint64_t generations);
+
+	//Writes the cells of the region starting at (originX, originY) with the size of the grid into the grid
+	void WriteToGrid(Grid& grid, int64_t originX = 0, int64_t originY = 0) const;
+
+	//64x64 cells with their top left corner at (x, y), both multiples of 64. Bit x of rows[y] is cell (x, y).
+	struct Block
+	{
+		int64_t x;
+		int64_t y;
+		uint64_t rows[64];
+	};
+
+	//Replaces the universe with the blocks, building the tree bottom up instead of setting cell by cell.
+	//Every block position may only appear once.
+	void LoadBlocks(const std::vector<Block>& blocks);
+
+	//Smallest rectangle [left, right) x [top, bottom) holding every alive cell, false when there are none
+	bool GetBoundingBox(int64_t& left, int64_t& top, int64_t& right, int64_t& bottom) const;
+	//Appends the runs of alive cells in row y as (first x, length) from left to right
+	void GetRowRuns(int64_t y, std::vector<std::pair<int64_t, int64_t>>& runs) const;
+
+	//Macrocell (.mc) is the native file format of HashLife: every distinct node is written once.
+	//Reading throws std::runtime_error on malformed input.
+	void ReadMacrocell(std::istream& stream);
+	void WriteMacrocell(std::ostream& stream) const;
+
+	uint64_t GetGeneration() const;
+	uint64_t GetPopulation() const;
+	int GetRootLevel() const;
+	size_t GetNodeCount() const;
+	size_t GetMemoryUsage() const;
+	size_t GetMemoryCap() const;
+	void SetMemoryCap(size_t memoryCapBytes);
+
+	//Drops every node that is no longer reachable from the root
+	void CollectGarbage();
+
+private:
+	static const uint32_t NoNode = 0xFFFFFFFF;
+	static const uint8_t NoStep = 0xFF;
+	static const int MaxLevel = 62;
+
+	struct Node
+	{
+		uint32_t nw, ne, sw, se;	//Children, or unused for the two level 0 leaves
+		uint32_t result;			//Memoized center of this node stepped by 2^resultStep generations
+		uint32_t next;				//Next node in the same hash bucket
+		uint64_t population;
+		uint8_t level;
+		uint8_t resultStep;
+	};
+
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_Buckets;
+	std::vector<uint32_t> m_EmptyNodes;
+	uint8_t m_Level2Rule[1 << 16];
+	Rule m_Rule;
+
+	uint32_t m_Root;
+	uint64_t m_Generation;
+	int m_StepLog2;
+	size_t m_MemoryCap;
+
+	uint32_t GetNode(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+	uint32_t GetEmptyNode(int level);
+	void GrowBuckets();
+	static uint32_t Hash(uint32_t nw, uint32_t ne, uint32_t sw, uint32_t se);
+
+	uint32_t Expand(uint32_t node);
+	bool FitsInCenter(uint32_t node) const;
+	uint32_t Center(uint32_t node);
+	uint32_t HorizontalCenter(uint32_t west, uint32_t east);
+	uint32_t VerticalCenter(uint32_t north, uint32_t south);
+	uint32_t Result(uint32_t node);
+	uint32_t BaseResult(uint32_t node);
+
+	uint32_t SetCell(uint32_t node, int64_t x, int64_t y, bool alive);
+	uint32_t BuildFromGrid(const Grid& grid, int64_t x, int64_t y, int level);
+	void WriteNode(uint32_t node, int64_t x, int64_t y, Grid& grid, int64_t originX, int64_t originY) const;
+
+	uint32_t BuildFromRows(const uint64_t* pRows, int x, int y, int level);
+	uint32_t BuildFromBlocks(const std::vector<Block>& blocks, const std::vector<std::pair<uint64_t, size_t>>& codes,
+		size_t first, size_t last, uint64_t firstCode, int level);
+
+	struct Bounds
+	{
+		int64_t left, top, right, bottom;
+	};
+	Bounds GetNodeBounds(uint32_t node, std::unordered_map<uint32_t, Bounds>& cache) const;
+	void GetNodeRowRuns(uint32_t node, int64_t x, int64_t y, int64_t row, std::vector<std::pair<int64_t, int64_t>>& runs) const;
+	uint32_t WriteMacrocellNode(uint32_t node, std::ostream& stream, std::unordered_map<uint32_t, uint32_t>& lines, uint32_t& nextLine) const;
+	void GetNodeBits(uint32_t node, int x, int y, uint64_t* pRows) const;
+
+	void BuildRuleTable();
+	void Mark(uint32_t node, std::vector<uint8_t>& marked, bool keepResults) const;
+	void Compact(const std::vector<uint8_t>& marked);
+};
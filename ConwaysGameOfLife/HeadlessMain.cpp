@@ -0,0 +1,52 @@
+#include "HeadlessRunner.h"
+#include "SoupSearch.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+//Entry point of the headless runner, built by CMake on any platform.
+//The Visual Studio project keeps using Main.cpp, so this file is not part of it.
+int main(int argc, char** argv)
+{
+	//--soups switches to the soup census, everything else runs a single grid
+	bool soupSearch = false;
+	for (int i{ 1 }; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (argument == "--help" || argument == "-h")
+		{
+			HeadlessRunner::PrintUsage(std::cout);
+			SoupSearch::PrintUsage(std::cout);
+			return 0;
+		}
+
+		if (argument == "--soups")
+			soupSearch = true;
+	}
+
+	try
+	{
+		if (soupSearch)
+		{
+			SoupSearch search{ SoupSearch::ParseArguments(argc, argv) };
+			SoupSearch::PrintResult(search.Run(), std::cout);
+		}
+		else
+		{
+			HeadlessRunner runner{ HeadlessRunner::ParseArguments(argc, argv) };
+			runner.Run(std::cout);
+		}
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << exception.what() << std::endl;
+		if (soupSearch)
+			SoupSearch::PrintUsage(std::cerr);
+		else
+			HeadlessRunner::PrintUsage(std::cerr);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,425 @@
+#include "HeadlessRunner.h"
+#include "EngineFactory.h"
+#include "CycleDetector.h"
+#include "GenerationHistory.h"
+#include "LifeEngine.h"
+#include "HashLife.h"
+#include "PatternIO.h"
+#include "ShardedSimulation.h"
+#include "Snapshot.h"
+#include "SparseUniverse.h"
+#include "Statistics.h"
+#include "ThreadPool.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+static bool HasExtension(const std::string& path, const std::string& extension)
+{
+	if (path.size() < extension.size())
+		return false;
+
+	return std::equal(extension.rbegin(), extension.rend(), path.rbegin(), [](char a, char b)
+		{
+			return a == std::tolower((unsigned char)b);
+		});
+}
+
+HeadlessRunner::HeadlessRunner(const HeadlessOptions& options)
+	: m_Options(options)
+{
+}
+
+HeadlessResult HeadlessRunner::Run(std::ostream& stream)
+{
+	//A snapshot is mapped and stepped in place, it has to stay open until the grid is done
+	std::unique_ptr<Snapshot> pSnapshot{ m_Options.snapshotPath.empty() ? nullptr : new Snapshot{ m_Options.snapshotPath } };
+	Grid grid = pSnapshot ? pSnapshot->CreateGrid() : Grid{ m_Options.width, m_Options.height, 1 };
+	std::string fileRule = pSnapshot ? pSnapshot->GetRule() : FillGrid(grid);
+	std::string rulestring = m_Options.rule.empty() ? fileRule : m_Options.rule;
+	if (!m_Options.topology.empty())
+		grid.SetTopology(ParseTopology(m_Options.topology));
+
+	HeadlessResult result{};
+	result.width = grid.GetWidth();
+	result.height = grid.GetHeight();
+	result.generations = m_Options.generations;
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point start{};
+	Clock::time_point end{};
+
+	if (m_Options.engine == "hashlife" || m_Options.engine == "sparse")
+	{
+		//The unbounded universes have no border, only the grid region ends up in the hash
+		if (grid.GetTopology() != Topology::DeadBorder)
+			throw std::runtime_error{ "The " + m_Options.engine + " engine has no border to wrap around" };
+		if (m_Options.historyMegabytes != 0)
+			throw std::runtime_error{ "The " + m_Options.engine + " engine has no generation history" };
+		if (!m_Options.statisticsPath.empty())
+			throw std::runtime_error{ "The " + m_Options.engine + " engine does not count statistics" };
+
+		Rule rule = rulestring.empty() ? Rule::Conway() : Rule::Parse(rulestring);
+		result.rule = rule.ToString();
+		result.engineName = m_Options.engine;
+
+		if (m_Options.engine == "hashlife")
+		{
+			HashLife hashLife{};
+			hashLife.SetRule(rule);
+			hashLife.LoadGrid(grid);
+
+			start = Clock::now();
+			hashLife.AdvanceBy(m_Options.generations);
+			end = Clock::now();
+
+			result.population = hashLife.GetPopulation();
+			hashLife.WriteToGrid(grid);
+		}
+		else
+		{
+			SparseUniverse universe{};
+			universe.SetRule(rule);
+			universe.LoadGrid(grid);
+
+			start = Clock::now();
+			for (uint64_t generation{ 0 }; generation < m_Options.generations; generation++)
+				universe.Step();
+			end = Clock::now();
+
+			result.population = universe.GetPopulation();
+			universe.WriteToGrid(grid);
+		}
+	}
+	else if (m_Options.shardCount != 0)
+	{
+		//The workers create their own engines, this one only names the engine and rule in the result
+		std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(m_Options.engine, rulestring) };
+		result.engineName = pEngine->GetName();
+		result.rule = pEngine->GetRuleString();
+
+		ShardedSimulation sharded{ m_Options.engine, rulestring, m_Options.shardCount };
+		start = Clock::now();
+		sharded.Run(grid, m_Options.generations);
+		end = Clock::now();
+
+		result.shardCount = sharded.GetShardCount();
+		result.exchangedBytes = sharded.GetExchangedBytes();
+
+		GenerationStatistics statistics = grid.GetStatistics();
+		result.population = statistics.population;
+		result.minX = statistics.minX;
+		result.minY = statistics.minY;
+		result.maxX = statistics.maxX;
+		result.maxY = statistics.maxY;
+	}
+	else
+	{
+		std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(m_Options.engine, rulestring) };
+		std::unique_ptr<ThreadPool> pThreadPool{ m_Options.threadCount != 1 ? new ThreadPool{ m_Options.threadCount } : nullptr };
+		pEngine->SetThreadPool(pThreadPool.get());
+
+		result.engineName = pEngine->GetName();
+		result.rule = pEngine->GetRuleString();
+
+		CycleDetector detector{ 64, CycleDetector::GetConfirmations(*pEngine) };
+		bool detectCycles = m_Options.cycles != "none";
+		pEngine->SetRecordChanges(detectCycles);
+		uint64_t firstGeneration = grid.GetGeneration();
+
+		//The statistics are counted by the engine while it steps, the file only receives them
+		std::ofstream statisticsFile{};
+		std::unique_ptr<StatisticsSink> pStatistics{};
+		if (!m_Options.statisticsPath.empty())
+		{
+			statisticsFile.open(m_Options.statisticsPath, std::ios::binary);
+			if (!statisticsFile)
+				throw std::runtime_error{ "Could not open " + m_Options.statisticsPath };
+
+			if (HasExtension(m_Options.statisticsPath, ".json"))
+				pStatistics.reset(new JsonStatisticsSink{ statisticsFile });
+			else
+				pStatistics.reset(new CsvStatisticsSink{ statisticsFile });
+			pEngine->SetCountStatistics(true);
+		}
+
+		//Recording and writing statistics are part of the run, they are timed with the steps
+		std::unique_ptr<GenerationHistory> pHistory{ m_Options.historyMegabytes != 0 ? new GenerationHistory{ size_t(m_Options.historyMegabytes) << 20 } : nullptr };
+		auto Record = [&]()
+		{
+			if (pHistory)
+				pHistory->Record(grid);
+			if (pStatistics && grid.GetGeneration() % m_Options.statisticsInterval == 0)
+				pStatistics->Write(grid.GetStatistics());
+		};
+		auto StepAndRecord = [&]()
+		{
+			pEngine->Step(grid);
+			Record();
+		};
+
+		start = Clock::now();
+		Record();
+		for (uint64_t generation{ 0 }; generation < m_Options.generations; generation++)
+		{
+			StepAndRecord();
+			if (!detectCycles || !detector.Update(grid))
+				continue;
+
+			if (m_Options.cycles == "skip")
+			{
+				//Only the generations that do not make up a whole period are still stepped
+				uint64_t remaining = detector.FastForward(grid, m_Options.generations - generation - 1);
+				for (uint64_t step{ 0 }; step < remaining; step++)
+					StepAndRecord();
+			}
+			break;
+		}
+		if (pStatistics)
+			pStatistics->Finish();
+		end = Clock::now();
+
+		result.generations = grid.GetGeneration() - firstGeneration;
+		result.period = detector.GetPeriod();
+		result.cycleStart = detector.GetCycleStart();
+
+		if (pHistory)
+		{
+			result.historyGenerations = pHistory->GetGenerationCount();
+			result.historyBytes = pHistory->GetMemoryUsage();
+		}
+
+		if (m_Options.rewindGeneration >= 0)
+		{
+			if (!pHistory || !pHistory->Contains(uint64_t(m_Options.rewindGeneration)))
+				throw std::runtime_error{ "Generation " + std::to_string(m_Options.rewindGeneration) + " is not in the history, the oldest one is "
+					+ std::to_string(pHistory ? pHistory->GetOldestGeneration() : grid.GetGeneration()) };
+
+			Clock::time_point rewindStart = Clock::now();
+			pHistory->Rewind(grid, uint64_t(m_Options.rewindGeneration));
+			result.rewindSeconds = std::chrono::duration<double>(Clock::now() - rewindStart).count();
+			result.rewoundGeneration = m_Options.rewindGeneration;
+		}
+
+		//What the engine counted in the last step when it did, a single pass over the grid otherwise
+		GenerationStatistics statistics = grid.GetStatistics();
+		result.population = statistics.population;
+		result.minX = statistics.minX;
+		result.minY = statistics.minY;
+		result.maxX = statistics.maxX;
+		result.maxY = statistics.maxY;
+	}
+
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	result.hash = grid.ComputeHash();
+
+	//The result is out before the snapshot is written, a save that fails does not lose the run
+	PrintResult(result, stream);
+	if (!m_Options.saveSnapshotPath.empty())
+		Snapshot::Save(m_Options.saveSnapshotPath, grid, result.rule);
+
+	return result;
+}
+
+HeadlessOptions HeadlessRunner::ParseArguments(int argc, char** argv)
+{
+	HeadlessOptions options{};
+
+	for (int i{ 1 }; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error{ "Missing value for " + argument };
+
+		std::string value = argv[++i];
+		try
+		{
+			if (argument == "--engine")
+				options.engine = value;
+			else if (argument == "--rule")
+				options.rule = value;
+			else if (argument == "--pattern")
+				options.patternPath = value;
+			else if (argument == "--snapshot")
+				options.snapshotPath = value;
+			else if (argument == "--save-snapshot")
+				options.saveSnapshotPath = value;
+			else if (argument == "--topology")
+				options.topology = value;
+			else if (argument == "--cycles")
+				options.cycles = value;
+			else if (argument == "--width")
+				options.width = std::stoi(value);
+			else if (argument == "--height")
+				options.height = std::stoi(value);
+			else if (argument == "--generations")
+				options.generations = std::stoull(value);
+			else if (argument == "--threads")
+				options.threadCount = std::stoi(value);
+			else if (argument == "--history")
+				options.historyMegabytes = std::stoull(value);
+			else if (argument == "--rewind")
+				options.rewindGeneration = std::stoll(value);
+			else if (argument == "--stats")
+				options.statisticsPath = value;
+			else if (argument == "--stats-every")
+				options.statisticsInterval = std::stoull(value);
+			else if (argument == "--shards")
+				options.shardCount = std::stoi(value);
+			else if (argument == "--density")
+				options.density = std::stod(value);
+			else if (argument == "--seed")
+				options.seed = std::stoull(value);
+			else
+				throw std::runtime_error{ "Unknown argument " + argument };
+		}
+		catch (const std::logic_error&)
+		{
+			//std::stoi and friends throw invalid_argument/out_of_range
+			throw std::runtime_error{ "Invalid value \"" + value + "\" for " + argument };
+		}
+	}
+
+	if (options.cycles != "none" && options.cycles != "stop" && options.cycles != "skip")
+		throw std::runtime_error{ "Invalid value \"" + options.cycles + "\" for --cycles" };
+	if (!options.topology.empty())
+		ParseTopology(options.topology);
+	if (options.rewindGeneration >= 0 && options.historyMegabytes == 0)
+		throw std::runtime_error{ "--rewind needs a --history to rewind through" };
+	if (options.statisticsInterval == 0)
+		throw std::runtime_error{ "Invalid value \"0\" for --stats-every" };
+	if (!options.statisticsPath.empty() && !HasExtension(options.statisticsPath, ".json") && !HasExtension(options.statisticsPath, ".csv"))
+		throw std::runtime_error{ "Statistics can only be written as .csv or .json, not " + options.statisticsPath };
+	if (!options.snapshotPath.empty() && options.saveSnapshotPath == options.snapshotPath)
+		throw std::runtime_error{ "--save-snapshot can not overwrite the --snapshot the grid is mapped from, save to another file" };
+	if (options.shardCount < 0)
+		throw std::runtime_error{ "Invalid value \"" + std::to_string(options.shardCount) + "\" for --shards" };
+
+	//A sharded run only hands the grid to the workers and takes it back at the end
+	if (options.shardCount != 0)
+	{
+		if (!ShardedSimulation::IsSupported())
+			throw std::runtime_error{ "--shards is not supported on this platform" };
+		if (options.engine == "hashlife" || options.engine == "sparse")
+			throw std::runtime_error{ "The " + options.engine + " engine can not be sharded" };
+		if (options.threadCount != 1 || options.historyMegabytes != 0 || options.cycles != "none" || !options.statisticsPath.empty())
+			throw std::runtime_error{ "--shards can not be combined with --threads, --history, --cycles or --stats" };
+	}
+
+	return options;
+}
+
+void HeadlessRunner::PrintUsage(std::ostream& stream)
+{
+	stream << "Usage: LifeHeadless [options]\n"
+		<< "  --engine NAME        engine to use (default bitwise), one of:\n"
+		<< "                      ";
+	for (const std::string& name : EngineFactory::GetEngineNames())
+		stream << " " << name;
+	stream << " hashlife sparse\n"
+		<< "  --rule RULE          rule in the notation of the engine (default: rule of the pattern, else B3/S23)\n"
+		<< "  --pattern FILE       .rle, .mc or .cells pattern, centered on the grid (default random soup)\n"
+		<< "  --snapshot FILE      start from a snapshot, mapped and stepped without loading it\n"
+		<< "  --save-snapshot FILE save the final grid as a snapshot\n"
+		<< "  --width N            grid width (default 1024)\n"
+		<< "  --height N           grid height (default 1024)\n"
+		<< "  --generations N      generations to run (default 1000)\n"
+		<< "  --topology NAME      what lies past the edges: dead, torus or klein (default dead)\n"
+		<< "  --cycles MODE        once the grid repeats: none, stop, or skip whole periods (default none)\n"
+		<< "  --threads N          simulation threads, 0 = all cores (default 1)\n"
+		<< "  --history MB         keep earlier generations as deltas in this much memory (default off)\n"
+		<< "  --rewind N           rewind to generation N from the history after the run\n"
+		<< "  --stats FILE         write population, births, deaths and bounding box per generation (.csv or .json)\n"
+		<< "  --stats-every N      only write every Nth generation (default 1)\n"
+		<< "  --shards N           split the grid over N worker processes (default off, Linux only)\n"
+		<< "  --density D          chance of a cell being alive in the soup (default 0.5)\n"
+		<< "  --seed N             seed of the soup (default 1)\n";
+}
+
+void HeadlessRunner::PrintResult(const HeadlessResult& result, std::ostream& stream)
+{
+	double cellUpdates = double(result.width) * result.height * result.generations;
+	double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+
+	stream << "engine: " << result.engineName << "\n"
+		<< "rule: " << result.rule << "\n"
+		<< "grid: " << result.width << "x" << result.height << "\n"
+		<< "generations: " << result.generations << "\n"
+		<< "seconds: " << std::fixed << std::setprecision(6) << result.seconds << "\n"
+		<< "generations/s: " << std::setprecision(1) << result.generations / seconds << "\n"
+		<< "cell updates/s: " << std::scientific << std::setprecision(3) << cellUpdates / seconds << "\n"
+		<< "population: " << result.population << "\n";
+	if (result.maxX >= 0)
+		stream << "bounding box: (" << result.minX << ", " << result.minY << ") to (" << result.maxX << ", " << result.maxY << ")\n";
+	stream << "hash: " << std::hex << std::setw(16) << std::setfill('0') << result.hash << std::dec << std::setfill(' ') << "\n";
+	stream.unsetf(std::ios_base::floatfield);
+
+	if (result.period != 0)
+		stream << "cycle: period " << result.period << " from generation " << result.cycleStart << "\n";
+	if (result.historyGenerations != 0)
+		stream << "history: " << result.historyGenerations << " generations in " << result.historyBytes << " bytes\n";
+	if (result.shardCount != 0)
+		stream << "shards: " << result.shardCount << ", " << result.exchangedBytes << " bytes of boundary rows exchanged\n";
+	if (result.rewoundGeneration >= 0)
+		stream << "rewound to generation " << result.rewoundGeneration << " in " << std::fixed << std::setprecision(6) << result.rewindSeconds
+			<< " seconds, the population and hash are of that generation\n";
+	stream.unsetf(std::ios_base::floatfield);
+}
+
+Topology HeadlessRunner::ParseTopology(const std::string& name)
+{
+	if (name == "dead")
+		return Topology::DeadBorder;
+	if (name == "torus")
+		return Topology::Torus;
+	if (name == "klein")
+		return Topology::KleinBottle;
+
+	throw std::runtime_error{ "Invalid value \"" + name + "\" for --topology" };
+}
+
+std::string HeadlessRunner::FillGrid(Grid& grid) const
+{
+	if (!m_Options.patternPath.empty())
+		return LoadPattern(m_Options.patternPath, grid);
+
+	std::mt19937_64 random{ m_Options.seed };
+	std::bernoulli_distribution alive{ m_Options.density };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+		{
+			if (alive(random))
+				grid.SetCell(x, y, true);
+		}
+	}
+
+	return std::string{};
+}
+
+std::string HeadlessRunner::LoadPattern(const std::string& path, Grid& grid)
+{
+	//Patterns can be far bigger than they are dense, so they are read into a quadtree and only the cells are copied over
+	HashLife hashLife{};
+	std::string rule = PatternReader::LoadFile(path, hashLife);
+
+	int64_t left, top, right, bottom;
+	if (!hashLife.GetBoundingBox(left, top, right, bottom))
+		return rule;
+
+	if (right - left > grid.GetWidth() || bottom - top > grid.GetHeight())
+		throw std::runtime_error{ "Pattern " + path + " does not fit in the grid" };
+
+	int64_t originX = left - (grid.GetWidth() - (right - left)) / 2;
+	int64_t originY = top - (grid.GetHeight() - (bottom - top)) / 2;
+	hashLife.WriteToGrid(grid, originX, originY);
+	return rule;
+}
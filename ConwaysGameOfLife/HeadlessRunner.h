@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+class Grid;
+enum class Topology;
+
+struct HeadlessOptions
+{
+	std::string engine = "bitwise";	//Any name from EngineFactory, or "hashlife" / "sparse" for the unbounded universes
+	std::string rule;				//Empty uses the rule of the pattern file, or else the default rule of the engine
+	std::string patternPath;		//RLE (.rle), Macrocell (.mc) or plaintext (.cells) pattern centered on the grid, a random soup is used when empty
+	std::string snapshotPath;		//Snapshot to start from instead of a pattern or soup, the size comes from the snapshot
+	std::string saveSnapshotPath;	//Snapshot of the final grid, nothing is saved when empty
+	int width = 1024;
+	int height = 1024;
+	uint64_t generations = 1000;
+	std::string topology;			//"dead", "torus" or "klein", empty keeps the topology of the snapshot or else a dead border
+	std::string cycles = "none";	//What to do once the grid repeats itself: "none", "stop" stepping, or "skip" the remaining whole periods
+	int threadCount = 1;			//0 uses every hardware thread
+	uint64_t historyMegabytes = 0;	//Memory for the generation history, 0 records none
+	int64_t rewindGeneration = -1;	//Generation to rewind to from the history after the run, -1 keeps the last one
+	std::string statisticsPath;		//Per-generation statistics as CSV (.csv) or JSON (.json), none are counted when empty
+	uint64_t statisticsInterval = 1;	//Only every this many generations are written
+	int shardCount = 0;				//Worker processes the grid is split over, 0 steps it in this process
+	double density = 0.5;			//Chance of a cell being alive in the random soup
+	uint64_t seed = 1;
+};
+
+struct HeadlessResult
+{
+	std::string engineName;
+	std::string rule;
+	int width = 0;
+	int height = 0;
+	uint64_t generations = 0;		//Generations the grid advanced, fewer than asked when a cycle stopped the run
+	uint64_t period = 0;			//Period of the cycle the grid ended up in, 0 when none was found or detection was off
+	uint64_t cycleStart = 0;
+	double seconds = 0.0;
+	uint64_t historyGenerations = 0;	//Generations still in the history at the end of the run
+	uint64_t historyBytes = 0;
+	int64_t rewoundGeneration = -1;	//Generation the population and hash belong to after a rewind, -1 without one
+	double rewindSeconds = 0.0;
+	int shardCount = 0;
+	uint64_t exchangedBytes = 0;	//Boundary rows the shards passed to each other
+	uint64_t population = 0;
+	int minX = 0;					//Bounding box of the alive cells, maxX/maxY are -1 when there are none
+	int minY = 0;
+	int maxX = -1;
+	int maxY = -1;
+	uint64_t hash = 0;
+};
+
+//Runs a simulation without a window: load a pattern, advance it as fast as possible and report the throughput.
+//Meant for batch jobs and performance regression runs on machines without a display.
+class HeadlessRunner final
+{
+public:
+	HeadlessRunner(const HeadlessOptions& options);
+	~HeadlessRunner() = default;
+	HeadlessRunner(const HeadlessRunner& other) = delete;
+	HeadlessRunner(HeadlessRunner&& other) = delete;
+	HeadlessRunner& operator=(const HeadlessRunner& other) = delete;
+	HeadlessRunner& operator=(HeadlessRunner&& other) = delete;
+
+	//Prints the result to the stream before the final snapshot is saved.
+	//Throws std::runtime_error when the engine, rule or pattern can not be used, or the snapshot can not be saved.
+	HeadlessResult Run(std::ostream& stream);
+
+	//Throws std::runtime_error on unknown or malformed arguments
+	static HeadlessOptions ParseArguments(int argc, char** argv);
+	static void PrintUsage(std::ostream& stream);
+	static void PrintResult(const HeadlessResult& result, std::ostream& stream);
+
+private:
+	HeadlessOptions m_Options;
+
+	//Returns the rule stored in the pattern file, if any
+	std::string FillGrid(Grid& grid) const;
+	static std::string LoadPattern(const std::string& path, Grid& grid);
+	static Topology ParseTopology(const std::string& name);
+};
@@ -0,0 +1,345 @@
+#include "LargerThanLifeEngine.h"
+#include "ThreadPool.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+//Whether the cell at (x, y) is alive, wherever it lies: outside of the grid the topology decides which cell it is.
+//The halo of the grid is only one cell wide, too narrow for a radius, so the engine wraps coordinates itself.
+static bool IsAliveAround(const Grid& grid, int x, int y)
+{
+	int width = grid.GetWidth();
+	int height = grid.GetHeight();
+	bool inside = x >= 0 && x < width && y >= 0 && y < height;
+	if (inside || grid.GetTopology() == Topology::DeadBorder)
+		return inside && grid.IsAlive(x, y);
+
+	//Every time a Klein bottle is crossed vertically, left and right are mirrored
+	int wraps = (y >= 0 ? y : y - height + 1) / height;
+	y -= wraps * height;
+	if (grid.GetTopology() == Topology::KleinBottle && (wraps & 1))
+		x = width - 1 - x;
+
+	x %= width;
+	if (x < 0)
+		x += width;
+
+	return grid.IsAlive(x, y);
+}
+
+LargerThanLifeEngine::LargerThanLifeEngine(const LargerThanLifeRule& rule)
+	: m_LargerThanLifeRule(rule)
+	, m_Margin(0)
+	, m_TableWidth(0)
+	, m_TableHeight(0)
+{
+	SetLargerThanLifeRule(rule);
+}
+
+const char* LargerThanLifeEngine::GetName() const
+{
+	return "larger-than-life";
+}
+
+std::string LargerThanLifeEngine::GetRuleString() const
+{
+	return m_LargerThanLifeRule.ToString();
+}
+
+void LargerThanLifeEngine::SetRule(const Rule& rule)
+{
+	SetLargerThanLifeRule(LargerThanLifeRule::FromRule(rule));
+}
+
+void LargerThanLifeEngine::SetLargerThanLifeRule(const LargerThanLifeRule& rule)
+{
+	Rule lifeLike{};
+	lifeLike.birthMask = 0;
+	lifeLike.survivalMask = 0;
+	LifeEngine::SetRule(rule.IsLifeLike() ? rule.ToRule() : lifeLike);
+	m_LargerThanLifeRule = rule;
+}
+
+const LargerThanLifeRule& LargerThanLifeEngine::GetLargerThanLifeRule() const
+{
+	return m_LargerThanLifeRule;
+}
+
+int LargerThanLifeEngine::GetRange() const
+{
+	return m_LargerThanLifeRule.radius;
+}
+
+void LargerThanLifeEngine::BeginStep(Grid& grid)
+{
+	//Wide enough for the farthest lookup of a cell on the edge of the grid
+	int radius = m_LargerThanLifeRule.radius;
+	m_Margin = radius + 1;
+	m_TableWidth = grid.GetWidth() + 2 * m_Margin;
+	m_TableHeight = grid.GetHeight() + 2 * m_Margin;
+
+	//Tables are only reallocated when the grid or the radius changes
+	size_t tableSize = size_t(m_TableWidth) * m_TableHeight;
+	if (m_LargerThanLifeRule.neighbourhood == Neighbourhood::Moore)
+	{
+		if (m_SummedArea.size() != tableSize)
+		{
+			m_SummedArea.assign(tableSize, 0);
+			grid.RecordAllocation(tableSize * sizeof(uint16_t));
+		}
+
+		BuildSummedArea(grid);
+	}
+	else
+	{
+		if (m_DiagonalDown.size() != tableSize)
+		{
+			m_DiagonalDown.assign(tableSize, 0);
+			m_DiagonalUp.assign(tableSize, 0);
+			grid.RecordAllocation(2 * tableSize * sizeof(uint16_t));
+		}
+
+		BuildDiagonals(grid);
+	}
+}
+
+void LargerThanLifeEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		if (m_LargerThanLifeRule.neighbourhood == Neighbourhood::Moore)
+			StepRowMoore(grid, y);
+		else
+			StepRowVonNeumann(grid, y);
+	}
+}
+
+void LargerThanLifeEngine::BuildSummedArea(const Grid& grid)
+{
+	int width = grid.GetWidth();
+	uint16_t* pTable = m_SummedArea.data();
+
+	//First every row holds the prefix sum of its own cells, table row ty is the sum over the cells above it
+	auto sumRow = [this, &grid, pTable, width](int ty)
+	{
+		uint16_t* pRow = pTable + size_t(ty) * m_TableWidth;
+		int y = ty - m_Margin - 1;
+		if (grid.GetTopology() != Topology::DeadBorder)
+		{
+			//The margin holds the cells from across the border, look every one of them up
+			uint16_t sum = 0;
+			pRow[0] = 0;
+			for (int tx{ 1 }; tx < m_TableWidth; tx++)
+			{
+				sum = uint16_t(sum + IsAliveAround(grid, tx - m_Margin - 1, y));
+				pRow[tx] = sum;
+			}
+			return;
+		}
+
+		if (y < 0 || y >= grid.GetHeight())
+		{
+			std::fill(pRow, pRow + m_TableWidth, uint16_t(0));
+			return;
+		}
+
+		//The margin left of the grid is dead, right of the grid the sum stays at the row total
+		const uint64_t* pCells = grid.GetRow(y);
+		uint16_t sum = 0;
+		std::fill(pRow, pRow + m_Margin + 1, uint16_t(0));
+		for (int x{ 0 }; x < width; x++)
+		{
+			sum = uint16_t(sum + ((pCells[x / 64] >> (x % 64)) & 1));
+			pRow[x + m_Margin + 1] = sum;
+		}
+		std::fill(pRow + width + m_Margin + 1, pRow + m_TableWidth, sum);
+	};
+
+	//Then the rows are added up top to bottom, every column strip on its own
+	const int columnsPerStrip = 256;
+	int stripCount = (m_TableWidth + columnsPerStrip - 1) / columnsPerStrip;
+	auto sumColumns = [this, pTable, columnsPerStrip](int strip)
+	{
+		int firstColumn = strip * columnsPerStrip;
+		int lastColumn = std::min(m_TableWidth, firstColumn + columnsPerStrip);
+		for (int ty{ 1 }; ty < m_TableHeight; ty++)
+		{
+			const uint16_t* pAbove = pTable + size_t(ty - 1) * m_TableWidth;
+			uint16_t* pRow = pTable + size_t(ty) * m_TableWidth;
+			for (int tx{ firstColumn }; tx < lastColumn; tx++)
+				pRow[tx] = uint16_t(pRow[tx] + pAbove[tx]);
+		}
+	};
+
+	//Row 0 and column 0 stay 0
+	std::fill(pTable, pTable + m_TableWidth, uint16_t(0));
+
+	ThreadPool* pThreadPool = GetThreadPool();
+	if (pThreadPool)
+	{
+		auto sumRowTask = [&sumRow](int index) { sumRow(index + 1); };
+		pThreadPool->ParallelFor(m_TableHeight - 1, sumRowTask);
+		pThreadPool->ParallelFor(stripCount, sumColumns);
+	}
+	else
+	{
+		for (int ty{ 1 }; ty < m_TableHeight; ty++)
+			sumRow(ty);
+		for (int strip{ 0 }; strip < stripCount; strip++)
+			sumColumns(strip);
+	}
+}
+
+void LargerThanLifeEngine::BuildDiagonals(const Grid& grid)
+{
+	int width = grid.GetWidth();
+	uint16_t* pDownTable = m_DiagonalDown.data();
+	uint16_t* pUpTable = m_DiagonalUp.data();
+
+	//First both tables hold the cells themselves, table row ty is grid row ty - m_Margin
+	auto fillRow = [this, &grid, pDownTable, pUpTable, width](int ty)
+	{
+		uint16_t* pDown = pDownTable + size_t(ty) * m_TableWidth;
+		uint16_t* pUp = pUpTable + size_t(ty) * m_TableWidth;
+		int y = ty - m_Margin;
+		if (y < 0 || y >= grid.GetHeight())
+		{
+			//Rows past the top and bottom are dead or come from across the border
+			for (int tx{ 0 }; tx < m_TableWidth; tx++)
+				pDown[tx] = IsAliveAround(grid, tx - m_Margin, y);
+		}
+		else
+		{
+			//Only the margins left and right have to be looked up, the cells in between come straight from the row
+			const uint64_t* pCells = grid.GetRow(y);
+			for (int tx{ 0 }; tx < m_Margin; tx++)
+			{
+				pDown[tx] = IsAliveAround(grid, tx - m_Margin, y);
+				pDown[tx + width + m_Margin] = IsAliveAround(grid, width + tx, y);
+			}
+			for (int x{ 0 }; x < width; x++)
+				pDown[x + m_Margin] = uint16_t((pCells[x / 64] >> (x % 64)) & 1);
+		}
+		std::copy(pDown, pDown + m_TableWidth, pUp);
+	};
+
+	//Then the rows are added up top to bottom along the diagonals, every strip of diagonals on its own.
+	//Diagonal d going down to the right holds the cells with tx - ty = d, going up to the right those with tx + ty = d.
+	const int diagonalsPerStrip = 256;
+	int diagonalCount = m_TableWidth + m_TableHeight - 1;
+	int stripCount = (diagonalCount + diagonalsPerStrip - 1) / diagonalsPerStrip;
+	auto sumDiagonals = [this, pDownTable, pUpTable, diagonalsPerStrip, diagonalCount](int strip)
+	{
+		int firstDiagonal = strip * diagonalsPerStrip;
+		int lastDiagonal = std::min(diagonalCount, firstDiagonal + diagonalsPerStrip);
+		for (int ty{ 1 }; ty < m_TableHeight; ty++)
+		{
+			const uint16_t* pDownAbove = pDownTable + size_t(ty - 1) * m_TableWidth;
+			uint16_t* pDown = pDownTable + size_t(ty) * m_TableWidth;
+			int offset = ty - (m_TableHeight - 1);
+			for (int tx{ std::max(1, firstDiagonal + offset) }; tx < std::min(m_TableWidth, lastDiagonal + offset); tx++)
+				pDown[tx] = uint16_t(pDown[tx] + pDownAbove[tx - 1]);
+
+			const uint16_t* pUpAbove = pUpTable + size_t(ty - 1) * m_TableWidth;
+			uint16_t* pUp = pUpTable + size_t(ty) * m_TableWidth;
+			for (int tx{ std::max(0, firstDiagonal - ty) }; tx < std::min(m_TableWidth - 1, lastDiagonal - ty); tx++)
+				pUp[tx] = uint16_t(pUp[tx] + pUpAbove[tx + 1]);
+		}
+	};
+
+	ThreadPool* pThreadPool = GetThreadPool();
+	if (pThreadPool)
+	{
+		pThreadPool->ParallelFor(m_TableHeight, fillRow);
+		pThreadPool->ParallelFor(stripCount, sumDiagonals);
+	}
+	else
+	{
+		for (int ty{ 0 }; ty < m_TableHeight; ty++)
+			fillRow(ty);
+		for (int strip{ 0 }; strip < stripCount; strip++)
+			sumDiagonals(strip);
+	}
+}
+
+void LargerThanLifeEngine::StepRowMoore(Grid& grid, int y) const
+{
+	const LargerThanLifeRule& rule = m_LargerThanLifeRule;
+	int radius = rule.radius;
+	int side = 2 * radius + 1;
+
+	//Table entry (tx, ty) is the sum of the cells left of column tx and above row ty, both in table coordinates
+	int top = y + m_Margin - radius;
+	const uint16_t* pTop = m_SummedArea.data() + size_t(top) * m_TableWidth;
+	const uint16_t* pBottom = pTop + size_t(side) * m_TableWidth;
+
+	const uint64_t* pRow = grid.GetRow(y);
+	uint64_t* pNextRow = grid.GetNextRow(y);
+	std::fill(pNextRow, pNextRow + grid.GetWordsPerRow(), uint64_t(0));
+
+	for (int x{ 0 }; x < grid.GetWidth(); x++)
+	{
+		int left = x + m_Margin - radius;
+		int count = uint16_t(pBottom[left + side] - pBottom[left] - pTop[left + side] + pTop[left]);
+
+		bool alive = (pRow[x / 64] >> (x % 64)) & 1;
+		if (alive && !rule.countsCenter)
+			--count;
+
+		if (alive ? rule.Survives(count) : rule.IsBorn(count))
+			pNextRow[x / 64] |= uint64_t(1) << (x % 64);
+	}
+}
+
+void LargerThanLifeEngine::StepRowVonNeumann(Grid& grid, int y) const
+{
+	const LargerThanLifeRule& rule = m_LargerThanLifeRule;
+	int radius = rule.radius;
+	int width = m_TableWidth;
+	const uint16_t* pDown = m_DiagonalDown.data();
+	const uint16_t* pUp = m_DiagonalUp.data();
+
+	auto Down = [pDown, width](int tx, int ty) { return pDown[size_t(ty) * width + tx]; };
+	auto Up = [pUp, width](int tx, int ty) { return pUp[size_t(ty) * width + tx]; };
+
+	const uint64_t* pRow = grid.GetRow(y);
+	uint64_t* pNextRow = grid.GetNextRow(y);
+	std::fill(pNextRow, pNextRow + grid.GetWordsPerRow(), uint64_t(0));
+
+	int ty = y + m_Margin;
+	int count = CountDiamond(grid, 0, y);
+	for (int x{ 0 }; x < grid.GetWidth(); x++)
+	{
+		int neighbours = count;
+		bool alive = (pRow[x / 64] >> (x % 64)) & 1;
+		if (alive && !rule.countsCenter)
+			--neighbours;
+
+		if (alive ? rule.Survives(neighbours) : rule.IsBorn(neighbours))
+			pNextRow[x / 64] |= uint64_t(1) << (x % 64);
+
+		//Slide the diamond one cell to the right: the right edge of the new diamond comes in,
+		//the left edge of the old one goes out. Each edge is two diagonal runs that meet on this row.
+		int tx = x + m_Margin;
+		int added = uint16_t(Down(tx + 1 + radius, ty) - Down(tx, ty - radius - 1))
+			+ uint16_t(Up(tx + 1, ty + radius) - Up(tx + radius + 1, ty));
+		int removed = uint16_t(Up(tx - radius, ty) - Up(tx + 1, ty - radius - 1))
+			+ uint16_t(Down(tx, ty + radius) - Down(tx - radius, ty));
+		count += added - removed;
+	}
+}
+
+int LargerThanLifeEngine::CountDiamond(const Grid& grid, int x, int y) const
+{
+	int radius = m_LargerThanLifeRule.radius;
+	int count = 0;
+	for (int offsetY{ -radius }; offsetY <= radius; offsetY++)
+	{
+		int reach = radius - std::abs(offsetY);
+		for (int cellX{ x - reach }; cellX <= x + reach; cellX++)
+			count += IsAliveAround(grid, cellX, y + offsetY);
+	}
+
+	return count;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "LifeEngine.h"
+#include <cstdint>
+#include <vector>
+
+//Engine for Larger than Life rules, where cells count their neighbours over a radius R neighbourhood.
+//Counting cell by cell costs O(R^2), so the counts are read from prefix sum tables built once per generation:
+// - Moore: a summed-area table, every square is 4 lookups
+// - von Neumann: prefix sums along both diagonals, sliding the diamond one cell to the right adds and removes
+//   two diagonal edges of the diamond, which is 8 lookups
+//The tables are 16 bit and wrap around, which is fine because every count that is read from them is below 2^16.
+class LargerThanLifeEngine final : public LifeEngine
+{
+public:
+	LargerThanLifeEngine(const LargerThanLifeRule& rule = LargerThanLifeRule{});
+	virtual ~LargerThanLifeEngine() = default;
+	LargerThanLifeEngine(const LargerThanLifeEngine& other) = delete;
+	LargerThanLifeEngine(LargerThanLifeEngine&& other) = delete;
+	LargerThanLifeEngine& operator=(const LargerThanLifeEngine& other) = delete;
+	LargerThanLifeEngine& operator=(LargerThanLifeEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+
+	//Life-like rules are only accepted when their counts form a single range, see LargerThanLifeRule::FromRule
+	virtual void SetRule(const Rule& rule) override;
+	virtual std::string GetRuleString() const override;
+	virtual int GetRange() const override;
+	//GetRule follows along: the Life-like equivalent for radius 1 Moore rules,
+	//a rule where nothing is born and nothing survives for every other rule, which has no Life-like form
+	void SetLargerThanLifeRule(const LargerThanLifeRule& rule);
+	const LargerThanLifeRule& GetLargerThanLifeRule() const;
+
+protected:
+	virtual void BeginStep(Grid& grid) override;
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+
+private:
+	LargerThanLifeRule m_LargerThanLifeRule;
+
+	//Tables cover the grid plus a margin on every side, so no lookup ever needs a bounds check.
+	//The margin holds dead cells or the cells from across the border, depending on the topology of the grid.
+	int m_Margin;
+	int m_TableWidth;
+	int m_TableHeight;
+	std::vector<uint16_t> m_SummedArea;
+	std::vector<uint16_t> m_DiagonalDown;	//Sum of the cell and every cell up and to the left of it
+	std::vector<uint16_t> m_DiagonalUp;		//Sum of the cell and every cell up and to the right of it
+
+	void BuildSummedArea(const Grid& grid);
+	void BuildDiagonals(const Grid& grid);
+	void StepRowMoore(Grid& grid, int y) const;
+	void StepRowVonNeumann(Grid& grid, int y) const;
+	int CountDiamond(const Grid& grid, int x, int y) const;
+};
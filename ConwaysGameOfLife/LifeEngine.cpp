@@ -0,0 +1,207 @@
+#include "LifeEngine.h"
+#include "Cell.h"
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+LifeEngine::LifeEngine()
+	: m_pThreadPool(nullptr)
+	, m_CountStatistics(false)
+	, m_RecordChanges(false)
+{
+}
+
+void LifeEngine::Step(Grid& grid)
+{
+	//Births minus deaths move the population along, it is only counted when the one of this generation is not known
+	bool countPopulation = !grid.HasCurrentStatistics();
+	uint64_t population = countPopulation ? 0 : grid.GetStatistics().population;
+
+	grid.BeginGeneration();
+	grid.FillHalo();
+	if (m_RecordChanges)
+		grid.BeginRecordingChanges();
+	BeginStep(grid);
+
+	int height = grid.GetHeight();
+	int threadCount = m_pThreadPool ? m_pThreadPool->GetThreadCount() : 1;
+
+	int bandCount = 1;
+	if (threadCount > 1)
+	{
+		//A few bands per thread so a slow band does not leave the other threads waiting,
+		//but never so thin that the one-row halo above and below dominates the work
+		const int minRowsPerBand = 8;
+		bandCount = std::max(1, std::min(threadCount * 4, height / minRowsPerBand));
+	}
+
+	if (m_CountStatistics)
+	{
+		if (m_BandStatistics.capacity() < size_t(bandCount))
+			grid.RecordAllocation(bandCount * sizeof(RowStatistics));
+		m_BandStatistics.assign(bandCount, RowStatistics{});
+	}
+
+	if (bandCount == 1)
+	{
+		StepBand(grid, 0, height, countPopulation, m_CountStatistics ? &m_BandStatistics[0] : nullptr);
+	}
+	else
+	{
+		int rowsPerBand = (height + bandCount - 1) / bandCount;
+		auto stepBand = [this, &grid, rowsPerBand, height, countPopulation](int band)
+		{
+			int firstRow = band * rowsPerBand;
+			int lastRow = std::min(height, firstRow + rowsPerBand);
+			if (firstRow < lastRow)
+				StepBand(grid, firstRow, lastRow, countPopulation, m_CountStatistics ? &m_BandStatistics[band] : nullptr);
+		};
+		m_pThreadPool->ParallelFor(bandCount, stepBand);
+	}
+
+	if (!m_CountStatistics)
+	{
+		grid.SwapBuffers();
+		EndStep(grid);
+		return;
+	}
+
+	GenerationStatistics statistics{};
+	statistics.generation = grid.GetGeneration() + 1;
+	statistics.minX = grid.GetWidth();
+	statistics.minY = height;
+	for (const RowStatistics& band : m_BandStatistics)
+	{
+		population += band.population;
+		statistics.births += band.births;
+		statistics.deaths += band.deaths;
+		statistics.minX = std::min(statistics.minX, band.minX);
+		statistics.minY = std::min(statistics.minY, band.minY);
+		statistics.maxX = std::max(statistics.maxX, band.maxX);
+		statistics.maxY = std::max(statistics.maxY, band.maxY);
+	}
+	statistics.population = countPopulation ? population : population + statistics.births - statistics.deaths;
+	if (statistics.maxY < 0)
+	{
+		statistics.minX = 0;
+		statistics.minY = 0;
+	}
+
+	grid.SwapBuffers();
+	grid.SetStatistics(statistics);
+	EndStep(grid);
+}
+
+void LifeEngine::SetRule(const Rule& rule)
+{
+	m_Rule = rule;
+}
+
+const Rule& LifeEngine::GetRule() const
+{
+	return m_Rule;
+}
+
+std::string LifeEngine::GetRuleString() const
+{
+	return m_Rule.ToString();
+}
+
+int LifeEngine::GetRange() const
+{
+	return 1;
+}
+
+void LifeEngine::SetThreadPool(ThreadPool* pThreadPool)
+{
+	m_pThreadPool = pThreadPool;
+}
+
+ThreadPool* LifeEngine::GetThreadPool() const
+{
+	return m_pThreadPool;
+}
+
+void LifeEngine::SetCountStatistics(bool countStatistics)
+{
+	m_CountStatistics = countStatistics;
+}
+
+bool LifeEngine::GetCountStatistics() const
+{
+	return m_CountStatistics;
+}
+
+void LifeEngine::SetRecordChanges(bool recordChanges)
+{
+	m_RecordChanges = recordChanges;
+}
+
+bool LifeEngine::GetRecordChanges() const
+{
+	return m_RecordChanges;
+}
+
+void LifeEngine::BeginStep(Grid&)
+{
+}
+
+void LifeEngine::EndStep(Grid&)
+{
+}
+
+void LifeEngine::StepBand(Grid& grid, int firstRow, int lastRow, bool countPopulation, RowStatistics* pStatistics)
+{
+	if (!pStatistics && !m_RecordChanges)
+	{
+		StepRows(grid, firstRow, lastRow);
+		return;
+	}
+
+	CountRowFunction pCountRow;
+	if (CpuFeatures::HasAvx2() && CpuFeatures::HasPopcnt())
+		pCountRow = countPopulation ? &CountRowWithPopulationAvx2 : &CountRowAvx2;
+	else
+		pCountRow = countPopulation ? &CountRow<true> : &CountRow<false>;
+
+	int wordsPerRow = grid.GetWordsPerRow();
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	//The rows are counted in chunks of about 32KB of cells, while what was just written to them is still in the cache
+	int rowsPerChunk = std::max(1, 4096 / wordsPerRow);
+	for (int first{ firstRow }; first < lastRow; first += rowsPerChunk)
+	{
+		int last = std::min(lastRow, first + rowsPerChunk);
+		StepRows(grid, first, last);
+
+		if (m_RecordChanges)
+		{
+			for (int y{ first }; y < last; y++)
+				grid.RecordRowChanges(y);
+		}
+
+		if (!pStatistics)
+			continue;
+
+		RowStatistics& statistics = *pStatistics;
+		for (int y{ first }; y < last; y++)
+		{
+			const uint64_t* pNext = grid.GetNextRow(y);
+			int lastWord = pCountRow(grid.GetRow(y), pNext, wordsPerRow, lastWordMask, statistics);
+			if (lastWord < 0)
+				continue;
+
+			//Only alive rows are searched for their first word, and only up to it
+			int firstWord{ 0 };
+			while (pNext[firstWord] == 0)
+				++firstWord;
+
+			uint64_t lastBits = lastWord == wordsPerRow - 1 ? pNext[lastWord] & lastWordMask : pNext[lastWord];
+			statistics.minX = std::min(statistics.minX, firstWord * 64 + CountTrailingZeros64(pNext[firstWord]));
+			statistics.maxX = std::max(statistics.maxX, lastWord * 64 + 63 - CountLeadingZeros64(lastBits));
+			statistics.minY = std::min(statistics.minY, y);
+			statistics.maxY = y;
+		}
+	}
+}
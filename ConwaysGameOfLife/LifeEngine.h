@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include "Rule.h"
+#include "StatisticsKernel.h"
+
+class Grid;
+class ThreadPool;
+
+//Base class for everything that can advance a Grid by one generation.
+//Engines are interchangeable, the application only talks to this interface.
+class LifeEngine
+{
+public:
+	LifeEngine();
+	virtual ~LifeEngine() = default;
+	LifeEngine(const LifeEngine& other) = delete;
+	LifeEngine(LifeEngine&& other) = delete;
+	LifeEngine& operator=(const LifeEngine& other) = delete;
+	LifeEngine& operator=(LifeEngine&& other) = delete;
+
+	//Reads the current generation of the grid, writes the next one into its back buffer and swaps
+	void Step(Grid& grid);
+	virtual const char* GetName() const = 0;
+
+	//Engines start out with Conway's rule (B3/S23)
+	virtual void SetRule(const Rule& rule);
+	const Rule& GetRule() const;
+	//The rule in the notation of the engine, engines with their own kind of rule override this
+	virtual std::string GetRuleString() const;
+	//How many rows above and below a cell its next state depends on
+	virtual int GetRange() const;
+
+	//With a thread pool the rows are split in bands that are stepped in parallel.
+	//Every band only reads the current generation and writes its own rows, so the result is identical to the serial path.
+	void SetThreadPool(ThreadPool* pThreadPool);
+	ThreadPool* GetThreadPool() const;
+
+	//With statistics on, every step stores its GenerationStatistics in the grid, counted chunk by chunk right after
+	//the rows were stepped so nothing has to read the grid again. Counting costs about as much as a vectorized step itself,
+	//so it is off until something asks for it.
+	void SetCountStatistics(bool countStatistics);
+	bool GetCountStatistics() const;
+
+	//With recording on, every step marks the words it changed in the grid (Grid::GetStepChanges), compared chunk by chunk
+	//right after the rows were stepped. Whatever follows the grid from one generation to the next, like CycleDetector,
+	//then only visits those words instead of diffing the whole grid against the previous generation.
+	void SetRecordChanges(bool recordChanges);
+	bool GetRecordChanges() const;
+
+protected:
+	//Called once per generation before any rows are stepped, the place to (re)size shared scratch buffers
+	virtual void BeginStep(Grid& grid);
+	//Called once per generation after the grid swapped its buffers
+	virtual void EndStep(Grid& grid);
+
+	//Computes the rows [firstRow, lastRow) of the next generation into Grid::GetNextRow.
+	//Can be called from several threads at once for different row ranges.
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) = 0;
+
+	Rule m_Rule;
+
+private:
+	ThreadPool* m_pThreadPool;
+	bool m_CountStatistics;
+	bool m_RecordChanges;
+	std::vector<RowStatistics> m_BandStatistics;	//One per band, merged once all of them are done
+
+	//Counts the rows as well when given statistics to add them to, and records their changes when that is on
+	void StepBand(Grid& grid, int firstRow, int lastRow, bool countPopulation, RowStatistics* pStatistics);
+};
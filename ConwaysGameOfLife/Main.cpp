@@ -52,8 +52,20 @@ void CreateApplication(HINSTANCE hInstance)
 	//Spacebar:     start/stop simulation
 	//Enter:        show/hide the grid
 	//Backspace:    clear the grid
+	//U:            switch between the grid and the unbounded universe
+	//I:            cycle the engine: bitwise -> change tracking -> neighbour counts -> bitwise
+	//T:            cycle what lies past the edges: dead border -> torus -> Klein bottle
+	//C:            pause once the grid repeats itself on/off
+	//S:            save the grid to save.rle
+	//L:            load save.rle into the grid
+	//Left/Right:   go back/forward one generation
+	//R:            reset the view
+	//Mouse wheel:  zoom in/out, right drag: move the view
 
-	//Create an application, you can give it the size of a cell
+	//SetBoardSize makes the board larger than the window, zooming out then shows it as a density map
+
+	//Create an application, you can give it the size of a cell, the number of simulation threads (0 = all cores)
+	//and whether the simulation steps on its own thread next to the render loop
 	//int appNr = GetApplication();
 	int appNr = 1;
 
@@ -61,13 +73,18 @@ void CreateApplication(HINSTANCE hInstance)
 	switch (appNr)
 	{
 	case 0:
-		app = new SDL2Application{15};
+	{
+		//Any Life-like rule in B/S notation can be used, e.g. Rule::Parse("B36/S23") for HighLife
+		SDL2Application* pSDLApp = new SDL2Application{15, 0};
+		pSDLApp->SetRule(Rule::Conway());
+		app = pSDLApp;
 		break;
+	}
 	case 1:
 		app = new DirectXApplication{hInstance};
 		break;
 	default:
-		app = new SDL2Application{15};
+		app = new SDL2Application{15, 0};
 		break;
 	}
 
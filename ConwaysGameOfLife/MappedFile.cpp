@@ -0,0 +1,102 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string& path)
+	: m_pData(nullptr)
+	, m_Size(0)
+	, m_File(INVALID_HANDLE_VALUE)
+	, m_Mapping(nullptr)
+{
+	m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE)
+		throw std::runtime_error{ "Could not open " + path };
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(m_File);
+		throw std::runtime_error{ "Could not map empty file " + path };
+	}
+	m_Size = size_t(size.QuadPart);
+
+	//PAGE_WRITECOPY with FILE_MAP_COPY gives every process private copies of the pages it writes to
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (m_Mapping)
+		m_pData = static_cast<char*>(MapViewOfFile(m_Mapping, FILE_MAP_COPY, 0, 0, 0));
+
+	if (!m_pData)
+	{
+		if (m_Mapping)
+			CloseHandle(m_Mapping);
+		CloseHandle(m_File);
+		throw std::runtime_error{ "Could not map " + path };
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	UnmapViewOfFile(m_pData);
+	CloseHandle(m_Mapping);
+	CloseHandle(m_File);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+	: m_pData(nullptr)
+	, m_Size(0)
+	, m_File(-1)
+{
+	m_File = open(path.c_str(), O_RDONLY);
+	if (m_File < 0)
+		throw std::runtime_error{ "Could not open " + path };
+
+	struct stat status{};
+	if (fstat(m_File, &status) != 0 || status.st_size == 0)
+	{
+		close(m_File);
+		throw std::runtime_error{ "Could not map empty file " + path };
+	}
+	m_Size = size_t(status.st_size);
+
+	//A private mapping of a read only file can still be written to, the written pages are copied first
+	void* pData = mmap(nullptr, m_Size, PROT_READ | PROT_WRITE, MAP_PRIVATE, m_File, 0);
+	if (pData == MAP_FAILED)
+	{
+		close(m_File);
+		throw std::runtime_error{ "Could not map " + path };
+	}
+	m_pData = static_cast<char*>(pData);
+}
+
+MappedFile::~MappedFile()
+{
+	munmap(m_pData, m_Size);
+	close(m_File);
+}
+
+#endif
+
+char* MappedFile::GetData() const
+{
+	return m_pData;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
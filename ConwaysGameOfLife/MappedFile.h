@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+//Maps a whole file into memory copy-on-write: the pages are read from the file when they are first touched,
+//writes go to private copies of the pages and never reach the file.
+class MappedFile final
+{
+public:
+	//Throws std::runtime_error when the file can not be opened or mapped
+	MappedFile(const std::string& path);
+	~MappedFile();
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile(MappedFile&& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	MappedFile& operator=(MappedFile&& other) = delete;
+
+	//Page aligned start of the file
+	char* GetData() const;
+	size_t GetSize() const;
+
+private:
+	char* m_pData;
+	size_t m_Size;
+#if defined(_WIN32)
+	void* m_File;
+	void* m_Mapping;
+#else
+	int m_File;
+#endif
+};
@@ -0,0 +1,276 @@
+#include "NeighbourCountEngine.h"
+#include "Bits.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <climits>
+
+//Moves bit i of the low 16 bits to bit 4 * i, so adding the spread words of 8 neighbours gives 16 counts at once
+static uint64_t SpreadToNibbles(uint64_t bits)
+{
+	bits &= 0xFFFF;
+	bits = (bits | (bits << 24)) & 0x000000FF000000FFull;
+	bits = (bits | (bits << 12)) & 0x000F000F000F000Full;
+	bits = (bits | (bits << 6)) & 0x0303030303030303ull;
+	bits = (bits | (bits << 3)) & 0x1111111111111111ull;
+	return bits;
+}
+
+NeighbourCountEngine::NeighbourCountEngine()
+	: m_pLastGrid(nullptr)
+	, m_ExpectedGeneration(0)
+	, m_ExpectedEditVersion(0)
+	, m_FullPass(true)
+	, m_Width(0)
+	, m_Height(0)
+	, m_WordsPerRow(0)
+	, m_Topology(Topology::DeadBorder)
+	, m_EvaluatedCells(0)
+	, m_pStepWords(SelectStepWords<SwarOps>(m_Rule))
+{
+}
+
+const char* NeighbourCountEngine::GetName() const
+{
+	return "neighbour-count";
+}
+
+void NeighbourCountEngine::SetRule(const Rule& rule)
+{
+	LifeEngine::SetRule(rule);
+	m_pStepWords = SelectStepWords<SwarOps>(rule);
+
+	//The counts stay right, but cells that were stable under the old rule are not evaluated under the new one
+	m_pLastGrid = nullptr;
+}
+
+void NeighbourCountEngine::ToggleCell(Grid& grid, int x, int y)
+{
+	bool inSync = IsInSync(grid);
+	grid.ToggleCell(x, y);
+	if (!inSync)
+		return;
+
+	ApplyChange(x, y, grid.IsAlive(x, y));
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+uint64_t NeighbourCountEngine::GetEvaluatedCellCount() const
+{
+	return m_EvaluatedCells.load();
+}
+
+bool NeighbourCountEngine::WasFullPass() const
+{
+	return m_FullPass;
+}
+
+bool NeighbourCountEngine::IsInSync(const Grid& grid) const
+{
+	return m_pLastGrid == &grid
+		&& grid.GetGeneration() == m_ExpectedGeneration
+		&& grid.GetEditVersion() == m_ExpectedEditVersion
+		&& grid.GetWidth() == m_Width
+		&& grid.GetHeight() == m_Height;
+}
+
+void NeighbourCountEngine::BeginStep(Grid& grid)
+{
+	m_FullPass = !IsInSync(grid);
+	m_EvaluatedCells = 0;
+	if (!m_FullPass)
+		return;
+
+	m_Width = grid.GetWidth();
+	m_Height = grid.GetHeight();
+	m_WordsPerRow = grid.GetWordsPerRow();
+	m_Topology = grid.GetTopology();
+
+	//The counts are taken from the grid again while the rows are stepped, the bitmaps start out empty
+	size_t mapSize = size_t(m_WordsPerRow) * m_Height;
+	if (m_Candidates.size() != mapSize)
+		grid.RecordAllocation(6 * mapSize * sizeof(uint64_t) + 2 * m_Height * sizeof(WordSpan));
+	m_Counts.assign(4 * mapSize, 0);
+	m_Candidates.assign(mapSize, 0);
+	m_Changes.assign(mapSize, 0);
+	m_CandidateSpans.assign(m_Height, WordSpan{ INT_MAX, -1 });
+	m_ChangeSpans.assign(m_Height, WordSpan{ INT_MAX, -1 });
+}
+
+void NeighbourCountEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	uint64_t lastWordMask = grid.GetLastWordMask();
+
+	//Bit n of the low half is birth with n neighbours, bit n of the high half survival
+	uint32_t transitions = uint32_t(m_Rule.birthMask) | (uint32_t(m_Rule.survivalMask) << 16);
+	auto NextState = [transitions](const uint64_t* pCounts, uint64_t current, int x) -> uint64_t
+	{
+		int neighbours = int((pCounts[x / 16] >> ((x % 16) * 4)) & 15);
+		int alive = int((current >> (x % 64)) & 1);
+		return (transitions >> (neighbours + 16 * alive)) & 1;
+	};
+
+	uint64_t evaluatedCells = 0;
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		uint64_t* pNext = grid.GetNextRow(y);
+		const uint64_t* pCounts = m_Counts.data() + size_t(y) * 4 * m_WordsPerRow;
+		uint64_t* pCandidates = m_Candidates.data() + size_t(y) * m_WordsPerRow;
+		uint64_t* pChanges = m_Changes.data() + size_t(y) * m_WordsPerRow;
+		WordSpan& candidateSpan = m_CandidateSpans[y];
+		WordSpan& changeSpan = m_ChangeSpans[y];
+
+		int firstWord = 0;
+		int lastWord = m_WordsPerRow - 1;
+		if (m_FullPass)
+		{
+			//Every cell is evaluated, which the compiled kernel of the rule does for the whole row at once
+			CountRow(grid, y);
+			m_pStepWords(grid.GetRow(y - 1), pRow, grid.GetRow(y + 1), pNext, 0, m_WordsPerRow, m_Rule);
+		}
+		else
+		{
+			firstWord = candidateSpan.first;
+			lastWord = candidateSpan.last;
+		}
+
+		for (int w{ firstWord }; w <= lastWord; w++)
+		{
+			uint64_t validBits = w == m_WordsPerRow - 1 ? lastWordMask : ~uint64_t(0);
+			uint64_t candidates = m_FullPass ? validBits : pCandidates[w];
+			if (candidates == 0)
+				continue;
+			pCandidates[w] = 0;
+			evaluatedCells += PopCount64(candidates);
+
+			//The padding bits of the current row may hold the halo column, they are not part of the grid
+			uint64_t current = pRow[w] & validBits;
+			uint64_t next = current & ~candidates;
+			if (m_FullPass)
+			{
+				next = pNext[w] & validBits;
+			}
+			else
+			{
+				for (uint64_t bits{ candidates }; bits != 0; bits &= bits - 1)
+				{
+					int bit = CountTrailingZeros64(bits);
+					next |= NextState(pCounts, current, w * 64 + bit) << bit;
+				}
+			}
+
+			pNext[w] = next;
+			uint64_t changes = next ^ current;
+			if (changes != 0)
+			{
+				pChanges[w] = changes;
+				changeSpan.first = std::min(changeSpan.first, w);
+				changeSpan.last = std::max(changeSpan.last, w);
+			}
+		}
+
+		candidateSpan = WordSpan{ INT_MAX, -1 };
+	}
+
+	m_EvaluatedCells += evaluatedCells;
+}
+
+void NeighbourCountEngine::EndStep(Grid& grid)
+{
+	//The grid swapped already, so the changed cells read their new state from the current rows
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		WordSpan& changeSpan = m_ChangeSpans[y];
+		const uint64_t* pRow = grid.GetRow(y);
+		uint64_t* pChanges = m_Changes.data() + size_t(y) * m_WordsPerRow;
+		for (int w{ changeSpan.first }; w <= changeSpan.last; w++)
+		{
+			for (uint64_t bits{ pChanges[w] }; bits != 0; bits &= bits - 1)
+			{
+				int bit = CountTrailingZeros64(bits);
+				ApplyChange(w * 64 + bit, y, ((pRow[w] >> bit) & 1) != 0);
+			}
+			pChanges[w] = 0;
+		}
+		changeSpan = WordSpan{ INT_MAX, -1 };
+	}
+
+	m_pLastGrid = &grid;
+	m_ExpectedGeneration = grid.GetGeneration();
+	m_ExpectedEditVersion = grid.GetEditVersion();
+}
+
+void NeighbourCountEngine::ApplyChange(int x, int y, bool alive)
+{
+	for (int offsetY{ -1 }; offsetY <= 1; offsetY++)
+	{
+		for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+		{
+			//Across the top or bottom a Klein bottle mirrors the column before it wraps around left or right
+			int neighbourX = x + offsetX;
+			int neighbourY = y + offsetY;
+			if (unsigned(neighbourY) >= unsigned(m_Height))
+			{
+				if (m_Topology == Topology::DeadBorder)
+					continue;
+				neighbourY += neighbourY < 0 ? m_Height : -m_Height;
+				if (m_Topology == Topology::KleinBottle)
+					neighbourX = m_Width - 1 - neighbourX;
+			}
+			if (unsigned(neighbourX) >= unsigned(m_Width))
+			{
+				if (m_Topology == Topology::DeadBorder)
+					continue;
+				neighbourX += neighbourX < 0 ? m_Width : -m_Width;
+			}
+
+			size_t row = size_t(neighbourY) * m_WordsPerRow;
+			m_Candidates[row + neighbourX / 64] |= uint64_t(1) << (neighbourX % 64);
+			WordSpan& candidateSpan = m_CandidateSpans[neighbourY];
+			candidateSpan.first = std::min(candidateSpan.first, neighbourX / 64);
+			candidateSpan.last = std::max(candidateSpan.last, neighbourX / 64);
+
+			//The cell itself is a candidate because its state changed, it is not its own neighbour
+			if (offsetX == 0 && offsetY == 0)
+				continue;
+
+			uint64_t& counts = m_Counts[4 * row + neighbourX / 16];
+			uint64_t one = uint64_t(1) << ((neighbourX % 16) * 4);
+			if (alive)
+				counts += one;
+			else
+				counts -= one;
+		}
+	}
+}
+
+void NeighbourCountEngine::CountRow(const Grid& grid, int y)
+{
+	//The halo holds whatever lies across the border, so every row is counted the same way
+	const uint64_t* pAbove = grid.GetRow(y - 1);
+	const uint64_t* pRow = grid.GetRow(y);
+	const uint64_t* pBelow = grid.GetRow(y + 1);
+	uint64_t* pCounts = m_Counts.data() + size_t(y) * 4 * m_WordsPerRow;
+
+	for (int w{ 0 }; w < m_WordsPerRow; w++)
+	{
+		auto West = [w](const uint64_t* pWords)
+		{
+			return (pWords[w] << 1) | (pWords[w - 1] >> 63);
+		};
+		auto East = [w](const uint64_t* pWords)
+		{
+			return (pWords[w] >> 1) | (pWords[w + 1] << 63);
+		};
+
+		const uint64_t neighbours[8] = { West(pAbove), pAbove[w], East(pAbove), West(pRow), East(pRow), West(pBelow), pBelow[w], East(pBelow) };
+		for (int part{ 0 }; part < 4; part++)
+		{
+			uint64_t counts{ 0 };
+			for (uint64_t neighbour : neighbours)
+				counts += SpreadToNibbles(neighbour >> (16 * part));
+			pCounts[4 * w + part] = counts;
+		}
+	}
+}
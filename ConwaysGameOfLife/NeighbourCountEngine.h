@@ -0,0 +1,80 @@
+#pragma once
+#include "LifeEngine.h"
+#include "BitwiseKernel.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class Topology;
+
+//Incremental engine that keeps the number of alive neighbours of every cell, 4 bits per cell, 16 cells per word.
+//A cell that is born or dies adds or takes one off the counts of its 8 neighbours, and only the cells whose count
+//or state changed are evaluated in the next generation. The work of a generation follows the number of cells that
+//changed instead of the size of the grid, which suits large boards with little going on.
+//
+//Like ChangeTrackingEngine the cells that are not evaluated are already correct in the back buffer,
+//which only holds while this engine did the previous step. After an edit or a step by someone else
+//the counts are taken from the grid again in a full pass. ToggleCell edits a cell without losing them.
+class NeighbourCountEngine final : public LifeEngine
+{
+public:
+	NeighbourCountEngine();
+	virtual ~NeighbourCountEngine() = default;
+	NeighbourCountEngine(const NeighbourCountEngine& other) = delete;
+	NeighbourCountEngine(NeighbourCountEngine&& other) = delete;
+	NeighbourCountEngine& operator=(const NeighbourCountEngine& other) = delete;
+	NeighbourCountEngine& operator=(NeighbourCountEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+	virtual void SetRule(const Rule& rule) override;
+
+	//Toggles the cell on the grid and updates the counts of its neighbours, so the next step stays incremental.
+	//Falls back to Grid::ToggleCell when the counts do not belong to this grid.
+	void ToggleCell(Grid& grid, int x, int y);
+
+	//Number of cells that were evaluated in the last generation
+	uint64_t GetEvaluatedCellCount() const;
+	bool WasFullPass() const;
+
+protected:
+	virtual void BeginStep(Grid& grid) override;
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+	virtual void EndStep(Grid& grid) override;
+
+private:
+	//Words [first, last] of a row that may have bits set, first > last when there are none
+	struct WordSpan
+	{
+		int first;
+		int last;
+	};
+
+	const Grid* m_pLastGrid;
+	uint64_t m_ExpectedGeneration;
+	uint64_t m_ExpectedEditVersion;
+	bool m_FullPass;
+
+	int m_Width;
+	int m_Height;
+	int m_WordsPerRow;
+	Topology m_Topology;
+
+	//Neighbour counts of the current generation, cell x of row y is nibble x % 16 of word y * 4 * wordsPerRow + x / 16
+	std::vector<uint64_t> m_Counts;
+	//Cells to evaluate in the next step and cells the last step changed, laid out like the rows of the grid without halo.
+	//Every row is only written by the band that steps it, EndStep then walks the changes alone.
+	std::vector<uint64_t> m_Candidates;
+	std::vector<uint64_t> m_Changes;
+	std::vector<WordSpan> m_CandidateSpans;
+	std::vector<WordSpan> m_ChangeSpans;
+
+	std::atomic<uint64_t> m_EvaluatedCells;
+
+	//The SWAR kernel compiled for the rule steps the rows of a full pass
+	StepWordsFunction m_pStepWords;
+
+	bool IsInSync(const Grid& grid) const;
+	//Adds one to (alive) or takes one off the counts around the cell and makes it and its neighbours candidates
+	void ApplyChange(int x, int y, bool alive);
+	void CountRow(const Grid& grid, int y);
+};
@@ -82,21 +82,23 @@ int OpenGLRenderer::GetWindowHeight() const
 
 void OpenGLRenderer::Draw() const
 {
-    const std::vector<Cell>& cells = m_pGrid->GetCells();
+    int cellSize = m_pGrid->GetCellSize();
 
-    std::for_each(cells.begin(), cells.end(), [this](const Cell& cell)
+    for (int y{ 0 }; y < m_pGrid->GetHeight(); y++)
+    {
+        for (int x{ 0 }; x < m_pGrid->GetWidth(); x++)
         {
             float x1, x2;
             float y1, y2;
 			//Convert the spositions from x = [0, screenwidth] & y = [0, screenheight]
 			//to x & y = [-1 & 1]
-            x1 = ConvertToDeviceCoordinates(int(cell.position.x * cell.size), m_Width);
-            x2 = ConvertToDeviceCoordinates(int(cell.position.x * cell.size + cell.size), m_Width);
-            y1 = ConvertToDeviceCoordinates(int(cell.position.y * cell.size), m_Height);
-            y2 = ConvertToDeviceCoordinates(int(cell.position.y * cell.size + cell.size), m_Height);
+            x1 = ConvertToDeviceCoordinates(x * cellSize, m_Width);
+            x2 = ConvertToDeviceCoordinates(x * cellSize + cellSize, m_Width);
+            y1 = ConvertToDeviceCoordinates(y * cellSize, m_Height);
+            y2 = ConvertToDeviceCoordinates(y * cellSize + cellSize, m_Height);
 
 			//Fill the cell if it's alive, otherwhise draw the outline.
-            if (cell.alive)
+            if (m_pGrid->IsAlive(x, y))
                 glBegin(GL_QUADS);
             else
 	            glBegin(GL_LINE_LOOP);
@@ -106,9 +108,8 @@ void OpenGLRenderer::Draw() const
             glVertex2f(x2, y2);
             glVertex2f(x2, y1);
             glEnd();
-			
         }
-    );
+    }
 }
 
 float OpenGLRenderer::ConvertToDeviceCoordinates(int screenSpace, int width) const
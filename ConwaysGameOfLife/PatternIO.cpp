@@ -0,0 +1,509 @@
+#include "PatternIO.h"
+#include "Bits.h"
+#include "Cell.h"
+#include "CharReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+//Builds RLE lines of at most 70 characters, merging runs of the same kind that are added one after the other
+class RleWriter final
+{
+public:
+	RleWriter(std::ostream& stream)
+		: m_Stream(stream)
+		, m_Tag(0)
+		, m_Count(0)
+		, m_LineLength(0)
+	{
+	}
+
+	void Add(char tag, int64_t count)
+	{
+		if (count <= 0)
+			return;
+
+		if (tag != m_Tag)
+			Flush();
+
+		m_Tag = tag;
+		m_Count += count;
+	}
+
+	void Finish()
+	{
+		Flush();
+		m_Stream << "!\n";
+	}
+
+private:
+	static const int MaxLineLength = 70;
+
+	std::ostream& m_Stream;
+	char m_Tag;
+	int64_t m_Count;
+	int m_LineLength;
+
+	void Flush()
+	{
+		if (m_Count == 0)
+			return;
+
+		//A count of 1 is left out
+		char text[24];
+		int length = 0;
+		if (m_Count > 1)
+		{
+			std::string count = std::to_string(m_Count);
+			std::copy(count.begin(), count.end(), text);
+			length = int(count.size());
+		}
+		text[length++] = m_Tag;
+
+		if (m_LineLength + length > MaxLineLength)
+		{
+			m_Stream << '\n';
+			m_LineLength = 0;
+		}
+
+		m_Stream.write(text, length);
+		m_LineLength += length;
+		m_Count = 0;
+	}
+};
+
+static bool HasExtension(const std::string& path, const std::string& extension)
+{
+	if (path.size() < extension.size())
+		return false;
+
+	return std::equal(extension.rbegin(), extension.rend(), path.rbegin(), [](char a, char b)
+		{
+			return a == std::tolower((unsigned char)b);
+		});
+}
+
+static std::runtime_error ParseError(const char* pFormat, size_t line, const std::string& message)
+{
+	return std::runtime_error{ std::string{ pFormat } + " line " + std::to_string(line) + ": " + message };
+}
+
+//Appends the runs of alive cells in row y of the grid as (first x, length), runs crossing words are merged
+static void GetGridRowRuns(const Grid& grid, int y, std::vector<std::pair<int64_t, int64_t>>& runs)
+{
+	const uint64_t* pRow = grid.GetRow(y);
+	for (int w{ 0 }; w < grid.GetWordsPerRow(); w++)
+	{
+		uint64_t word = pRow[w];
+		while (word)
+		{
+			int start = CountTrailingZeros64(word);
+			uint64_t rest = ~(word >> start);
+			int length = rest == 0 ? 64 - start : CountTrailingZeros64(rest);
+
+			int64_t x = int64_t(w) * 64 + start;
+			if (!runs.empty() && runs.back().first + runs.back().second == x)
+				runs.back().second += length;
+			else
+				runs.emplace_back(x, length);
+
+			word = start + length == 64 ? 0 : word & ~((uint64_t(1) << (start + length)) - 1);
+		}
+	}
+}
+
+//Writes the runs of a row that starts at left, the dead cells after the last run are left out
+static void WriteRleRow(RleWriter& writer, const std::vector<std::pair<int64_t, int64_t>>& runs, int64_t left)
+{
+	int64_t x = left;
+	for (const std::pair<int64_t, int64_t>& run : runs)
+	{
+		writer.Add('b', run.first - x);
+		writer.Add('o', run.second);
+		x = run.first + run.second;
+	}
+}
+
+GridPatternSink::GridPatternSink(Grid& grid, int64_t offsetX, int64_t offsetY)
+	: m_Grid(grid)
+	, m_OffsetX(offsetX)
+	, m_OffsetY(offsetY)
+{
+}
+
+void GridPatternSink::AddRun(int64_t x, int64_t y, int64_t length)
+{
+	y += m_OffsetY;
+	int64_t first = std::max<int64_t>(x + m_OffsetX, 0);
+	int64_t last = std::min<int64_t>(x + m_OffsetX + length, m_Grid.GetWidth());
+	if (y < 0 || y >= m_Grid.GetHeight() || first >= last)
+		return;
+
+	//Set whole words at once instead of cell by cell
+	uint64_t* pRow = m_Grid.GetRow(int(y));
+	while (first < last)
+	{
+		int bit = int(first % 64);
+		int count = int(std::min<int64_t>(64 - bit, last - first));
+		uint64_t mask = count == 64 ? ~uint64_t(0) : ((uint64_t(1) << count) - 1) << bit;
+		pRow[first / 64] |= mask;
+		first += count;
+	}
+
+	m_Grid.MarkEdited();
+}
+
+HashLifePatternSink::HashLifePatternSink(HashLife& hashLife)
+	: m_HashLife(hashLife)
+	, m_pLastBlock(nullptr)
+{
+}
+
+void HashLifePatternSink::AddRun(int64_t x, int64_t y, int64_t length)
+{
+	//Rounds down for negative coordinates as well
+	int64_t blockY = y & ~int64_t(63);
+	while (length > 0)
+	{
+		int64_t blockX = x & ~int64_t(63);
+		if (!m_pLastBlock || m_pLastBlock->x != blockX || m_pLastBlock->y != blockY)
+		{
+			uint64_t key = (uint64_t(uint32_t(blockX >> 6)) << 32) | uint32_t(blockY >> 6);
+			auto it = m_BlockIndices.find(key);
+			if (it == m_BlockIndices.end())
+			{
+				it = m_BlockIndices.emplace(key, m_Blocks.size()).first;
+				m_Blocks.push_back(HashLife::Block{ blockX, blockY, {} });
+			}
+
+			m_pLastBlock = &m_Blocks[it->second];
+		}
+
+		int bit = int(x - blockX);
+		int count = int(std::min<int64_t>(64 - bit, length));
+		uint64_t mask = count == 64 ? ~uint64_t(0) : ((uint64_t(1) << count) - 1) << bit;
+		m_pLastBlock->rows[y - blockY] |= mask;
+
+		x += count;
+		length -= count;
+	}
+}
+
+void HashLifePatternSink::Finish()
+{
+	m_HashLife.LoadBlocks(m_Blocks);
+	m_Blocks.clear();
+	m_BlockIndices.clear();
+	m_pLastBlock = nullptr;
+}
+
+std::string PatternReader::ReadRle(std::istream& stream, PatternSink& sink)
+{
+	CharReader reader{ stream };
+	std::string rule;
+	std::string line;
+
+	int64_t x = 0;
+	int64_t y = 0;
+	int64_t originX = 0;
+	int64_t originY = 0;
+	int64_t count = 0;
+	bool lineStart = true;
+	bool inBody = false;
+
+	for (int c = reader.Get(); c != -1; c = reader.Get())
+	{
+		//Comments and the header only appear before the cells
+		if (lineStart && !inBody && (c == '#' || c == 'x'))
+		{
+			reader.ReadLine(line);
+			if (c == '#')
+			{
+				//Golly stores the position of the top left cell as "#CXRLE Pos=x,y"
+				size_t position = line.find("Pos=");
+				if (line.compare(0, 5, "CXRLE") == 0 && position != std::string::npos)
+				{
+					char* pEnd = nullptr;
+					originX = std::strtoll(line.c_str() + position + 4, &pEnd, 10);
+					if (*pEnd == ',')
+						originY = std::strtoll(pEnd + 1, nullptr, 10);
+				}
+				continue;
+			}
+
+			//"x = 3, y = 3, rule = B3/S23", only the rule is needed since the cells end up where the runs say
+			size_t position = line.find("rule");
+			if (position != std::string::npos)
+			{
+				position = line.find('=', position);
+				if (position == std::string::npos)
+					throw ParseError("RLE", reader.GetLine() - 1, "missing rule value");
+
+				size_t first = line.find_first_not_of(" \t", position + 1);
+				size_t last = line.find_last_not_of(" \t");
+				if (first != std::string::npos)
+					rule = line.substr(first, last - first + 1);
+			}
+			continue;
+		}
+
+		lineStart = c == '\n';
+		if (c >= '0' && c <= '9')
+		{
+			count = count * 10 + (c - '0');
+			if (count > (int64_t(1) << 40))
+				throw ParseError("RLE", reader.GetLine(), "run length is too long");
+			continue;
+		}
+
+		if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+			continue;
+
+		inBody = true;
+		int64_t run = count == 0 ? 1 : count;
+		count = 0;
+
+		if (c == 'b' || c == '.')
+		{
+			x += run;
+		}
+		else if (c == '$')
+		{
+			x = 0;
+			y += run;
+		}
+		else if (c == '!')
+		{
+			break;
+		}
+		else if (c == 'o' || (c >= 'A' && c <= 'X'))
+		{
+			//Multi state letters count as alive
+			sink.AddRun(originX + x, originY + y, run);
+			x += run;
+		}
+		else
+		{
+			throw ParseError("RLE", reader.GetLine(), std::string{ "unexpected character '" } + char(c) + "'");
+		}
+	}
+
+	return rule;
+}
+
+std::string PatternReader::ReadMacrocell(std::istream& stream, PatternSink& sink)
+{
+	//The file is a quadtree already, let HashLife build it and hand out its rows
+	HashLife hashLife{};
+	hashLife.ReadMacrocell(stream);
+
+	int64_t left, top, right, bottom;
+	if (hashLife.GetBoundingBox(left, top, right, bottom))
+	{
+		std::vector<std::pair<int64_t, int64_t>> runs;
+		for (int64_t y{ top }; y < bottom; y++)
+		{
+			runs.clear();
+			hashLife.GetRowRuns(y, runs);
+			for (const std::pair<int64_t, int64_t>& run : runs)
+				sink.AddRun(run.first, y, run.second);
+		}
+	}
+
+	return hashLife.GetRule().ToString();
+}
+
+std::string PatternReader::ReadPlaintext(std::istream& stream, PatternSink& sink)
+{
+	CharReader reader{ stream };
+	int64_t x = 0;
+	int64_t y = 0;
+	int64_t runStart = -1;
+
+	//Lines starting with ! are comments, O or * is alive and anything else is dead
+	for (int c = reader.Get(); c != -1; c = reader.Get())
+	{
+		if (x == 0 && c == '!')
+		{
+			reader.SkipLine();
+			continue;
+		}
+
+		bool alive = c == 'O' || c == '*';
+		if (alive && runStart < 0)
+			runStart = x;
+
+		if (!alive && runStart >= 0)
+		{
+			sink.AddRun(runStart, y, x - runStart);
+			runStart = -1;
+		}
+
+		if (c == '\n')
+		{
+			x = 0;
+			++y;
+		}
+		else if (c != '\r')
+		{
+			++x;
+		}
+	}
+
+	if (runStart >= 0)
+		sink.AddRun(runStart, y, x - runStart);
+
+	return std::string{};
+}
+
+std::string PatternReader::ReadFile(const std::string& path, PatternSink& sink)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file)
+		throw std::runtime_error{ "Could not open pattern " + path };
+
+	if (HasExtension(path, ".mc"))
+		return ReadMacrocell(file, sink);
+	if (HasExtension(path, ".cells"))
+		return ReadPlaintext(file, sink);
+
+	return ReadRle(file, sink);
+}
+
+std::string PatternReader::LoadFile(const std::string& path, HashLife& hashLife)
+{
+	std::ifstream file{ path, std::ios::binary };
+	if (!file)
+		throw std::runtime_error{ "Could not open pattern " + path };
+
+	if (HasExtension(path, ".mc"))
+	{
+		hashLife.ReadMacrocell(file);
+		return hashLife.GetRule().ToString();
+	}
+
+	HashLifePatternSink sink{ hashLife };
+	std::string rule = HasExtension(path, ".cells") ? ReadPlaintext(file, sink) : ReadRle(file, sink);
+	sink.Finish();
+
+	//Files for the other engines carry rules in their own notation, the caller decides what to do with those
+	if (!rule.empty())
+	{
+		try
+		{
+			hashLife.SetRule(Rule::Parse(rule));
+		}
+		catch (const std::runtime_error&)
+		{
+		}
+	}
+
+	return rule;
+}
+
+void PatternWriter::WriteRle(const Grid& grid, const std::string& rule, std::ostream& stream)
+{
+	//Bounding box of the alive cells, only looking at the words
+	int left = grid.GetWidth();
+	int right = 0;
+	int top = -1;
+	int bottom = 0;
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		const uint64_t* pRow = grid.GetRow(y);
+		for (int w{ 0 }; w < grid.GetWordsPerRow(); w++)
+		{
+			if (pRow[w] == 0)
+				continue;
+
+			if (top < 0)
+				top = y;
+			bottom = y + 1;
+			left = std::min(left, w * 64 + CountTrailingZeros64(pRow[w]));
+			right = std::max(right, w * 64 + 64 - CountLeadingZeros64(pRow[w]));
+		}
+	}
+
+	if (top < 0)
+	{
+		stream << "x = 0, y = 0, rule = " << rule << "\n!\n";
+		return;
+	}
+
+	stream << "#CXRLE Pos=" << left << "," << top << "\n";
+	stream << "x = " << right - left << ", y = " << bottom - top << ", rule = " << rule << "\n";
+
+	RleWriter writer{ stream };
+	std::vector<std::pair<int64_t, int64_t>> runs;
+	for (int y{ top }; y < bottom; y++)
+	{
+		runs.clear();
+		GetGridRowRuns(grid, y, runs);
+
+		WriteRleRow(writer, runs, left);
+		if (y + 1 < bottom)
+			writer.Add('$', 1);
+	}
+
+	writer.Finish();
+}
+
+void PatternWriter::WriteRle(const HashLife& hashLife, std::ostream& stream)
+{
+	std::string rule = hashLife.GetRule().ToString();
+	int64_t left, top, right, bottom;
+	if (!hashLife.GetBoundingBox(left, top, right, bottom))
+	{
+		stream << "x = 0, y = 0, rule = " << rule << "\n!\n";
+		return;
+	}
+
+	stream << "#CXRLE Pos=" << left << "," << top << " Gen=" << hashLife.GetGeneration() << "\n";
+	stream << "x = " << right - left << ", y = " << bottom - top << ", rule = " << rule << "\n";
+
+	RleWriter writer{ stream };
+	std::vector<std::pair<int64_t, int64_t>> runs;
+	for (int64_t y{ top }; y < bottom; y++)
+	{
+		runs.clear();
+		hashLife.GetRowRuns(y, runs);
+
+		WriteRleRow(writer, runs, left);
+		if (y + 1 < bottom)
+			writer.Add('$', 1);
+	}
+
+	writer.Finish();
+}
+
+void PatternWriter::WriteMacrocell(const HashLife& hashLife, std::ostream& stream)
+{
+	hashLife.WriteMacrocell(stream);
+}
+
+void PatternWriter::WriteFile(const std::string& path, const Grid& grid, const std::string& rule)
+{
+	std::ofstream file{ path, std::ios::binary };
+	if (!file)
+		throw std::runtime_error{ "Could not create pattern " + path };
+
+	WriteRle(grid, rule, file);
+}
+
+void PatternWriter::WriteFile(const std::string& path, const HashLife& hashLife)
+{
+	std::ofstream file{ path, std::ios::binary };
+	if (!file)
+		throw std::runtime_error{ "Could not create pattern " + path };
+
+	if (HasExtension(path, ".mc"))
+		WriteMacrocell(hashLife, file);
+	else
+		WriteRle(hashLife, file);
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "HashLife.h"
+
+class Grid;
+
+//Receives the alive cells of a pattern while it is being parsed, so no reader needs a dense copy of the pattern
+class PatternSink
+{
+public:
+	PatternSink() = default;
+	virtual ~PatternSink() = default;
+	PatternSink(const PatternSink& other) = delete;
+	PatternSink(PatternSink&& other) = delete;
+	PatternSink& operator=(const PatternSink& other) = delete;
+	PatternSink& operator=(PatternSink&& other) = delete;
+
+	//Cells x up to x + length - 1 of row y are alive, (0, 0) is the top left of the pattern
+	virtual void AddRun(int64_t x, int64_t y, int64_t length) = 0;
+};
+
+//Writes the pattern into a grid with its top left cell at (offsetX, offsetY), cells outside of the grid are dropped
+class GridPatternSink final : public PatternSink
+{
+public:
+	GridPatternSink(Grid& grid, int64_t offsetX = 0, int64_t offsetY = 0);
+	virtual ~GridPatternSink() = default;
+	GridPatternSink(const GridPatternSink& other) = delete;
+	GridPatternSink(GridPatternSink&& other) = delete;
+	GridPatternSink& operator=(const GridPatternSink& other) = delete;
+	GridPatternSink& operator=(GridPatternSink&& other) = delete;
+
+	virtual void AddRun(int64_t x, int64_t y, int64_t length) override;
+
+private:
+	Grid& m_Grid;
+	int64_t m_OffsetX;
+	int64_t m_OffsetY;
+};
+
+//Collects the pattern in 64x64 blocks, Finish replaces the universe with them in one bottom up build
+class HashLifePatternSink final : public PatternSink
+{
+public:
+	HashLifePatternSink(HashLife& hashLife);
+	virtual ~HashLifePatternSink() = default;
+	HashLifePatternSink(const HashLifePatternSink& other) = delete;
+	HashLifePatternSink(HashLifePatternSink&& other) = delete;
+	HashLifePatternSink& operator=(const HashLifePatternSink& other) = delete;
+	HashLifePatternSink& operator=(HashLifePatternSink&& other) = delete;
+
+	virtual void AddRun(int64_t x, int64_t y, int64_t length) override;
+	void Finish();
+
+private:
+	HashLife& m_HashLife;
+	std::vector<HashLife::Block> m_Blocks;
+	std::unordered_map<uint64_t, size_t> m_BlockIndices;
+	HashLife::Block* m_pLastBlock;	//Runs mostly land in the same block as the run before them
+};
+
+//Reads RLE (.rle), Macrocell (.mc) and plaintext (.cells) patterns.
+//The readers return the rule stored in the file, or an empty string when there is none.
+//Malformed files throw std::runtime_error.
+class PatternReader final
+{
+public:
+	PatternReader() = delete;
+
+	static std::string ReadRle(std::istream& stream, PatternSink& sink);
+	static std::string ReadMacrocell(std::istream& stream, PatternSink& sink);
+	static std::string ReadPlaintext(std::istream& stream, PatternSink& sink);
+
+	//Picks the format from the extension of the file
+	static std::string ReadFile(const std::string& path, PatternSink& sink);
+	//Replaces the universe with the file, macrocell files are read without any conversion.
+	//The rule of the file is applied when HashLife can run it.
+	static std::string LoadFile(const std::string& path, HashLife& hashLife);
+};
+
+//Writes RLE and Macrocell patterns straight from the bit rows or the quadtree, without a dense copy of the cells
+class PatternWriter final
+{
+public:
+	PatternWriter() = delete;
+
+	static void WriteRle(const Grid& grid, const std::string& rule, std::ostream& stream);
+	static void WriteRle(const HashLife& hashLife, std::ostream& stream);
+	static void WriteMacrocell(const HashLife& hashLife, std::ostream& stream);
+
+	//Picks the format from the extension of the file, a grid can only be saved as RLE
+	static void WriteFile(const std::string& path, const Grid& grid, const std::string& rule);
+	static void WriteFile(const std::string& path, const HashLife& hashLife);
+};
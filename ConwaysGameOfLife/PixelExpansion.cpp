@@ -0,0 +1,227 @@
+#include "PixelExpansion.h"
+#include "Bits.h"
+#include "Cell.h"
+#include "DensityPyramid.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_EXPANSION_SSE2
+#include <emmintrin.h>
+#endif
+
+//Cell size 1: every bit becomes one pixel
+static void ExpandBits(const uint64_t* pRow, int width, uint32_t alive, uint32_t dead, uint32_t* pPixels)
+{
+	int x = 0;
+
+#if defined(PIXEL_EXPANSION_SSE2)
+	//Spread 4 bits over the 4 lanes, compare every lane with its own bit and pick the color with the mask
+	const __m128i bitSelect = _mm_set_epi32(8, 4, 2, 1);
+	const __m128i aliveColor = _mm_set1_epi32(int(alive));
+	const __m128i deadColor = _mm_set1_epi32(int(dead));
+	for (; x + 4 <= width; x += 4)
+	{
+		int bits = int((pRow[x >> 6] >> (x & 63)) & 0xF);
+		__m128i selected = _mm_and_si128(_mm_set1_epi32(bits), bitSelect);
+		__m128i mask = _mm_cmpeq_epi32(selected, bitSelect);
+		__m128i pixels = _mm_or_si128(_mm_and_si128(mask, aliveColor), _mm_andnot_si128(mask, deadColor));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pPixels + x), pixels);
+	}
+#endif
+
+	for (; x < width; x++)
+		pPixels[x] = ((pRow[x >> 6] >> (x & 63)) & 1) ? alive : dead;
+}
+
+//Larger cells: fill whole runs of equal cells at once
+static void ExpandRuns(const uint64_t* pRow, int width, int cellSize, uint32_t alive, uint32_t dead, uint32_t* pPixels)
+{
+	int x = 0;
+	while (x < width)
+	{
+		//Find where the current run ends by looking for the first bit that differs from it
+		bool isAlive = (pRow[x >> 6] >> (x & 63)) & 1;
+		int end = x;
+		while (end < width)
+		{
+			uint64_t word = pRow[end >> 6] >> (end & 63);
+			uint64_t different = isAlive ? ~word : word;
+			int bitsLeft = 64 - (end & 63);
+			if (bitsLeft < 64)
+				different |= ~uint64_t(0) << bitsLeft;
+
+			//Bits shifted in from past the word count as different, a run that reaches them goes on in the next word
+			int run = different ? CountTrailingZeros64(different) : 64;
+			end += run;
+			if (run < bitsLeft)
+				break;
+		}
+		end = std::min(end, width);
+
+		std::fill(pPixels + size_t(x) * cellSize, pPixels + size_t(end) * cellSize, isAlive ? alive : dead);
+		x = end;
+	}
+}
+
+void PixelExpansion::ExpandRow(const uint64_t* pRow, int width, int cellSize, uint32_t alive, uint32_t dead, uint32_t* pPixels)
+{
+	if (cellSize == 1)
+		ExpandBits(pRow, width, alive, dead, pPixels);
+	else
+		ExpandRuns(pRow, width, cellSize, alive, dead, pPixels);
+}
+
+void PixelExpansion::ExpandRows(const Grid& grid, int firstRow, int lastRow, uint32_t alive, uint32_t dead, void* pPixels, int pitch)
+{
+	int cellSize = grid.GetCellSize();
+	size_t rowBytes = size_t(grid.GetWidth()) * cellSize * sizeof(uint32_t);
+	char* pTarget = static_cast<char*>(pPixels);
+
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		//Expand the first pixel row of the cells once, the others are copies of it
+		uint32_t* pFirst = reinterpret_cast<uint32_t*>(pTarget);
+		ExpandRow(grid.GetRow(y), grid.GetWidth(), cellSize, alive, dead, pFirst);
+		pTarget += pitch;
+
+		for (int copy{ 1 }; copy < cellSize; copy++)
+		{
+			std::memcpy(pTarget, pFirst, rowBytes);
+			pTarget += pitch;
+		}
+	}
+}
+
+void PixelExpansion::DrawGridLines(int width, int height, int cellSize, uint32_t color, void* pPixels, int pitch)
+{
+	//Same outline as drawing a rectangle around every cell: its first and last pixel row and column
+	int pixelWidth = width * cellSize;
+	int pixelHeight = height * cellSize;
+	char* pTarget = static_cast<char*>(pPixels);
+
+	for (int py{ 0 }; py < pixelHeight; py++)
+	{
+		uint32_t* pRow = reinterpret_cast<uint32_t*>(pTarget + size_t(py) * pitch);
+		int inCell = py % cellSize;
+		if (inCell == 0 || inCell == cellSize - 1)
+		{
+			std::fill(pRow, pRow + pixelWidth, color);
+			continue;
+		}
+
+		std::fill(pRow, pRow + pixelWidth, uint32_t(0));
+		for (int x{ 0 }; x < width; x++)
+		{
+			pRow[x * cellSize] = color;
+			pRow[x * cellSize + cellSize - 1] = color;
+		}
+	}
+}
+
+//Mixes the colors channel by channel, amount runs from 0 (all from) to 256 (all to)
+static uint32_t BlendColor(uint32_t from, uint32_t to, uint32_t amount)
+{
+	uint32_t result{ 0 };
+	for (int shift{ 0 }; shift < 32; shift += 8)
+	{
+		uint32_t a = (from >> shift) & 0xFF;
+		uint32_t b = (to >> shift) & 0xFF;
+		result |= ((a * (256 - amount) + b * amount) >> 8) << shift;
+	}
+	return result;
+}
+
+void PixelExpansion::ExpandView(const DensityPyramid& pyramid, int level, int originX, int originY, int cellPixels,
+	uint32_t alive, uint32_t dead, uint32_t outside, void* pPixels, int pitch, int width, int height)
+{
+	int levelWidth = pyramid.GetLevelWidth(level);
+	int levelHeight = pyramid.GetLevelHeight(level);
+	int firstX = originX >> level;
+	int firstY = originY >> level;
+	int blockCount = (width + cellPixels - 1) / cellPixels;
+	size_t rowBytes = size_t(width) * sizeof(uint32_t);
+	char* pTarget = static_cast<char*>(pPixels);
+
+	//Every possible share of alive cells gets its color once. A lone glider in a block of a million cells still lights up its pixel a bit.
+	uint32_t palette[257];
+	for (uint32_t amount{ 0 }; amount <= 256; amount++)
+		palette[amount] = BlendColor(dead, alive, amount == 0 ? 0 : std::max(amount, 64u));
+
+	std::vector<uint32_t> populations(blockCount);
+	for (int py{ 0 }; py < height; py += cellPixels)
+	{
+		int blockY = firstY + py / cellPixels;
+		uint32_t* pFirst = reinterpret_cast<uint32_t*>(pTarget + size_t(py) * pitch);
+		pyramid.GetRowPopulations(level, blockY, firstX, blockCount, populations.data());
+
+		for (int block{ 0 }; block < blockCount; block++)
+		{
+			int blockX = firstX + block;
+			uint32_t color = outside;
+			if (blockX >= 0 && blockY >= 0 && blockX < levelWidth && blockY < levelHeight)
+			{
+				//Rounded up, so a block with any alive cell never ends up as dead
+				uint64_t amount = ((uint64_t(populations[block]) << 8) + (uint64_t(1) << (2 * level)) - 1) >> (2 * level);
+				color = palette[std::min<uint64_t>(amount, 256)];
+			}
+
+			int px = block * cellPixels;
+			if (cellPixels == 1)
+				pFirst[px] = color;
+			else
+				std::fill(pFirst + px, pFirst + std::min(px + cellPixels, width), color);
+		}
+
+		//The other pixel rows of these blocks are copies of the first
+		for (int copy{ 1 }; copy < cellPixels && py + copy < height; copy++)
+			std::memcpy(pTarget + size_t(py + copy) * pitch, pFirst, rowBytes);
+	}
+}
+
+DirtyRows::DirtyRows()
+	: m_Width(0)
+	, m_Height(0)
+	, m_Valid(false)
+{
+}
+
+void DirtyRows::Update(const Grid& grid, std::vector<std::pair<int, int>>& ranges)
+{
+	ranges.clear();
+
+	if (!m_Valid || m_Width != grid.GetWidth() || m_Height != grid.GetHeight() || grid.IsEverythingChangedSince(m_Mark))
+	{
+		m_Width = grid.GetWidth();
+		m_Height = grid.GetHeight();
+		m_Mark = grid.GetChangeMark();
+		m_Valid = true;
+
+		ranges.push_back(std::make_pair(0, m_Height));
+		return;
+	}
+
+	//Checking a row costs one stamp per 4096 cells, uploading it costs cellSize^2 pixels of 4 bytes per cell
+	int chunksPerRow = grid.GetChangeChunksPerRow();
+	for (int y{ 0 }; y < m_Height; y++)
+	{
+		bool changed = false;
+		for (int chunk{ 0 }; chunk < chunksPerRow && !changed; chunk++)
+			changed = grid.IsChunkChangedSince(m_Mark, y, chunk);
+		if (!changed)
+			continue;
+
+		if (!ranges.empty() && ranges.back().second == y)
+			ranges.back().second = y + 1;
+		else
+			ranges.push_back(std::make_pair(y, y + 1));
+	}
+
+	m_Mark = grid.GetChangeMark();
+}
+
+void DirtyRows::Invalidate()
+{
+	m_Valid = false;
+}
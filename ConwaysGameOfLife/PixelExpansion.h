@@ -0,0 +1,56 @@
+#pragma once
+#include "Cell.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class DensityPyramid;
+
+//Turns the packed grid into 32 bit pixels for a streaming texture, one square of cellSize x cellSize pixels per cell.
+//Nothing in here depends on a window, so the output can be compared buffer against buffer.
+class PixelExpansion final
+{
+public:
+	PixelExpansion() = delete;
+
+	//One row of cells into one row of width * cellSize pixels.
+	//For a cell size of 1 the bits are expanded 4 pixels at a time with SSE2, larger cells are filled run by run.
+	static void ExpandRow(const uint64_t* pRow, int width, int cellSize, uint32_t alive, uint32_t dead, uint32_t* pPixels);
+
+	//Grid rows [firstRow, lastRow) into cellSize pixel rows each, pitch is the distance between pixel rows in bytes.
+	//pPixels points at the first pixel of firstRow.
+	static void ExpandRows(const Grid& grid, int firstRow, int lastRow, uint32_t alive, uint32_t dead, void* pPixels, int pitch);
+
+	//Outline of every cell in the color, transparent (0) everywhere else. Meant to be drawn over the cells.
+	static void DrawGridLines(int width, int height, int cellSize, uint32_t color, void* pPixels, int pitch);
+
+	//A width x height pixel window onto a grid of any size, one pyramid lookup per square of cellPixels x cellPixels pixels.
+	//The square at (0, 0) shows the block of the level that holds cell (originX, originY), at level 0 that cell itself.
+	//Blocks are shaded from dead to alive by the part of their cells that is alive, space past the grid gets the outside color.
+	static void ExpandView(const DensityPyramid& pyramid, int level, int originX, int originY, int cellPixels,
+		uint32_t alive, uint32_t dead, uint32_t outside, void* pPixels, int pitch, int width, int height);
+};
+
+//Remembers where in its change history the grid was last drawn, so only the rows that changed since then have to be uploaded
+class DirtyRows final
+{
+public:
+	DirtyRows();
+	~DirtyRows() = default;
+	DirtyRows(const DirtyRows& other) = delete;
+	DirtyRows(DirtyRows&& other) = delete;
+	DirtyRows& operator=(const DirtyRows& other) = delete;
+	DirtyRows& operator=(DirtyRows&& other) = delete;
+
+	//Fills ranges with the [first, last) runs of rows that changed since the previous call, see Grid::GetChangeMark.
+	//The first call, a grid of a different size, a grid that can not tell what changed or a call after Invalidate marks every row.
+	void Update(const Grid& grid, std::vector<std::pair<int, int>>& ranges);
+	void Invalidate();
+
+private:
+	ChangeMark m_Mark;
+	int m_Width;
+	int m_Height;
+	bool m_Valid;
+};
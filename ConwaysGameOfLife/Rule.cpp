@@ -0,0 +1,314 @@
+#include "Rule.h"
+#include <stdexcept>
+#include <sstream>
+#include <cctype>
+
+static uint16_t ParseCounts(const std::string& counts, const std::string& rulestring)
+{
+	uint16_t mask = 0;
+	for (char c : counts)
+	{
+		if (c < '0' || c > '8')
+			throw std::runtime_error{ "Invalid neighbour count in rule \"" + rulestring + "\"" };
+
+		mask |= uint16_t(1 << (c - '0'));
+	}
+
+	return mask;
+}
+
+Rule Rule::Parse(const std::string& rulestring)
+{
+	//Spaces are allowed anywhere, they carry no meaning
+	std::string text;
+	for (char c : rulestring)
+	{
+		if (c != ' ')
+			text += c;
+	}
+
+	bool hasLetters = text.find_first_of("BbSs") != std::string::npos;
+	Rule rule{};
+
+	if (hasLetters)
+	{
+		//B/S notation, the letters say which mask the digits after them belong to
+		std::string birth, survival;
+		std::string* pCounts = nullptr;
+		for (char c : text)
+		{
+			if (c == 'B' || c == 'b')
+				pCounts = &birth;
+			else if (c == 'S' || c == 's')
+				pCounts = &survival;
+			else if (c == '/')
+				continue;
+			else if (pCounts)
+				*pCounts += c;
+			else
+				throw std::runtime_error{ "Invalid rule \"" + rulestring + "\"" };
+		}
+
+		rule.birthMask = ParseCounts(birth, rulestring);
+		rule.survivalMask = ParseCounts(survival, rulestring);
+	}
+	else
+	{
+		//S/B notation, survival counts come first
+		size_t slash = text.find('/');
+		if (slash == std::string::npos || text.find('/', slash + 1) != std::string::npos)
+			throw std::runtime_error{ "Invalid rule \"" + rulestring + "\"" };
+
+		rule.survivalMask = ParseCounts(text.substr(0, slash), rulestring);
+		rule.birthMask = ParseCounts(text.substr(slash + 1), rulestring);
+	}
+
+	return rule;
+}
+
+Rule Rule::Conway()
+{
+	return Rule{};
+}
+
+bool Rule::IsBorn(int neighbours) const
+{
+	return (birthMask >> neighbours) & 1;
+}
+
+bool Rule::Survives(int neighbours) const
+{
+	return (survivalMask >> neighbours) & 1;
+}
+
+std::string Rule::ToString() const
+{
+	std::string text = "B";
+	for (int n{ 0 }; n <= 8; n++)
+	{
+		if (IsBorn(n))
+			text += char('0' + n);
+	}
+
+	text += "/S";
+	for (int n{ 0 }; n <= 8; n++)
+	{
+		if (Survives(n))
+			text += char('0' + n);
+	}
+
+	return text;
+}
+
+bool Rule::operator==(const Rule& other) const
+{
+	return birthMask == other.birthMask && survivalMask == other.survivalMask;
+}
+
+bool Rule::operator!=(const Rule& other) const
+{
+	return !(*this == other);
+}
+
+const int GenerationsRule::MaxStateCount;
+
+GenerationsRule GenerationsRule::Parse(const std::string& rulestring)
+{
+	GenerationsRule generationsRule{};
+	generationsRule.stateCount = 2;
+
+	//The state count is the part after the second slash, the rest is a normal rule
+	size_t firstSlash = rulestring.find('/');
+	size_t secondSlash = firstSlash == std::string::npos ? std::string::npos : rulestring.find('/', firstSlash + 1);
+	if (secondSlash == std::string::npos)
+	{
+		generationsRule.rule = Rule::Parse(rulestring);
+		return generationsRule;
+	}
+
+	generationsRule.rule = Rule::Parse(rulestring.substr(0, secondSlash));
+
+	std::string states;
+	for (char c : rulestring.substr(secondSlash + 1))
+	{
+		if (c != ' ' && c != 'C' && c != 'c')
+			states += c;
+	}
+
+	if (states.empty() || states.size() > 3 || states.find_first_not_of("0123456789") != std::string::npos)
+		throw std::runtime_error{ "Invalid state count in rule \"" + rulestring + "\"" };
+
+	generationsRule.stateCount = std::stoi(states);
+	if (generationsRule.stateCount < 2 || generationsRule.stateCount > MaxStateCount)
+		throw std::runtime_error{ "State count out of range in rule \"" + rulestring + "\"" };
+
+	return generationsRule;
+}
+
+GenerationsRule GenerationsRule::BriansBrain()
+{
+	GenerationsRule generationsRule{};
+	generationsRule.rule.birthMask = 1 << 2;
+	generationsRule.rule.survivalMask = 0;
+	generationsRule.stateCount = 3;
+	return generationsRule;
+}
+
+std::string GenerationsRule::ToString() const
+{
+	return rule.ToString() + "/C" + std::to_string(stateCount);
+}
+
+const int LargerThanLifeRule::MaxRadius;
+
+static bool ParseRange(const std::string& text, int& min, int& max)
+{
+	//Either a single count or "min..max"
+	size_t dots = text.find("..");
+	std::string first = dots == std::string::npos ? text : text.substr(0, dots);
+	std::string second = dots == std::string::npos ? text : text.substr(dots + 2);
+
+	if (first.empty() || second.empty() || first.size() > 6 || second.size() > 6
+		|| first.find_first_not_of("0123456789") != std::string::npos
+		|| second.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	min = std::stoi(first);
+	max = std::stoi(second);
+	return true;
+}
+
+LargerThanLifeRule LargerThanLifeRule::Parse(const std::string& rulestring)
+{
+	LargerThanLifeRule rule{};
+	bool valid = true;
+
+	std::stringstream stream{ rulestring };
+	std::string token;
+	while (valid && std::getline(stream, token, ','))
+	{
+		//Spaces carry no meaning and the letters are case insensitive
+		std::string text;
+		for (char c : token)
+		{
+			if (c != ' ')
+				text += char(toupper(c));
+		}
+
+		if (text.size() < 2)
+		{
+			valid = false;
+			continue;
+		}
+
+		std::string value = text.substr(1);
+		int min = 0, max = 0;
+		switch (text[0])
+		{
+		case 'R':
+			valid = ParseRange(value, min, max) && min == max && min >= 1 && min <= MaxRadius;
+			rule.radius = min;
+			break;
+		case 'C':
+			//C1 would be a rule with a single state
+			valid = value == "0" || value == "2";
+			break;
+		case 'M':
+			valid = value == "0" || value == "1";
+			rule.countsCenter = value == "1";
+			break;
+		case 'S':
+			valid = ParseRange(value, rule.survivalMin, rule.survivalMax) && rule.survivalMin <= rule.survivalMax;
+			break;
+		case 'B':
+			valid = ParseRange(value, rule.birthMin, rule.birthMax) && rule.birthMin <= rule.birthMax;
+			break;
+		case 'N':
+			valid = value == "M" || value == "N";
+			rule.neighbourhood = value == "M" ? Neighbourhood::Moore : Neighbourhood::VonNeumann;
+			break;
+		default:
+			valid = false;
+			break;
+		}
+	}
+
+	if (!valid)
+		throw std::runtime_error{ "Invalid Larger than Life rule \"" + rulestring + "\"" };
+
+	return rule;
+}
+
+LargerThanLifeRule LargerThanLifeRule::FromRule(const Rule& rule)
+{
+	//Turns a mask into a range, a mask with a gap in it has no range
+	auto ToRange = [&rule](uint16_t mask, int& min, int& max)
+	{
+		if (mask == 0)
+		{
+			//No count matches, a count past the 8 neighbours does the same and still parses
+			min = 9;
+			max = 9;
+			return;
+		}
+
+		min = 0;
+		while (((mask >> min) & 1) == 0)
+			++min;
+		max = min;
+		while (max < 8 && (mask >> (max + 1)) & 1)
+			++max;
+
+		if ((mask >> (max + 1)) != 0)
+			throw std::runtime_error{ "Rule " + rule.ToString() + " has no Larger than Life equivalent" };
+	};
+
+	LargerThanLifeRule result{};
+	result.radius = 1;
+	result.countsCenter = false;
+	result.neighbourhood = Neighbourhood::Moore;
+	ToRange(rule.birthMask, result.birthMin, result.birthMax);
+	ToRange(rule.survivalMask, result.survivalMin, result.survivalMax);
+	return result;
+}
+
+bool LargerThanLifeRule::IsLifeLike() const
+{
+	return radius == 1 && neighbourhood == Neighbourhood::Moore;
+}
+
+Rule LargerThanLifeRule::ToRule() const
+{
+	//Counts that include the center are one higher for an alive cell
+	Rule rule{};
+	rule.birthMask = 0;
+	rule.survivalMask = 0;
+	int self = countsCenter ? 1 : 0;
+	for (int neighbours{ 0 }; neighbours <= 8; neighbours++)
+	{
+		if (IsBorn(neighbours))
+			rule.birthMask |= uint16_t(1 << neighbours);
+		if (Survives(neighbours + self))
+			rule.survivalMask |= uint16_t(1 << neighbours);
+	}
+
+	return rule;
+}
+
+bool LargerThanLifeRule::IsBorn(int neighbours) const
+{
+	return neighbours >= birthMin && neighbours <= birthMax;
+}
+
+bool LargerThanLifeRule::Survives(int neighbours) const
+{
+	return neighbours >= survivalMin && neighbours <= survivalMax;
+}
+
+std::string LargerThanLifeRule::ToString() const
+{
+	return "R" + std::to_string(radius) + ",C0,M" + (countsCenter ? "1" : "0")
+		+ ",S" + std::to_string(survivalMin) + ".." + std::to_string(survivalMax)
+		+ ",B" + std::to_string(birthMin) + ".." + std::to_string(birthMax)
+		+ (neighbourhood == Neighbourhood::Moore ? ",NM" : ",NN");
+}
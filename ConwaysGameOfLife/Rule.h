@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+//Outer-totalistic rule for two-state automata on the Moore neighbourhood ("Life-like" rules).
+//Bit n of a mask is set when a cell with n alive neighbours is born (birthMask) or stays alive (survivalMask).
+struct Rule
+{
+public:
+	uint16_t birthMask = 1 << 3;
+	uint16_t survivalMask = (1 << 2) | (1 << 3);
+
+	//Accepts B/S notation ("B36/S23", "b3s23", "B2/S") and the older S/B notation ("23/36").
+	//Throws std::runtime_error when the string is not a valid rule.
+	static Rule Parse(const std::string& rulestring);
+	static Rule Conway();
+
+	bool IsBorn(int neighbours) const;
+	bool Survives(int neighbours) const;
+	std::string ToString() const;
+
+	bool operator==(const Rule& other) const;
+	bool operator!=(const Rule& other) const;
+};
+
+//Rule for the Generations family: a Life-like rule where cells that die go through stateCount - 2 dying states
+//before they are dead. Dying cells do not count as neighbours and cannot be born again until they are dead.
+struct GenerationsRule
+{
+public:
+	static const int MaxStateCount = 256;
+
+	Rule rule{};
+	int stateCount = 3;
+
+	//Accepts "B2/S/C3", "B2/S/3" and the S/B/C form "/2/3", a rule without a state count has 2 states.
+	//Throws std::runtime_error when the string is not a valid rule.
+	static GenerationsRule Parse(const std::string& rulestring);
+	static GenerationsRule BriansBrain();
+
+	std::string ToString() const;
+};
+
+enum class Neighbourhood
+{
+	Moore,		//The (2R + 1) x (2R + 1) square around the cell
+	VonNeumann	//The diamond of cells at a manhattan distance of at most R
+};
+
+//Larger than Life rule: neighbour counts over a radius R neighbourhood with a birth and a survival range.
+//Defaults to Bosco's rule, R5,C0,M1,S34..58,B34..45,NM.
+struct LargerThanLifeRule
+{
+public:
+	static const int MaxRadius = 100;
+
+	int radius = 5;
+	bool countsCenter = true;
+	int survivalMin = 34;
+	int survivalMax = 58;
+	int birthMin = 34;
+	int birthMax = 45;
+	Neighbourhood neighbourhood = Neighbourhood::Moore;
+
+	//Accepts the Golly notation "R5,C0,M1,S34..58,B34..45,NM", only two state rules (C0 or C2) are supported.
+	//Throws std::runtime_error when the string is not a valid rule, also for a range that ends before it starts.
+	static LargerThanLifeRule Parse(const std::string& rulestring);
+	//Radius 1 Moore rule with the same behaviour, throws std::runtime_error when the counts are not a single range.
+	//A mask without any count becomes the range 9..9, which no cell reaches.
+	static LargerThanLifeRule FromRule(const Rule& rule);
+
+	//Radius 1 Moore rules have a Life-like equivalent, ToRule is only meaningful for those
+	bool IsLifeLike() const;
+	Rule ToRule() const;
+
+	bool IsBorn(int neighbours) const;
+	bool Survives(int neighbours) const;
+	std::string ToString() const;
+};
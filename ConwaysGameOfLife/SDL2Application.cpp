@@ -1,20 +1,45 @@
 #include "SDL2Application.h"
 #include "SDL2Renderer.h"
+#include "BitwiseEngine.h"
+#include "ChangeTrackingEngine.h"
+#include "NeighbourCountEngine.h"
+#include "ThreadPool.h"
+#include "SparseUniverse.h"
+#include "PatternIO.h"
+#include "SimulationThread.h"
 #include "SDL.h"
 
 #include <iostream>
 #include <algorithm>
 #include <chrono>
 
-SDL2Application::SDL2Application(int cellSize = 20)
+SDL2Application::SDL2Application(int cellSize = 20, int threadCount, bool simulationThread)
 	: Application(new SDL2Renderer{ "Conway's Game of Life", 1280, 960 })
 	, m_pGrid(nullptr)
+	, m_pEngine(new BitwiseEngine{})
+	, m_pThreadPool(threadCount != 1 ? new ThreadPool{ threadCount } : nullptr)
+	, m_pUniverse(nullptr)
+	, m_pSimulation(nullptr)
+	, m_pFrame(nullptr)
+	, m_UseSimulationThread(simulationThread)
+	, m_PauseOnCycle(true)
 	, m_CellSize(cellSize)
+	, m_BoardWidth(0)
+	, m_BoardHeight(0)
+	, m_ViewX(0)
+	, m_ViewY(0)
+	, m_Zoom(0)
+	, m_Panning(false)
+	, m_PanMouse()
+	, m_PanView()
 	, m_TickDelay(0.3f)
 	, m_TickDelayIncrease(0.05f)
 	, m_CurrentDelay(0.f)
 	, m_RunningSimulation(false)
 {
+	//The cycle detector and the renderer read the words each step changed instead of diffing the grid
+	m_pEngine->SetThreadPool(m_pThreadPool);
+	m_pEngine->SetRecordChanges(true);
 }
 
 void SDL2Application::SetTickDelay(float seconds)
@@ -22,15 +47,39 @@ void SDL2Application::SetTickDelay(float seconds)
 	m_TickDelay = abs(seconds);
 }
 
+void SDL2Application::SetRule(const Rule& rule)
+{
+	m_Rule = rule;
+	m_pEngine->SetRule(rule);
+	if (m_pUniverse)
+		m_pUniverse->SetRule(rule);
+}
+
+void SDL2Application::SetBoardSize(int width, int height)
+{
+	m_BoardWidth = width;
+	m_BoardHeight = height;
+}
+
 bool SDL2Application::Initialize()
 {
-	//Create a new grid where the grid full covers the screen with cells
-	m_pGrid = new Grid{ m_pRenderer->GetWindowWidth() / m_CellSize, m_pRenderer->GetWindowHeight() / m_CellSize, m_CellSize };
+	//Create a new grid where the grid full covers the screen with cells, unless a board size was given
+	int width = m_BoardWidth > 0 ? m_BoardWidth : m_pRenderer->GetWindowWidth() / m_CellSize;
+	int height = m_BoardHeight > 0 ? m_BoardHeight : m_pRenderer->GetWindowHeight() / m_CellSize;
+	m_pGrid = new Grid{ width, height, m_CellSize };
 	m_pRenderer->Initialize();
 
 	m_pSDLRenderer = static_cast<SDL2Renderer*>(m_pRenderer);
 	m_pSDLRenderer->SetGrid(m_pGrid);
 
+	//From here on the simulation thread steps its own copy of the grid and the engine is only used by that thread
+	if (m_UseSimulationThread)
+	{
+		m_pSimulation = new SimulationThread{ *m_pGrid, m_pEngine };
+		m_pSimulation->SetTickDelay(m_TickDelay);
+		m_pSimulation->Start();
+	}
+
 	return true;
 }
 
@@ -40,117 +89,329 @@ void SDL2Application::PostInitialize()
 
 void SDL2Application::Cleanup()
 {
+	//Stop the simulation thread before anything it uses goes away
+	delete m_pSimulation;
 	m_pRenderer->Cleanup();
 	delete m_pRenderer;
 	delete m_pGrid;
+	delete m_pEngine;
+	delete m_pThreadPool;
+	delete m_pUniverse;
+}
+
+const Grid& SDL2Application::GetShownGrid() const
+{
+	return m_pFrame ? *m_pFrame : *m_pGrid;
+}
+
+void SDL2Application::GetViewScale(int zoom, int& cellPixels, int& level) const
+{
+	//Halve the cells down to a single pixel first, after that every step shows blocks twice as large
+	cellPixels = m_CellSize;
+	level = 0;
+	for (int i{ 0 }; i < zoom; i++)
+	{
+		if (cellPixels > 1)
+			cellPixels /= 2;
+		else
+			++level;
+	}
+}
+
+void SDL2Application::ZoomAt(const glm::ivec2& position, int zoomChange)
+{
+	int cellPixels, level;
+	GetViewScale(m_Zoom, cellPixels, level);
+
+	//Zooming out stops once the whole board fits the window
+	int blocksX = (m_pGrid->GetWidth() + (1 << level) - 1) >> level;
+	int blocksY = (m_pGrid->GetHeight() + (1 << level) - 1) >> level;
+	if (zoomChange > 0 && blocksX * cellPixels <= m_pRenderer->GetWindowWidth() && blocksY * cellPixels <= m_pRenderer->GetWindowHeight())
+		return;
+
+	//The cell under the mouse stays under the mouse
+	int cellX = m_ViewX + (position.x / cellPixels) * (1 << level);
+	int cellY = m_ViewY + (position.y / cellPixels) * (1 << level);
+	m_Zoom = std::max(0, m_Zoom + zoomChange);
+	GetViewScale(m_Zoom, cellPixels, level);
+	m_ViewX = cellX - (position.x / cellPixels) * (1 << level);
+	m_ViewY = cellY - (position.y / cellPixels) * (1 << level);
+	ClampView();
+}
+
+void SDL2Application::PanTo(const glm::ivec2& position)
+{
+	int cellPixels, level;
+	GetViewScale(m_Zoom, cellPixels, level);
+
+	//Drag the board along with the mouse
+	m_ViewX = m_PanView.x - (position.x - m_PanMouse.x) * (1 << level) / cellPixels;
+	m_ViewY = m_PanView.y - (position.y - m_PanMouse.y) * (1 << level) / cellPixels;
+	ClampView();
+}
+
+void SDL2Application::ClampView()
+{
+	int cellPixels, level;
+	GetViewScale(m_Zoom, cellPixels, level);
+
+	//Keep the window on the board, a board smaller than the window stays in the top left corner
+	int visibleX = (m_pRenderer->GetWindowWidth() / cellPixels) * (1 << level);
+	int visibleY = (m_pRenderer->GetWindowHeight() / cellPixels) * (1 << level);
+	m_ViewX = std::max(0, std::min(m_ViewX, m_pGrid->GetWidth() - visibleX));
+	m_ViewY = std::max(0, std::min(m_ViewY, m_pGrid->GetHeight() - visibleY));
 }
 
 void SDL2Application::ClickedOnCell(const glm::ivec2& position)
 {
-	int cellSize = m_pGrid->GetCellSize();
+	int cellSize, level;
+	GetViewScale(m_Zoom, cellSize, level);
+
+	//Zoomed out past single cells a click would land on a whole block of them
+	if (level != 0)
+		return;
 
-	//Get the distance in pixels how far the mouse position is from the far left of the cell
-	//Subtract xOffset from the mouse position to get the x position of the cell in screen space
-	int xOffset = position.x % cellSize;
-	int x = position.x - xOffset;
+	//Divide the mouse position by the size of a cell on screen and add the cell in the top left corner
+	int x = m_ViewX + position.x / cellSize;
+	int y = m_ViewY + position.y / cellSize;
+	if (x >= m_pGrid->GetWidth() || y >= m_pGrid->GetHeight())
+		return;
+
+	//The simulation thread owns the grid that is stepped, so the edit is sent to it
+	if (m_pSimulation)
+	{
+		SimulationCommand command{};
+		command.type = CommandType::ToggleCell;
+		command.x = x;
+		command.y = y;
+		m_pSimulation->PostCommand(command);
+		return;
+	}
 
-	//Get the distance in pixels how far the mouse position is from the top of the cell
-	//Subtract yOffset from the mouse position to get the y position of the cell in screen space
-	int yOffset = position.y % cellSize;
-	int y = position.y - yOffset;
+	//The neighbour counts can follow a single toggle, any other engine simply sees an edited grid
+	if (NeighbourCountEngine* pNeighbourCount = dynamic_cast<NeighbourCountEngine*>(m_pEngine))
+		pNeighbourCount->ToggleCell(*m_pGrid, x, y);
+	else
+		m_pGrid->ToggleCell(x, y);
 
-	//Divide the x and y by the cellSize to get the actual position in the grid
-	m_pGrid->ToggleCell(x / cellSize, y / cellSize);
+	//Keep the universe in sync with what is shown on the grid
+	if (m_pUniverse)
+		m_pUniverse->SetCell(x, y, m_pGrid->IsAlive(x, y));
 }
 
 void SDL2Application::RunSimulation()
 {
-	//Get the current state of the grid
-	std::vector<Cell> currentGrid = m_pGrid->GetCellsCopy();
-	int width = m_pGrid->GetWidth();
-	int height = m_pGrid->GetHeight();
+	//In unbounded mode the universe is stepped and the visible region copied into the grid
+	if (m_pUniverse)
+	{
+		m_pUniverse->Step();
+		m_pUniverse->WriteToGrid(*m_pGrid);
+		return;
+	}
 
-	//Loop over all the cells in the copied grid
-	std::for_each(currentGrid.begin(), currentGrid.end(), [this, &currentGrid, width, height](const Cell& cell)
-		{
-			//Calculate the index for this cell
-			//Using that find the number of neighbours this cell has
-			int idx = cell.position.x + cell.position.y * width;
-			int nrOfNeighbours = GetNrOfAliveNeighbours(currentGrid, idx, width, height);
+	//Let the engine advance the grid by one generation, recording before the step as well keeps edits made since the last one
+	m_History.Record(*m_pGrid);
+	m_pEngine->Step(*m_pGrid);
+	m_History.Record(*m_pGrid);
 
-			if (cell.alive)
-			{
-				//If the cell is alive and either has less than 2 neighbours or more than 3, it dies
-				//Update the state in the non-copied grid
-				if (nrOfNeighbours < 2)
-					m_pGrid->ToggleCell(cell.position);
-				else if (nrOfNeighbours > 3)
-					m_pGrid->ToggleCell(cell.position);
-			}
-			else
-			{
-				//If the cell is dead and has exactly 3 neighbours, it becomes alive
-				//Update the state in the non-copied grid
-				if (nrOfNeighbours == 3)
-					m_pGrid->ToggleCell(cell.position);
-			}
-		}
-	);
+	//A grid that settled into still lifes and oscillators is paused instead of recomputing the same generations forever
+	if (m_PauseOnCycle && m_CycleDetector.Update(*m_pGrid))
+	{
+		std::cout << "The grid repeats every " << m_CycleDetector.GetPeriod() << " generations since generation "
+			<< m_CycleDetector.GetCycleStart() << ", simulation paused" << std::endl;
+		m_RunningSimulation = false;
+		m_CycleDetector.Reset();
+	}
 }
 
-int SDL2Application::GetNrOfAliveNeighbours(const std::vector<Cell>& grid, int index, int gridWidth, int gridHeight)
+void SDL2Application::ToggleRunningSimulation()
 {
-	int neighbourCount = 0;
-	int totalCells = int(grid.size());
+	if (m_pSimulation)
+		m_pSimulation->SetRunning(!m_pSimulation->IsRunning());
+	else
+		m_RunningSimulation = !m_RunningSimulation;
+}
 
-	//Indices for the top, bottom, left and right neighbouring cells
-	int idxLeft = index - 1;
-	int idxRight = index + 1;
-	int idxUp = index - gridWidth;
-	int idxDown = index + gridWidth;
+void SDL2Application::StepForward()
+{
+	if (m_pSimulation)
+	{
+		SimulationCommand command{};
+		command.type = CommandType::Step;
+		m_pSimulation->PostCommand(command);
+		return;
+	}
+
+	//After a rewind the next generations are still in the history. Recording first drops them when the grid was edited since,
+	//they are not its future anymore.
+	uint64_t next = m_pGrid->GetGeneration() + 1;
+	if (!m_pUniverse)
+		m_History.Record(*m_pGrid);
+	if (!m_pUniverse && m_History.Contains(next))
+		m_History.Rewind(*m_pGrid, next);
+	else
+		RunSimulation();
+}
 
-	auto FindAliveNeighbours = [this, totalCells, gridHeight, gridWidth, &grid, &neighbourCount](int movedIdx, int index)
+void SDL2Application::StepBackward()
+{
+	if (m_pUniverse)
 	{
-		//Check if the given index is valid and if it's actually a neighbour of the evaluated cell
-		if (ValidIndex(movedIdx, totalCells) && OnSameRow(grid[movedIdx].position.y, grid[index].position.y, gridHeight))
-		{
-			//Get the index of the cell above and below the neighbour cell
-			int idxTop = movedIdx - gridWidth;
-			int idxBottom = movedIdx + gridWidth;
+		std::cout << "The unbounded universe has no history to rewind" << std::endl;
+		return;
+	}
 
-			//Check if the indices are valid and alive, if so add to the neighbourCount
-			if (grid[movedIdx].alive)
-				++neighbourCount;
+	//Going back pauses the simulation, otherwise it would step forward again right away
+	uint64_t generation = GetShownGrid().GetGeneration();
+	if (m_pSimulation)
+	{
+		m_pSimulation->SetRunning(false);
+
+		SimulationCommand command{};
+		command.type = CommandType::Rewind;
+		command.generation = generation - 1;
+		if (generation != 0)
+			m_pSimulation->PostCommand(command);
+		return;
+	}
 
-			if (ValidIndex(idxTop, totalCells) && grid[idxTop].alive)
-				++neighbourCount;
+	m_RunningSimulation = false;
+	if (generation == 0 || !m_History.Contains(generation - 1))
+	{
+		std::cout << "Generation " << generation - 1 << " is no longer in the history" << std::endl;
+		return;
+	}
+	m_History.Rewind(*m_pGrid, generation - 1);
+}
 
-			if (ValidIndex(idxBottom, totalCells) && grid[idxBottom].alive)
-				++neighbourCount;
-		}
-	};
+void SDL2Application::ClearGrid()
+{
+	if (m_pSimulation)
+	{
+		SimulationCommand command{};
+		command.type = CommandType::Clear;
+		m_pSimulation->PostCommand(command);
+		return;
+	}
+
+	m_pGrid->ClearGrid();
+	if (m_pUniverse)
+		m_pUniverse->Clear();
+}
 
-	//Check for living neighbours
-	FindAliveNeighbours(idxLeft, index);
-	FindAliveNeighbours(idxRight, index);
+void SDL2Application::ToggleUnbounded()
+{
+	if (m_pSimulation)
+	{
+		std::cout << "The unbounded universe is not available with a simulation thread" << std::endl;
+		return;
+	}
 
-	//Check if the indices are valid and alive, if so add to the neighbourCount
-	if (ValidIndex(idxUp, totalCells) && grid[idxUp].alive)
-		++neighbourCount;
-	if (ValidIndex(idxDown, totalCells) && grid[idxDown].alive)
-		++neighbourCount;
+	if (m_pUniverse)
+	{
+		delete m_pUniverse;
+		m_pUniverse = nullptr;
+		return;
+	}
 
-	return neighbourCount;
+	//Start the universe from the cells that are currently on the grid
+	m_pUniverse = new SparseUniverse{};
+	m_pUniverse->SetRule(m_Rule);
+	m_pUniverse->LoadGrid(*m_pGrid);
 }
 
-bool SDL2Application::OnSameRow(int idx1, int idx2, int height)
+void SDL2Application::ToggleIncremental()
 {
-	return (idx1 % height == idx2 % height);
+	//The engine belongs to the simulation thread while it runs
+	if (m_pSimulation)
+	{
+		std::cout << "The engine can not be switched with a simulation thread" << std::endl;
+		return;
+	}
+
+	//Cycle between stepping every cell, only stepping the words around last generation's changes
+	//and only stepping the cells whose neighbour count changed
+	bool changeTracking = dynamic_cast<ChangeTrackingEngine*>(m_pEngine) != nullptr;
+	bool neighbourCount = dynamic_cast<NeighbourCountEngine*>(m_pEngine) != nullptr;
+	delete m_pEngine;
+
+	if (changeTracking)
+		m_pEngine = new NeighbourCountEngine{};
+	else if (neighbourCount)
+		m_pEngine = new BitwiseEngine{};
+	else
+		m_pEngine = new ChangeTrackingEngine{};
+	std::cout << "Engine: " << m_pEngine->GetName() << std::endl;
+
+	m_pEngine->SetThreadPool(m_pThreadPool);
+	m_pEngine->SetRecordChanges(true);
+	m_pEngine->SetRule(m_Rule);
 }
 
-void SDL2Application::ToggleRunningSimulation()
+void SDL2Application::CycleTopology()
 {
-	m_RunningSimulation = !m_RunningSimulation;
+	//Dead border -> torus -> Klein bottle -> dead border
+	const char* names[] = { "dead border", "torus", "Klein bottle" };
+	int topology = (int(GetShownGrid().GetTopology()) + 1) % 3;
+	if (m_pSimulation)
+	{
+		SimulationCommand command{};
+		command.type = CommandType::SetTopology;
+		command.topology = Topology(topology);
+		m_pSimulation->PostCommand(command);
+	}
+	else
+	{
+		m_pGrid->SetTopology(Topology(topology));
+	}
+	std::cout << "Topology: " << names[topology] << std::endl;
+}
+
+void SDL2Application::SavePattern(const std::string& path) const
+{
+	try
+	{
+		PatternWriter::WriteFile(path, GetShownGrid(), m_Rule.ToString());
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+}
+
+void SDL2Application::LoadPattern(const std::string& path)
+{
+	//Saved patterns remember their position, so they load back where they were
+	Grid* pTarget = m_pSimulation ? new Grid{ m_pGrid->GetWidth(), m_pGrid->GetHeight(), m_pGrid->GetCellSize() } : m_pGrid;
+	pTarget->ClearGrid();
+	try
+	{
+		GridPatternSink sink{ *pTarget };
+		PatternReader::ReadFile(path, sink);
+	}
+	catch (const std::exception& exception)
+	{
+		std::cout << exception.what() << std::endl;
+	}
+
+	//The simulation thread takes over the loaded grid
+	if (m_pSimulation)
+	{
+		pTarget->SetTopology(GetShownGrid().GetTopology());
+
+		SimulationCommand command{};
+		command.type = CommandType::LoadGrid;
+		command.pGrid = pTarget;
+		if (!m_pSimulation->PostCommand(command))
+			delete pTarget;
+		return;
+	}
+
+	if (m_pUniverse)
+	{
+		m_pUniverse->Clear();
+		m_pUniverse->LoadGrid(*m_pGrid);
+	}
 }
 
 void SDL2Application::IncreaseTickDelay(float delay)
@@ -164,14 +425,12 @@ void SDL2Application::IncreaseTickDelay(float delay)
 
 	if (m_TickDelay > highCap)
 		m_TickDelay = highCap;
-}
 
-
-bool SDL2Application::ValidIndex(int idx, int arraySize)
-{
-	return (idx > 0 && idx < arraySize - 1);
+	if (m_pSimulation)
+		m_pSimulation->SetTickDelay(m_TickDelay);
 }
 
+
 void SDL2Application::HandleInput()
 {
 	SDL_Event e;
@@ -187,6 +446,33 @@ void SDL2Application::HandleInput()
 				SDL_GetMouseState(&x, &y);
 				ClickedOnCell(glm::ivec2{ x, y });
 			}
+			else if (e.button.button == SDL_BUTTON_RIGHT)
+			{
+				//Dragging with the right mouse button moves the view
+				m_Panning = true;
+				m_PanMouse = glm::ivec2{ e.button.x, e.button.y };
+				m_PanView = glm::ivec2{ m_ViewX, m_ViewY };
+			}
+			break;
+
+		case SDL_MOUSEBUTTONUP:
+			if (e.button.button == SDL_BUTTON_RIGHT)
+				m_Panning = false;
+			break;
+
+		case SDL_MOUSEMOTION:
+			if (m_Panning)
+				PanTo(glm::ivec2{ e.motion.x, e.motion.y });
+			break;
+
+		case SDL_MOUSEWHEEL:
+			if (e.wheel.y != 0)
+			{
+				//Scrolling up zooms in on the mouse, scrolling down zooms out
+				int x, y;
+				SDL_GetMouseState(&x, &y);
+				ZoomAt(glm::ivec2{ x, y }, e.wheel.y > 0 ? -1 : 1);
+			}
 			break;
 
 		case SDL_KEYUP:
@@ -203,7 +489,57 @@ void SDL2Application::HandleInput()
 			else if (e.key.keysym.sym == SDLK_BACKSPACE)
 			{
 				//If backspace is pressed, set all cells in the grid to dead
-				m_pGrid->ClearGrid();
+				ClearGrid();
+			}
+			else if (e.key.keysym.sym == SDLK_u)
+			{
+				//If u is pressed, toggle between the bounded grid and the unbounded universe
+				ToggleUnbounded();
+			}
+			else if (e.key.keysym.sym == SDLK_i)
+			{
+				//If i is pressed, switch to the next way of incremental stepping
+				ToggleIncremental();
+			}
+			else if (e.key.keysym.sym == SDLK_t)
+			{
+				//If t is pressed, switch what lies past the edges of the grid
+				CycleTopology();
+			}
+			else if (e.key.keysym.sym == SDLK_c)
+			{
+				//If c is pressed, toggle pausing once the grid repeats itself
+				m_PauseOnCycle = !m_PauseOnCycle;
+				m_CycleDetector.Reset();
+				if (m_pSimulation)
+					m_pSimulation->SetPauseOnCycle(m_PauseOnCycle);
+			}
+			else if (e.key.keysym.sym == SDLK_r)
+			{
+				//If r is pressed, go back to the cells in the top left corner at their own size
+				m_Zoom = 0;
+				m_ViewX = 0;
+				m_ViewY = 0;
+			}
+			else if (e.key.keysym.sym == SDLK_s)
+			{
+				//If s is pressed, save the grid to a file
+				SavePattern("save.rle");
+			}
+			else if (e.key.keysym.sym == SDLK_l)
+			{
+				//If l is pressed, load the saved grid
+				LoadPattern("save.rle");
+			}
+			else if (e.key.keysym.sym == SDLK_RIGHT)
+			{
+				//Step one generation forward
+				StepForward();
+			}
+			else if (e.key.keysym.sym == SDLK_LEFT)
+			{
+				//Pause and go back one generation
+				StepBackward();
 			}
 			else if (e.key.keysym.sym == SDLK_UP)
 			{
@@ -227,6 +563,18 @@ void SDL2Application::HandleInput()
 
 void SDL2Application::Update(float deltaTime)
 {
+	int cellPixels, level;
+	GetViewScale(m_Zoom, cellPixels, level);
+	m_pSDLRenderer->SetView(m_ViewX, m_ViewY, cellPixels, level);
+
+	//The simulation thread keeps its own pace, only show the newest generation it finished
+	if (m_pSimulation)
+	{
+		m_pFrame = &m_pSimulation->AcquireFrame();
+		m_pSDLRenderer->SetGrid(m_pFrame);
+		return;
+	}
+
 	//If the simulation is running, check if this frame the grid should update.
 	if (m_RunningSimulation)
 	{
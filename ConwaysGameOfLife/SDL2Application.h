@@ -1,18 +1,28 @@
 #pragma once
 #include "glm.hpp"
+#include <string>
 #include <vector>
 #include "Cell.h"
 #include "Application.h"
+#include "Rule.h"
+#include "CycleDetector.h"
+#include "GenerationHistory.h"
 
 class Renderer;
 class SDL2Renderer;
 class Grid;
+class LifeEngine;
+class ThreadPool;
+class SparseUniverse;
+class SimulationThread;
 struct GLFWwindow;
 
 class SDL2Application final : public Application
 {
 public:
-	SDL2Application(int cellSize);
+	//A thread count other than 1 steps the grid in parallel row bands, 0 uses every hardware thread.
+	//With a simulation thread the grid is stepped next to the render loop instead of in it.
+	SDL2Application(int cellSize, int threadCount = 1, bool simulationThread = false);
 	SDL2Application(const SDL2Application& other) = delete;
 	SDL2Application(SDL2Application&& other) = delete;
 	SDL2Application& operator=(const SDL2Application& other) = delete;
@@ -20,10 +30,32 @@ public:
 	virtual ~SDL2Application() = default;
 
 	void SetTickDelay(float seconds);
+	void SetRule(const Rule& rule);
+	//Cells of the board, by default it is as large as fits the window. Has to be called before Run.
+	//A larger board is looked at by zooming out with the mouse wheel and dragging with the right mouse button.
+	void SetBoardSize(int width, int height);
 
 private:
 	Grid* m_pGrid;
+	LifeEngine* m_pEngine;
+	ThreadPool* m_pThreadPool;
+	SparseUniverse* m_pUniverse;	//Only set while the unbounded universe is enabled, the grid then shows its top left region
+	SimulationThread* m_pSimulation;	//Only set in simulation thread mode, it then owns the grid that is stepped
+	const Grid* m_pFrame;			//Newest generation from the simulation thread
+	bool m_UseSimulationThread;
+	Rule m_Rule;
+	CycleDetector m_CycleDetector;
+	GenerationHistory m_History;
+	bool m_PauseOnCycle;
 	int m_CellSize;
+	int m_BoardWidth;
+	int m_BoardHeight;
+	int m_ViewX;					//Cell in the top left corner of the window
+	int m_ViewY;
+	int m_Zoom;						//Halvings of the cell size, past 1 pixel per cell every step doubles the cells per pixel
+	bool m_Panning;
+	glm::ivec2 m_PanMouse;			//Mouse and view position where the drag started
+	glm::ivec2 m_PanView;
 	float m_TickDelay;
 	float m_CurrentDelay;
 	float m_TickDelayIncrease;
@@ -38,12 +70,22 @@ private:
 	virtual void Update(float deltaTime) override;
 	virtual void Cleanup() override;
 
+	const Grid& GetShownGrid() const;
+	void GetViewScale(int zoom, int& cellPixels, int& level) const;
+	void ZoomAt(const glm::ivec2& position, int zoomChange);
+	void PanTo(const glm::ivec2& position);
+	void ClampView();
 	void ClickedOnCell(const glm::ivec2& position);
 	void RunSimulation();
-	int GetNrOfAliveNeighbours(const std::vector<Cell>& grid, int index, int gridWidth, int gridHeight);
-	bool ValidIndex(int idx, int arraySize);
-	bool OnSameRow(int y1, int y2, int height);
 
 	void ToggleRunningSimulation();
+	void StepForward();
+	void StepBackward();
+	void ClearGrid();
+	void ToggleUnbounded();
+	void ToggleIncremental();
+	void CycleTopology();
+	void SavePattern(const std::string& path) const;
+	void LoadPattern(const std::string& path);
 	void IncreaseTickDelay(float delay);
 };
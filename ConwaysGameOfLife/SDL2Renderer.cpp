@@ -4,10 +4,26 @@
 #include <algorithm>
 #include <iostream>
 
+//Colors in SDL_PIXELFORMAT_ARGB8888
+static const uint32_t AliveColor = 0xFFFFFFFF;
+static const uint32_t DeadColor = 0xFF323232;
+static const uint32_t GridLineColor = 0xFFFFFFFF;
+static const uint32_t OutsideColor = 0xFF000000;
+
 SDL2Renderer::SDL2Renderer(const std::string& windowName, int width, int height)
 	: m_pGrid(nullptr)
 	, m_Window(nullptr)
 	, m_Renderer(nullptr)
+	, m_pCellTexture(nullptr)
+	, m_pGridLineTexture(nullptr)
+	, m_TextureWidth(0)
+	, m_TextureHeight(0)
+	, m_TextureFailed(false)
+	, m_pViewTexture(nullptr)
+	, m_ViewX(0)
+	, m_ViewY(0)
+	, m_ViewCellPixels(0)
+	, m_ViewLevel(0)
 	, m_WindowName(windowName)
 	, m_Width(width)
 	, m_Height(height)
@@ -44,6 +60,10 @@ void SDL2Renderer::Render()
 
 void SDL2Renderer::Cleanup()
 {
+	DestroyTextures();
+	if (m_pViewTexture)
+		SDL_DestroyTexture(m_pViewTexture);
+	m_pViewTexture = nullptr;
 }
 
 int SDL2Renderer::GetWindowWidth() const
@@ -56,8 +76,17 @@ int SDL2Renderer::GetWindowHeight() const
 	return m_Height;
 }
 
-void SDL2Renderer::SetGrid(Grid* pGrid)
+void SDL2Renderer::SetGrid(const Grid* pGrid)
 {
+	//The grid lines only fit a grid of the same size, otherwise build the textures again
+	bool sameSize = m_pGrid && pGrid && m_pGrid->GetWidth() == pGrid->GetWidth()
+		&& m_pGrid->GetHeight() == pGrid->GetHeight() && m_pGrid->GetCellSize() == pGrid->GetCellSize();
+	if (!sameSize)
+	{
+		m_TextureWidth = 0;
+		m_TextureHeight = 0;
+	}
+
 	m_pGrid = pGrid;
 }
 
@@ -66,27 +95,175 @@ void SDL2Renderer::ToggleGrid()
 	m_DrawGrid = !m_DrawGrid;
 }
 
-void SDL2Renderer::Draw() const
+void SDL2Renderer::SetView(int originX, int originY, int cellPixels, int level)
+{
+	m_ViewX = originX;
+	m_ViewY = originY;
+	m_ViewCellPixels = cellPixels;
+	m_ViewLevel = level;
+}
+
+void SDL2Renderer::Draw()
 {
 	if (!m_pGrid)
 		return;
 
-	const std::vector<Cell>& cells = m_pGrid->GetCells();
+	if (!IsWholeGridShown() && DrawView())
+		return;
+
+	if (!UpdateTextures())
+	{
+		DrawRects();
+		return;
+	}
+
+	SDL_Rect target = { 0, 0, m_TextureWidth, m_TextureHeight };
+	SDL_RenderCopy(m_Renderer, m_pCellTexture, nullptr, &target);
+	if (m_DrawGrid)
+		SDL_RenderCopy(m_Renderer, m_pGridLineTexture, nullptr, &target);
+}
+
+bool SDL2Renderer::UpdateTextures()
+{
+	int cellSize = m_pGrid->GetCellSize();
+	int width = m_pGrid->GetWidth() * cellSize;
+	int height = m_pGrid->GetHeight() * cellSize;
+
+	if (width != m_TextureWidth || height != m_TextureHeight)
+	{
+		m_TextureFailed = !CreateTextures(width, height);
+		m_DirtyRows.Invalidate();
+	}
+
+	if (m_TextureFailed)
+		return false;
+
+	//Lock and expand every run of changed rows, the rest of the texture keeps what it showed last frame
+	m_DirtyRows.Update(*m_pGrid, m_DirtyRanges);
+	for (const std::pair<int, int>& range : m_DirtyRanges)
+	{
+		SDL_Rect rect = { 0, range.first * cellSize, width, (range.second - range.first) * cellSize };
+		void* pPixels = nullptr;
+		int pitch = 0;
+		if (SDL_LockTexture(m_pCellTexture, &rect, &pPixels, &pitch) != 0)
+		{
+			std::cout << "Could not lock the cell texture: " << SDL_GetError() << std::endl;
+			m_DirtyRows.Invalidate();
+			return false;
+		}
+
+		PixelExpansion::ExpandRows(*m_pGrid, range.first, range.second, AliveColor, DeadColor, pPixels, pitch);
+		SDL_UnlockTexture(m_pCellTexture);
+	}
+
+	return true;
+}
+
+bool SDL2Renderer::CreateTextures(int width, int height)
+{
+	DestroyTextures();
+	m_TextureWidth = width;
+	m_TextureHeight = height;
+
+	m_pCellTexture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+	m_pGridLineTexture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC, width, height);
+	if (!m_pCellTexture || !m_pGridLineTexture)
+	{
+		//Most likely larger than the renderer supports
+		std::cout << "Could not create a " << width << "x" << height << " texture, drawing cell by cell: " << SDL_GetError() << std::endl;
+		DestroyTextures();
+		return false;
+	}
+
+	//The grid lines only change with the size of the grid, so they are uploaded once
+	std::vector<uint32_t> pixels(size_t(width) * height);
+	int pitch = width * int(sizeof(uint32_t));
+	PixelExpansion::DrawGridLines(m_pGrid->GetWidth(), m_pGrid->GetHeight(), m_pGrid->GetCellSize(), GridLineColor, pixels.data(), pitch);
+	SDL_UpdateTexture(m_pGridLineTexture, nullptr, pixels.data(), pitch);
+	SDL_SetTextureBlendMode(m_pGridLineTexture, SDL_BLENDMODE_BLEND);
+	return true;
+}
+
+void SDL2Renderer::DestroyTextures()
+{
+	if (m_pCellTexture)
+		SDL_DestroyTexture(m_pCellTexture);
+	if (m_pGridLineTexture)
+		SDL_DestroyTexture(m_pGridLineTexture);
+
+	m_pCellTexture = nullptr;
+	m_pGridLineTexture = nullptr;
+}
+
+bool SDL2Renderer::IsWholeGridShown() const
+{
+	//Without a view set the grid is drawn at its own cell size
+	int cellSize = m_pGrid->GetCellSize();
+	if (m_ViewCellPixels == 0)
+		return true;
+
+	return m_ViewLevel == 0 && m_ViewCellPixels == cellSize && m_ViewX == 0 && m_ViewY == 0
+		&& m_pGrid->GetWidth() * cellSize <= m_Width && m_pGrid->GetHeight() * cellSize <= m_Height;
+}
+
+bool SDL2Renderer::DrawView()
+{
+	if (!m_pViewTexture)
+	{
+		m_pViewTexture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, m_Width, m_Height);
+		if (!m_pViewTexture)
+		{
+			std::cout << "Could not create the view texture: " << SDL_GetError() << std::endl;
+			return false;
+		}
+	}
+
+	//Only the words that changed since the last frame are counted again
+	m_Pyramid.Update(*m_pGrid);
+	int level = std::min(m_ViewLevel, m_Pyramid.GetLevelCount());
+
+	void* pPixels = nullptr;
+	int pitch = 0;
+	if (SDL_LockTexture(m_pViewTexture, nullptr, &pPixels, &pitch) != 0)
+	{
+		std::cout << "Could not lock the view texture: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	PixelExpansion::ExpandView(m_Pyramid, level, m_ViewX, m_ViewY, std::max(1, m_ViewCellPixels), AliveColor, DeadColor, OutsideColor, pPixels, pitch, m_Width, m_Height);
+	SDL_UnlockTexture(m_pViewTexture);
+
+	SDL_RenderCopy(m_Renderer, m_pViewTexture, nullptr, nullptr);
+	return true;
+}
+
+void SDL2Renderer::DrawRects() const
+{
+	int cellSize = m_pGrid->GetCellSize();
 
 	//Store the original color and set the draw color to white
 	Uint8 r, g, b, a;
 	SDL_GetRenderDrawColor(m_Renderer, &r, &g, &b, &a);
 	SDL_SetRenderDrawColor(m_Renderer, 255, 255, 255, 255);
 
-	//Loop over all the cells in the grid and draw them.
-	//Fill the cell if it's alive otherwhise draw the outline
-	std::for_each(cells.begin(), cells.end(), [this](const Cell& cell)
+	//Draw the outline of every cell, alive cells get filled over it afterwards
+	if (m_DrawGrid)
+	{
+		for (int y{ 0 }; y < m_pGrid->GetHeight(); y++)
 		{
-			SDL_Rect rect = { int(cell.position.x * cell.size), int(cell.position.y * cell.size), cell.size, cell.size};
-			if (cell.alive)
-				SDL_RenderFillRect(m_Renderer, &rect);
-			else if (m_DrawGrid)
+			for (int x{ 0 }; x < m_pGrid->GetWidth(); x++)
+			{
+				SDL_Rect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
 				SDL_RenderDrawRect(m_Renderer, &rect);
+			}
+		}
+	}
+
+	//Only visit the alive cells of the packed grid and fill them
+	m_pGrid->ForEachAliveCell([this, cellSize](int x, int y)
+		{
+			SDL_Rect rect = { x * cellSize, y * cellSize, cellSize, cellSize };
+			SDL_RenderFillRect(m_Renderer, &rect);
 		}
 	);
 
@@ -1,10 +1,21 @@
 #pragma once
 #include "Renderer.h"
+#include "PixelExpansion.h"
+#include "DensityPyramid.h"
 #include <string>
+#include <utility>
+#include <vector>
 
 class Grid;
 struct SDL_Window;
 struct SDL_Renderer;
+struct SDL_Texture;
+
+//Draws the grid as one streaming texture: the packed cells are expanded straight into the locked texture,
+//and only the rows that changed since the last frame. The grid lines are a second texture drawn over it,
+//built once per grid size. When the texture can not be created the cells are drawn one rectangle at a time.
+//Once the view is panned, zoomed or the grid does not fit the window, a window sized texture is filled from a density pyramid
+//instead, one lookup per cell or block on the screen however large the grid is. That view has no grid lines.
 
 class SDL2Renderer final : public Renderer
 {
@@ -22,19 +33,41 @@ public:
 	virtual int GetWindowWidth() const override;
 	virtual int GetWindowHeight() const override;
 
-	void SetGrid(Grid* pGrid);
+	//Frames of the same size can be swapped every frame, only the rows that differ are uploaded
+	void SetGrid(const Grid* pGrid);
 	void ToggleGrid();
-	
+	//Cell (originX, originY) in the top left corner, every cell or block of 1 << level cells square drawn as cellPixels square pixels
+	void SetView(int originX, int originY, int cellPixels, int level);
+
 private:
-	Grid* m_pGrid;
+	const Grid* m_pGrid;
 	SDL_Window* m_Window;
 	SDL_Renderer* m_Renderer;
+	SDL_Texture* m_pCellTexture;
+	SDL_Texture* m_pGridLineTexture;
+	int m_TextureWidth;
+	int m_TextureHeight;
+	bool m_TextureFailed;
+	DirtyRows m_DirtyRows;
+	std::vector<std::pair<int, int>> m_DirtyRanges;
+	SDL_Texture* m_pViewTexture;
+	DensityPyramid m_Pyramid;
+	int m_ViewX;
+	int m_ViewY;
+	int m_ViewCellPixels;
+	int m_ViewLevel;
 
 	std::string m_WindowName;
 	int m_Width;
 	int m_Height;
 	bool m_DrawGrid;
 
-	void Draw() const;
+	void Draw();
+	bool UpdateTextures();
+	bool CreateTextures(int width, int height);
+	void DestroyTextures();
+	void DrawRects() const;
+	bool IsWholeGridShown() const;
+	bool DrawView();
 };
 
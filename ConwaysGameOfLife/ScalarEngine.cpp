@@ -0,0 +1,53 @@
+#include "ScalarEngine.h"
+#include "Cell.h"
+
+#include <algorithm>
+
+void ScalarEngine::StepRows(Grid& grid, int firstRow, int lastRow)
+{
+	int width = grid.GetWidth();
+
+	//Loop over all the cells in the rows, the current generation is only read
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		uint64_t* pNextRow = grid.GetNextRow(y);
+		std::fill(pNextRow, pNextRow + grid.GetWordsPerRow(), uint64_t(0));
+
+		for (int x{ 0 }; x < width; x++)
+		{
+			int nrOfNeighbours = GetNrOfAliveNeighbours(grid, x, y);
+			bool alive = grid.IsAlive(x, y);
+
+			//An alive cell stays alive if the rule lets it survive with this many neighbours
+			//A dead cell becomes alive if the rule gives birth with this many neighbours
+			if (alive)
+				alive = m_Rule.Survives(nrOfNeighbours);
+			else
+				alive = m_Rule.IsBorn(nrOfNeighbours);
+
+			//Write the new state into the next generation
+			if (alive)
+				pNextRow[x / 64] |= uint64_t(1) << (x % 64);
+		}
+	}
+}
+
+const char* ScalarEngine::GetName() const
+{
+	return "scalar";
+}
+
+int ScalarEngine::GetNrOfAliveNeighbours(const Grid& grid, int x, int y) const
+{
+	int neighbourCount = 0;
+
+	//Count the 3x3 block around the cell and take the cell itself off again.
+	//Neighbours outside the grid are read from its halo, which holds whatever the topology puts there.
+	for (int offsetY{ -1 }; offsetY <= 1; offsetY++)
+	{
+		for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+			neighbourCount += grid.IsAlive(x + offsetX, y + offsetY);
+	}
+
+	return neighbourCount - grid.IsAlive(x, y);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "LifeEngine.h"
+
+//Reference engine that evaluates the rule one cell at a time.
+//It is slow, but it is the behaviour every other engine has to match bit for bit.
+class ScalarEngine final : public LifeEngine
+{
+public:
+	ScalarEngine() = default;
+	virtual ~ScalarEngine() = default;
+	ScalarEngine(const ScalarEngine& other) = delete;
+	ScalarEngine(ScalarEngine&& other) = delete;
+	ScalarEngine& operator=(const ScalarEngine& other) = delete;
+	ScalarEngine& operator=(ScalarEngine&& other) = delete;
+
+	virtual const char* GetName() const override;
+
+protected:
+	virtual void StepRows(Grid& grid, int firstRow, int lastRow) override;
+
+private:
+	int GetNrOfAliveNeighbours(const Grid& grid, int x, int y) const;
+};
@@ -0,0 +1,338 @@
+#include "ShardedSimulation.h"
+#include "EngineFactory.h"
+#include "LifeEngine.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <linux/futex.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+ShardedSimulation::ShardedSimulation(const std::string& engineName, const std::string& rulestring, int shardCount)
+	: m_EngineName(engineName)
+	, m_Rulestring(rulestring)
+	, m_ShardCount(shardCount)
+	, m_Range(1)
+	, m_ExchangedBytes(0)
+{
+	if (shardCount < 1)
+		throw std::runtime_error{ "A sharded simulation needs at least one shard" };
+
+	//The workers create their own engines, this one only checks the name and rule before anything is forked
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(engineName, rulestring) };
+	m_Range = pEngine->GetRange();
+}
+
+int ShardedSimulation::GetShardCount() const
+{
+	return m_ShardCount;
+}
+
+uint64_t ShardedSimulation::GetExchangedBytes() const
+{
+	return m_ExchangedBytes;
+}
+
+std::vector<int> ShardedSimulation::SplitRows(int height) const
+{
+	std::vector<int> firstRows;
+	for (int shard{ 0 }; shard <= m_ShardCount; shard++)
+		firstRows.push_back(int(int64_t(height) * shard / m_ShardCount));
+
+	//A worker publishes 'range' rows at either side, and those have to be its own
+	for (int shard{ 0 }; shard < m_ShardCount; shard++)
+	{
+		if (firstRows[shard + 1] - firstRows[shard] < m_Range)
+			throw std::runtime_error{ "A grid of " + std::to_string(height) + " rows can not be split in " + std::to_string(m_ShardCount)
+				+ " shards of at least " + std::to_string(m_Range) + " rows" };
+	}
+
+	return firstRows;
+}
+
+#if defined(__linux__)
+
+//Ring slots per boundary. A worker only overwrites a slot after it read the next generation of both neighbours,
+//which they only publish after they read the slot, so two are enough.
+static const int RingSlots = 2;
+static const size_t CacheLine = 64;
+
+//The futex word every worker publishes its generation in, alone on its cache line so neighbours do not share one
+struct ShardChannel
+{
+	std::atomic<uint32_t> published;	//Generation + 1 of the newest boundary rows in the ring, 0 before the first
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futexes wait on plain 32 bit words");
+
+//Everything the workers share, carved out of one anonymous mapping that is created before forking
+struct SharedRegion
+{
+	void* pMapping;
+	size_t size;
+	std::atomic<uint32_t>* pAbort;	//Set when any worker failed, the others stop instead of waiting forever
+	ShardChannel* pChannels;		//One per shard, each CacheLine bytes apart
+	uint64_t* pRing;				//[shard][slot][top, bottom][range rows][wordsPerRow]
+	uint64_t* pResult;				//The whole grid without halo, every worker writes its rows into it at the end
+	int wordsPerRow;
+	int range;
+
+	ShardChannel& GetChannel(int shard) const
+	{
+		return *reinterpret_cast<ShardChannel*>(reinterpret_cast<char*>(pChannels) + CacheLine * shard);
+	}
+
+	uint64_t* GetBoundary(int shard, uint64_t generation, bool bottom) const
+	{
+		size_t blockWords = size_t(range) * wordsPerRow;
+		size_t block = (size_t(shard) * RingSlots + size_t(generation % RingSlots)) * 2 + (bottom ? 1 : 0);
+		return pRing + block * blockWords;
+	}
+};
+
+static void WakeAll(std::atomic<uint32_t>& word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void Abort(const SharedRegion& region, int shardCount)
+{
+	region.pAbort->store(1);
+	for (int shard{ 0 }; shard < shardCount; shard++)
+		WakeAll(region.GetChannel(shard).published);
+}
+
+//Returns once the shard published the generation (or the one after it, a neighbour is never further ahead)
+static void WaitForGeneration(const SharedRegion& region, int shard, uint64_t generation)
+{
+	std::atomic<uint32_t>& published = region.GetChannel(shard).published;
+	uint32_t target = uint32_t(generation + 1);
+	for (int attempt{ 0 };; attempt++)
+	{
+		//Compared with wrap around, a run can be longer than 2^32 generations
+		uint32_t value = published.load(std::memory_order_acquire);
+		if (uint32_t(value - target) <= 1)
+			return;
+		if (region.pAbort->load())
+			throw std::runtime_error{ "Another shard failed" };
+
+		//Neighbours usually finish within a few microseconds of each other, so spin a little before sleeping.
+		//The timeout only makes sure an abort is noticed.
+		if (attempt < 1000)
+			continue;
+		timespec timeout{ 0, 100000000 };
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&published), FUTEX_WAIT, value, &timeout, nullptr, 0);
+	}
+}
+
+static void Publish(const SharedRegion& region, Grid& shardGrid, int shard, uint64_t generation)
+{
+	int range = region.range;
+	int wordsPerRow = region.wordsPerRow;
+	int lastOwnRow = shardGrid.GetHeight() - range - 1;
+	uint64_t* pTop = region.GetBoundary(shard, generation, false);
+	uint64_t* pBottom = region.GetBoundary(shard, generation, true);
+	for (int row{ 0 }; row < range; row++)
+	{
+		const uint64_t* pFirst = shardGrid.GetRow(range + row);
+		const uint64_t* pLast = shardGrid.GetRow(lastOwnRow - range + 1 + row);
+		std::copy(pFirst, pFirst + wordsPerRow, pTop + size_t(row) * wordsPerRow);
+		std::copy(pLast, pLast + wordsPerRow, pBottom + size_t(row) * wordsPerRow);
+	}
+
+	std::atomic<uint32_t>& published = region.GetChannel(shard).published;
+	published.store(uint32_t(generation + 1), std::memory_order_release);
+	WakeAll(published);
+}
+
+//Ghost row r above the shard is row r of the bottom block of the shard above it, and the other way around below.
+//Across the top or bottom edge of the grid the rows are dead, wrap around, or wrap around mirrored.
+static void FillGhostRows(const SharedRegion& region, Grid& shardGrid, Topology topology, int shard, int shardCount, uint64_t generation)
+{
+	int range = region.range;
+	int wordsPerRow = region.wordsPerRow;
+	int width = shardGrid.GetWidth();
+	int firstBottomGhost = shardGrid.GetHeight() - range;
+
+	auto Fill = [&](int neighbour, bool acrossEdge, bool fromBottom, int firstGhost)
+	{
+		if (acrossEdge && topology == Topology::DeadBorder)
+		{
+			for (int row{ 0 }; row < range; row++)
+				std::fill(shardGrid.GetRow(firstGhost + row), shardGrid.GetRow(firstGhost + row) + wordsPerRow, uint64_t(0));
+			return;
+		}
+
+		WaitForGeneration(region, neighbour, generation);
+		const uint64_t* pBlock = region.GetBoundary(neighbour, generation, fromBottom);
+		for (int row{ 0 }; row < range; row++)
+		{
+			const uint64_t* pSource = pBlock + size_t(row) * wordsPerRow;
+			uint64_t* pTarget = shardGrid.GetRow(firstGhost + row);
+			if (acrossEdge && topology == Topology::KleinBottle)
+				MirrorRow(pSource, pTarget, width);
+			else
+				std::copy(pSource, pSource + wordsPerRow, pTarget);
+		}
+	};
+
+	Fill(shard == 0 ? shardCount - 1 : shard - 1, shard == 0, true, 0);
+	Fill(shard == shardCount - 1 ? 0 : shard + 1, shard == shardCount - 1, false, firstBottomGhost);
+	shardGrid.MarkEdited();
+}
+
+static void RunShard(const SharedRegion& region, const Grid& grid, const std::string& engineName, const std::string& rulestring,
+	int shard, int shardCount, int firstRow, int lastRow, uint64_t generations)
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(engineName, rulestring) };
+
+	//Left and right still wrap inside the shard, only the rows above and below come from the neighbours
+	int range = region.range;
+	int wordsPerRow = region.wordsPerRow;
+	Grid shardGrid{ grid.GetWidth(), lastRow - firstRow + 2 * range, 1 };
+	shardGrid.SetTopology(grid.GetTopology() == Topology::DeadBorder ? Topology::DeadBorder : Topology::Torus);
+
+	//The forked process sees the grid as it was, its pages are only copied if someone writes to them
+	for (int y{ firstRow }; y < lastRow; y++)
+		std::copy(grid.GetRow(y), grid.GetRow(y) + wordsPerRow, shardGrid.GetRow(range + y - firstRow));
+
+	Publish(region, shardGrid, shard, 0);
+	for (uint64_t generation{ 0 }; generation < generations; generation++)
+	{
+		FillGhostRows(region, shardGrid, grid.GetTopology(), shard, shardCount, generation);
+		pEngine->Step(shardGrid);
+		Publish(region, shardGrid, shard, generation + 1);
+	}
+
+	for (int y{ firstRow }; y < lastRow; y++)
+	{
+		const uint64_t* pRow = shardGrid.GetRow(range + y - firstRow);
+		std::copy(pRow, pRow + wordsPerRow, region.pResult + size_t(y) * wordsPerRow);
+	}
+}
+
+bool ShardedSimulation::IsSupported()
+{
+	return true;
+}
+
+void ShardedSimulation::Run(Grid& grid, uint64_t generations)
+{
+	std::vector<int> firstRows = SplitRows(grid.GetHeight());
+	int wordsPerRow = grid.GetWordsPerRow();
+
+	size_t ringWords = size_t(m_ShardCount) * RingSlots * 2 * m_Range * wordsPerRow;
+	size_t resultWords = size_t(grid.GetHeight()) * wordsPerRow;
+	size_t ringOffset = CacheLine * (size_t(m_ShardCount) + 1);
+	size_t resultOffset = ringOffset + ringWords * sizeof(uint64_t);
+
+	SharedRegion region{};
+	region.size = resultOffset + resultWords * sizeof(uint64_t);
+	region.wordsPerRow = wordsPerRow;
+	region.range = m_Range;
+	region.pMapping = mmap(nullptr, region.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (region.pMapping == MAP_FAILED)
+		throw std::runtime_error{ "Could not map " + std::to_string(region.size) + " bytes of shared memory" };
+
+	//The mapping starts out zeroed, the atomics only have to be constructed in it
+	char* pBytes = static_cast<char*>(region.pMapping);
+	region.pAbort = new (pBytes) std::atomic<uint32_t>{ 0 };
+	region.pChannels = reinterpret_cast<ShardChannel*>(pBytes + CacheLine);
+	for (int shard{ 0 }; shard < m_ShardCount; shard++)
+		new (&region.GetChannel(shard)) ShardChannel{ { 0 } };
+	region.pRing = reinterpret_cast<uint64_t*>(pBytes + ringOffset);
+	region.pResult = reinterpret_cast<uint64_t*>(pBytes + resultOffset);
+
+	//Anything still buffered would be written once more by every worker
+	std::cout.flush();
+	std::cerr.flush();
+
+	std::vector<pid_t> workers;
+	std::string error;
+	for (int shard{ 0 }; shard < m_ShardCount; shard++)
+	{
+		pid_t pid = fork();
+		if (pid < 0)
+		{
+			error = "Could not start the worker of shard " + std::to_string(shard) + ": " + std::strerror(errno);
+			Abort(region, m_ShardCount);
+			break;
+		}
+
+		if (pid == 0)
+		{
+			//The worker never returns into the caller, _exit skips the destructors and atexit handlers of the parent
+			int status{ 0 };
+			try
+			{
+				RunShard(region, grid, m_EngineName, m_Rulestring, shard, m_ShardCount, firstRows[shard], firstRows[shard + 1], generations);
+			}
+			catch (const std::exception& exception)
+			{
+				std::cerr << "Shard " << shard << ": " << exception.what() << std::endl;
+				Abort(region, m_ShardCount);
+				status = 1;
+			}
+			_exit(status);
+		}
+
+		workers.push_back(pid);
+	}
+
+	for (size_t i{ 0 }; i < workers.size(); i++)
+	{
+		int status{ 0 };
+		while (waitpid(workers[i], &status, 0) < 0 && errno == EINTR)
+		{
+		}
+
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		{
+			if (error.empty())
+				error = "The worker of shard " + std::to_string(i) + " failed";
+			Abort(region, m_ShardCount);
+		}
+	}
+
+	if (error.empty())
+	{
+		for (int y{ 0 }; y < grid.GetHeight(); y++)
+			std::copy(region.pResult + size_t(y) * wordsPerRow, region.pResult + size_t(y + 1) * wordsPerRow, grid.GetRow(y));
+		grid.SetGeneration(grid.GetGeneration() + generations);
+		grid.MarkEdited();
+	}
+
+	munmap(region.pMapping, region.size);
+	if (!error.empty())
+		throw std::runtime_error{ error };
+
+	m_ExchangedBytes = (generations + 1) * m_ShardCount * 2 * m_Range * wordsPerRow * sizeof(uint64_t);
+}
+
+#else
+
+bool ShardedSimulation::IsSupported()
+{
+	return false;
+}
+
+void ShardedSimulation::Run(Grid&, uint64_t)
+{
+	throw std::runtime_error{ "Sharded simulations need fork and futexes, they only run on Linux for now" };
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Grid;
+
+//Steps a grid split into horizontal shards, each owned by its own worker process on this machine.
+//A worker only holds its own rows plus 'range' ghost rows above and below them, where range is how far the rule reaches.
+//After every generation a worker publishes its first and last rows into a ring in shared memory
+//and copies those of its neighbours into its ghost rows, waiting on a futex until they are there.
+//The ghost rows follow the topology of the grid (dead, wrapped or mirrored), so the result is bit-identical to stepping
+//the whole grid in one process. Change-tracking engines lose their advantage: refilling the ghost rows counts as an edit.
+//
+//Workers are forked and the rows are exchanged through an anonymous shared mapping, which for now is Linux only.
+class ShardedSimulation final
+{
+public:
+	//Throws std::runtime_error for an unknown engine or an invalid rule, see EngineFactory::Create
+	ShardedSimulation(const std::string& engineName, const std::string& rulestring, int shardCount);
+	~ShardedSimulation() = default;
+	ShardedSimulation(const ShardedSimulation& other) = delete;
+	ShardedSimulation(ShardedSimulation&& other) = delete;
+	ShardedSimulation& operator=(const ShardedSimulation& other) = delete;
+	ShardedSimulation& operator=(ShardedSimulation&& other) = delete;
+
+	//False on platforms without fork and futexes, Run throws there
+	static bool IsSupported();
+
+	//Advances the grid by the given number of generations across the workers and waits for all of them.
+	//Throws std::runtime_error when the shards would be thinner than the range of the rule or a worker fails.
+	void Run(Grid& grid, uint64_t generations);
+
+	int GetShardCount() const;
+	//Boundary rows written into the ring by all workers together during the last Run
+	uint64_t GetExchangedBytes() const;
+
+private:
+	std::string m_EngineName;
+	std::string m_Rulestring;
+	int m_ShardCount;
+	int m_Range;
+	uint64_t m_ExchangedBytes;
+
+	//First row of every shard, plus the height of the grid at the end
+	std::vector<int> SplitRows(int height) const;
+};
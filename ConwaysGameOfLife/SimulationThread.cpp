@@ -0,0 +1,186 @@
+#include "SimulationThread.h"
+#include "LifeEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+SimulationThread::SimulationThread(const Grid& grid, LifeEngine* pEngine)
+	: m_Grid(grid)
+	, m_pEngine(pEngine)
+	, m_Frames(grid)
+	, m_Commands(1024)
+	, m_Stopping(false)
+	, m_Running(false)
+	, m_PauseOnCycle(true)
+	, m_TickDelay(0.f)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	Stop();
+}
+
+void SimulationThread::Start()
+{
+	if (m_Thread.joinable())
+		return;
+
+	m_Stopping = false;
+	m_Thread = std::thread{ &SimulationThread::ThreadLoop, this };
+}
+
+void SimulationThread::Stop()
+{
+	if (!m_Thread.joinable())
+		return;
+
+	m_Stopping = true;
+	m_Thread.join();
+
+	//Grids that were sent but never loaded are still owned by the queue
+	SimulationCommand command{};
+	while (m_Commands.TryPop(command))
+	{
+		if (command.type == CommandType::LoadGrid)
+			delete command.pGrid;
+	}
+}
+
+bool SimulationThread::PostCommand(const SimulationCommand& command)
+{
+	return m_Commands.TryPush(command);
+}
+
+void SimulationThread::SetRunning(bool running)
+{
+	m_Running = running;
+}
+
+bool SimulationThread::IsRunning() const
+{
+	return m_Running;
+}
+
+void SimulationThread::SetTickDelay(float seconds)
+{
+	m_TickDelay = std::max(0.f, seconds);
+}
+
+void SimulationThread::SetPauseOnCycle(bool pause)
+{
+	m_PauseOnCycle = pause;
+}
+
+const Grid& SimulationThread::AcquireFrame()
+{
+	m_Frames.Update();
+	return m_Frames.GetReadBuffer();
+}
+
+void SimulationThread::ThreadLoop()
+{
+	using Clock = std::chrono::steady_clock;
+	const Clock::duration idleSleep = std::chrono::milliseconds{ 1 };
+	Clock::time_point nextStep = Clock::now();
+
+	while (!m_Stopping)
+	{
+		bool changed = ExecuteCommands();
+
+		Clock::time_point now = Clock::now();
+		bool running = m_Running;
+		if (running && now >= nextStep)
+		{
+			StepGrid();
+			changed = true;
+
+			//A late generation does not make the next ones come sooner
+			nextStep = std::max(now, nextStep + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>{ m_TickDelay.load() }));
+
+			if (m_PauseOnCycle && m_CycleDetector.Update(m_Grid))
+			{
+				std::cout << "The grid repeats every " << m_CycleDetector.GetPeriod() << " generations since generation "
+					<< m_CycleDetector.GetCycleStart() << ", simulation paused" << std::endl;
+				m_Running = false;
+				m_CycleDetector.Reset();
+			}
+		}
+
+		if (changed)
+		{
+			PublishFrame();
+			continue;
+		}
+
+		//Nothing to do until the next generation is due or a command comes in, the queue has no way to wake this thread
+		std::this_thread::sleep_for(running ? std::min(idleSleep, nextStep - now) : idleSleep);
+	}
+}
+
+bool SimulationThread::ExecuteCommands()
+{
+	bool executed = false;
+	SimulationCommand command{};
+	while (m_Commands.TryPop(command))
+	{
+		Execute(command);
+		executed = true;
+	}
+
+	return executed;
+}
+
+void SimulationThread::Execute(const SimulationCommand& command)
+{
+	switch (command.type)
+	{
+	case CommandType::SetCell:
+		m_Grid.SetCell(command.x, command.y, command.alive);
+		break;
+	case CommandType::ToggleCell:
+		m_Grid.ToggleCell(command.x, command.y);
+		break;
+	case CommandType::Clear:
+		m_Grid.ClearGrid();
+		break;
+	case CommandType::SetTopology:
+		m_Grid.SetTopology(command.topology);
+		break;
+	case CommandType::LoadGrid:
+		m_Grid.CopyFrom(*command.pGrid);
+		delete command.pGrid;
+		m_CycleDetector.Reset();
+		break;
+	case CommandType::Step:
+		//Recording first drops the generations after a rewind when a cell was edited since
+		m_History.Record(m_Grid);
+		if (m_History.Contains(m_Grid.GetGeneration() + 1))
+			m_History.Rewind(m_Grid, m_Grid.GetGeneration() + 1);
+		else
+			StepGrid();
+		break;
+	case CommandType::Rewind:
+		m_Running = false;
+		if (m_History.Contains(command.generation))
+			m_History.Rewind(m_Grid, command.generation);
+		else
+			std::cout << "Generation " << command.generation << " is no longer in the history" << std::endl;
+		break;
+	}
+}
+
+void SimulationThread::StepGrid()
+{
+	//Recording before the step as well keeps edits made since the last one
+	m_History.Record(m_Grid);
+	m_pEngine->Step(m_Grid);
+	m_History.Record(m_Grid);
+}
+
+void SimulationThread::PublishFrame()
+{
+	m_Frames.GetWriteBuffer().CopyFrom(m_Grid);
+	m_Frames.Publish();
+}
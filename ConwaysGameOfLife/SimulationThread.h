@@ -0,0 +1,85 @@
+#pragma once
+#include "Cell.h"
+#include "CommandQueue.h"
+#include "CycleDetector.h"
+#include "GenerationHistory.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <thread>
+
+class LifeEngine;
+
+enum class CommandType
+{
+	SetCell,		//x, y, alive
+	ToggleCell,		//x, y
+	Clear,
+	SetTopology,	//topology
+	LoadGrid,		//pGrid, the simulation thread takes ownership and deletes it
+	Step,			//One generation, also while paused. Taken from the history when it still holds the next generation.
+	Rewind			//generation, pauses the simulation
+};
+
+struct SimulationCommand
+{
+	CommandType type;
+	int x;
+	int y;
+	bool alive;
+	Topology topology;
+	Grid* pGrid;
+	uint64_t generation;
+};
+
+//Steps a grid on its own thread, so a slow frame does not hold back the simulation and a busy simulation does not hold back the frames.
+//Every generation is published through a triple buffer, the render thread picks up the newest one without waiting.
+//Edits go the other way through a lock-free command queue and are applied between two generations.
+//All public functions are meant to be called from the one thread that owns this object.
+class SimulationThread final
+{
+public:
+	//The grid is copied. The engine stays owned by the caller and must not be used by anyone else between Start and Stop.
+	SimulationThread(const Grid& grid, LifeEngine* pEngine);
+	~SimulationThread();
+	SimulationThread(const SimulationThread& other) = delete;
+	SimulationThread(SimulationThread&& other) = delete;
+	SimulationThread& operator=(const SimulationThread& other) = delete;
+	SimulationThread& operator=(SimulationThread&& other) = delete;
+
+	void Start();
+	void Stop();
+
+	//Returns false when the queue is full, the command is then not executed
+	bool PostCommand(const SimulationCommand& command);
+
+	void SetRunning(bool running);
+	bool IsRunning() const;
+	//Minimum time between two generations, 0 steps as fast as possible
+	void SetTickDelay(float seconds);
+	//Pauses the simulation once the grid repeats itself
+	void SetPauseOnCycle(bool pause);
+
+	//The newest published generation, never blocks.
+	//The grid stays valid and unchanged until the next call.
+	const Grid& AcquireFrame();
+
+private:
+	Grid m_Grid;
+	LifeEngine* m_pEngine;
+	CycleDetector m_CycleDetector;
+	GenerationHistory m_History;
+	TripleBuffer<Grid> m_Frames;
+	CommandQueue<SimulationCommand> m_Commands;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_Stopping;
+	std::atomic<bool> m_Running;
+	std::atomic<bool> m_PauseOnCycle;
+	std::atomic<float> m_TickDelay;
+
+	void ThreadLoop();
+	bool ExecuteCommands();
+	void Execute(const SimulationCommand& command);
+	void PublishFrame();
+	void StepGrid();
+};
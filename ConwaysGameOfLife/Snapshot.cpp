@@ -0,0 +1,145 @@
+#include "Snapshot.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "The header is written and read as raw bytes");
+static_assert(sizeof(SnapshotHeader) <= Snapshot::DataOffset, "The header has to fit in front of the rows");
+
+static const char SnapshotMagic[8] = { 'L', 'I', 'F', 'E', 'S', 'N', 'A', 'P' };
+
+const uint32_t Snapshot::Version;
+const uint32_t Snapshot::DataOffset;
+
+//Puts the file at source in the place of target in one step, target is either the old or the new file at any time
+static bool MoveOverFile(const std::string& source, const std::string& target)
+{
+#if defined(_WIN32)
+	return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+void Snapshot::Save(const std::string& path, const Grid& grid, const std::string& rule)
+{
+	if (rule.size() >= sizeof(SnapshotHeader::rule))
+		throw std::runtime_error{ "Rule " + rule + " is too long for a snapshot" };
+
+	SnapshotHeader header{};
+	std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+	header.version = Version;
+	header.dataOffset = DataOffset;
+	header.width = grid.GetWidth();
+	header.height = grid.GetHeight();
+	header.cellSize = grid.GetCellSize();
+	header.wordsPerRow = grid.GetWordsPerRow();
+	header.stride = grid.GetStride();
+	header.topology = int32_t(grid.GetTopology());
+	header.generation = grid.GetGeneration();
+	header.checksum = grid.ComputeHash();
+	std::copy(rule.begin(), rule.end(), header.rule);
+
+	//The new file is written next to the target and only replaces it once it is complete, a failed save leaves the old one intact
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+		if (!file)
+			throw std::runtime_error{ "Could not create snapshot " + temporaryPath };
+
+		//The header is padded to a whole page so the rows start page aligned in the mapping
+		std::vector<char> page(DataOffset, 0);
+		std::memcpy(page.data(), &header, sizeof(header));
+		file.write(page.data(), page.size());
+
+		//The current generation with its halo is one contiguous block, the halo is filled again before every step
+		size_t bytes = grid.GetBufferWordCount() * sizeof(uint64_t);
+		file.write(reinterpret_cast<const char*>(grid.GetBuffer()), std::streamsize(bytes));
+		file.flush();
+
+		if (!file)
+		{
+			file.close();
+			std::remove(temporaryPath.c_str());
+			throw std::runtime_error{ "Could not write snapshot " + temporaryPath };
+		}
+	}
+
+	if (!MoveOverFile(temporaryPath, path))
+	{
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error{ "Could not replace snapshot " + path };
+	}
+}
+
+Snapshot::Snapshot(const std::string& path)
+	: m_pFile(new MappedFile{ path })
+	, m_Header{}
+{
+	auto Fail = [this, &path](const std::string& message)
+	{
+		delete m_pFile;
+		throw std::runtime_error{ "Snapshot " + path + ": " + message };
+	};
+
+	if (m_pFile->GetSize() < DataOffset)
+		Fail("file is too small");
+
+	std::memcpy(&m_Header, m_pFile->GetData(), sizeof(m_Header));
+	if (std::memcmp(m_Header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+		Fail("not a snapshot file");
+	if (m_Header.version != Version)
+		Fail("unsupported version " + std::to_string(m_Header.version));
+
+	//Only the header is checked, the rows are trusted until VerifyChecksum is called
+	if (m_Header.width <= 0 || m_Header.height <= 0 || m_Header.wordsPerRow != (m_Header.width + 63) / 64 || m_Header.stride != m_Header.wordsPerRow + 2)
+		Fail("invalid dimensions");
+	if (m_Header.topology < int32_t(Topology::DeadBorder) || m_Header.topology > int32_t(Topology::KleinBottle))
+		Fail("invalid topology");
+	if (m_Header.dataOffset < sizeof(SnapshotHeader) || m_Header.dataOffset % DataOffset != 0)
+		Fail("invalid data offset");
+	if (m_Header.rule[sizeof(m_Header.rule) - 1] != 0)
+		Fail("invalid rule");
+
+	size_t bytes = size_t(m_Header.stride) * (size_t(m_Header.height) + 2) * sizeof(uint64_t);
+	if (m_pFile->GetSize() - m_Header.dataOffset < bytes)
+		Fail("file is truncated");
+}
+
+Snapshot::~Snapshot()
+{
+	delete m_pFile;
+}
+
+const SnapshotHeader& Snapshot::GetHeader() const
+{
+	return m_Header;
+}
+
+std::string Snapshot::GetRule() const
+{
+	return std::string{ m_Header.rule };
+}
+
+Grid Snapshot::CreateGrid() const
+{
+	uint64_t* pWords = reinterpret_cast<uint64_t*>(m_pFile->GetData() + m_Header.dataOffset);
+	return Grid{ m_Header.width, m_Header.height, m_Header.cellSize, pWords, m_Header.generation, Topology(m_Header.topology) };
+}
+
+bool Snapshot::VerifyChecksum() const
+{
+	return CreateGrid().ComputeHash() == m_Header.checksum;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Cell.h"
+
+class MappedFile;
+
+//Fixed size header at the start of a snapshot file, all values are little endian
+struct SnapshotHeader
+{
+	char magic[8];			//"LIFESNAP"
+	uint32_t version;
+	uint32_t dataOffset;	//Offset of the first row, a multiple of the page size
+	int32_t width;
+	int32_t height;
+	int32_t cellSize;
+	int32_t wordsPerRow;
+	int32_t stride;			//Words per row including the halo, see Grid::GetRow
+	int32_t topology;		//Topology of the grid as its numeric value
+	uint64_t generation;
+	uint64_t checksum;		//Grid::ComputeHash of the cells
+	char rule[64];			//Rule in the notation of the engine that wrote it, 0 terminated
+};
+
+//Binary checkpoint of a grid: the header followed by the rows exactly as the grid stores them in memory, halo included.
+//Opening a snapshot maps the file copy-on-write and the grid steps straight from the mapped pages,
+//so even boards of billions of cells are ready without reading or parsing them first.
+class Snapshot final
+{
+public:
+	static const uint32_t Version = 2;
+	static const uint32_t DataOffset = 4096;
+
+	//Writes the current generation of the grid to path + ".tmp" and renames it over path, so the file at path is never half written.
+	//The snapshot a grid is mapped from can not be replaced while it is open on Windows, save to another path instead.
+	//Throws std::runtime_error when the file can not be written or replaced.
+	static void Save(const std::string& path, const Grid& grid, const std::string& rule);
+
+	//Maps the file and checks the header, throws std::runtime_error when it is not a valid snapshot
+	Snapshot(const std::string& path);
+	~Snapshot();
+	Snapshot(const Snapshot& other) = delete;
+	Snapshot(Snapshot&& other) = delete;
+	Snapshot& operator=(const Snapshot& other) = delete;
+	Snapshot& operator=(Snapshot&& other) = delete;
+
+	const SnapshotHeader& GetHeader() const;
+	std::string GetRule() const;
+
+	//Grid on top of the mapped rows, the snapshot has to outlive it. Cells that change are copied out of the file
+	//by the OS page by page, the file itself is never modified.
+	Grid CreateGrid() const;
+
+	//Hashes every row and compares it with the header, the only check that reads the whole file
+	bool VerifyChecksum() const;
+
+private:
+	MappedFile* m_pFile;
+	SnapshotHeader m_Header;
+};
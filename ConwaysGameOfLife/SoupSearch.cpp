@@ -0,0 +1,379 @@
+#include "SoupSearch.h"
+#include "EngineFactory.h"
+#include "LifeEngine.h"
+#include "CycleDetector.h"
+#include "FixedGrid.h"
+#include "ThreadPool.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+//xoshiro256** with several independent streams side by side. The state is stored lane by lane,
+//so every step is the same operation on neighbouring words and compilers turn the loops into vector instructions.
+class SoupRandom final
+{
+public:
+	static const int Lanes = 4;
+
+	//Every (seed, stream) pair gives its own sequence
+	SoupRandom(uint64_t seed, uint64_t stream)
+	{
+		//splitmix64 spreads the seed over the state, as recommended for xoshiro
+		uint64_t value = seed ^ (stream * 0xd1b54a32d192ed03ull);
+		for (int i{ 0 }; i < 4; i++)
+		{
+			for (int lane{ 0 }; lane < Lanes; lane++)
+			{
+				value += 0x9e3779b97f4a7c15ull;
+				uint64_t mixed = value;
+				mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+				mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+				m_State[i][lane] = mixed ^ (mixed >> 31);
+			}
+		}
+	}
+
+	void Next(uint64_t* pOut)
+	{
+		//The multiplications by 5 and 9 are written as shifts and adds, there is no 64 bit vector multiply before AVX-512
+		for (int lane{ 0 }; lane < Lanes; lane++)
+		{
+			uint64_t times5 = (m_State[1][lane] << 2) + m_State[1][lane];
+			uint64_t rotated = (times5 << 7) | (times5 >> 57);
+			pOut[lane] = (rotated << 3) + rotated;
+		}
+
+		for (int lane{ 0 }; lane < Lanes; lane++)
+		{
+			uint64_t t = m_State[1][lane] << 17;
+			m_State[2][lane] ^= m_State[0][lane];
+			m_State[3][lane] ^= m_State[1][lane];
+			m_State[1][lane] ^= m_State[2][lane];
+			m_State[0][lane] ^= m_State[3][lane];
+			m_State[2][lane] ^= t;
+			m_State[3][lane] = (m_State[3][lane] << 45) | (m_State[3][lane] >> 19);
+		}
+	}
+
+	//Words where every bit is set with the given chance, in steps of 1/256.
+	//Random words are combined from the lowest bit of the chance up: a set bit ors, a clear bit ands.
+	void NextWithDensity(int density256, uint64_t* pOut)
+	{
+		if (density256 >= 256)
+		{
+			std::fill(pOut, pOut + Lanes, ~uint64_t(0));
+			return;
+		}
+
+		std::fill(pOut, pOut + Lanes, uint64_t(0));
+		if (density256 <= 0)
+			return;
+
+		//Anding with 0 keeps 0, so the clear bits below the lowest set bit are skipped
+		uint64_t random[Lanes];
+		for (int bit{ CountTrailingZeros64(uint64_t(density256)) }; bit < 8; bit++)
+		{
+			Next(random);
+			bool set = (density256 >> bit) & 1;
+			for (int lane{ 0 }; lane < Lanes; lane++)
+				pOut[lane] = set ? (pOut[lane] | random[lane]) : (pOut[lane] & random[lane]);
+		}
+	}
+
+private:
+	uint64_t m_State[4][Lanes];
+};
+
+//Everything one thread needs to run soups, reused for every soup it picks up
+struct SoupWorker
+{
+	SoupWorker(int arenaSize, LifeEngine* pEngine)
+		: arena(arenaSize, arenaSize, 1)
+		, pEngine(pEngine)
+		, detector(64, CycleDetector::GetConfirmations(*pEngine))
+	{
+	}
+
+	Grid arena;
+	std::unique_ptr<LifeEngine> pEngine;
+	CycleDetector detector;
+	SoupSearchResult result;
+};
+
+//Works on a Grid and on a FixedGrid, a Grid still has to be marked as edited afterwards
+template <typename Arena>
+static void FillSoup(Arena& arena, int soupSize, int density256, SoupRandom& random)
+{
+	arena.ClearGrid();
+
+	//The soup is written a word at a time, a row of the soup can straddle two words of the arena
+	int offset = (arena.GetWidth() - soupSize) / 2;
+	uint64_t bits[SoupRandom::Lanes];
+	int lane = SoupRandom::Lanes;
+	for (int y{ 0 }; y < soupSize; y++)
+	{
+		uint64_t* pRow = arena.GetRow(offset + y);
+		for (int x{ 0 }; x < soupSize; x += 64)
+		{
+			if (lane == SoupRandom::Lanes)
+			{
+				random.NextWithDensity(density256, bits);
+				lane = 0;
+			}
+
+			int count = std::min(64, soupSize - x);
+			uint64_t word = count == 64 ? bits[lane++] : bits[lane++] & ((uint64_t(1) << count) - 1);
+
+			int cell = offset + x;
+			pRow[cell / 64] |= word << (cell % 64);
+			if (cell % 64 != 0 && count > 64 - cell % 64)
+				pRow[cell / 64 + 1] |= word >> (64 - cell % 64);
+		}
+	}
+}
+
+//What every soup shares, and what became of one soup
+struct SoupParameters
+{
+	Rule rule;
+	int soupSize;
+	int density256;
+	uint64_t maxGenerations;
+};
+
+struct SoupRun
+{
+	uint64_t generations = 0;
+	uint64_t population = 0;
+	bool settled = false;
+};
+
+static SoupRun RunGridSoup(SoupWorker& worker, const SoupParameters& parameters, SoupRandom& random)
+{
+	FillSoup(worker.arena, parameters.soupSize, parameters.density256, random);
+	worker.arena.MarkEdited();
+
+	SoupRun run{};
+	while (run.generations < parameters.maxGenerations && !run.settled)
+	{
+		worker.pEngine->Step(worker.arena);
+		++run.generations;
+		run.settled = worker.detector.Update(worker.arena);
+	}
+
+	run.population = worker.arena.GetPopulation();
+	return run;
+}
+
+//Runs the soup in an arena with its size compiled in, it ends up in the same states as with the bitwise engines
+template <int Size>
+static SoupRun RunFixedSoup(SoupWorker& worker, const SoupParameters& parameters, SoupRandom& random)
+{
+	FixedGrid<Size, Size> arena{};
+	FillSoup(arena, parameters.soupSize, parameters.density256, random);
+	worker.detector.Reset();
+
+	SoupRun run{};
+	while (run.generations < parameters.maxGenerations && !run.settled)
+	{
+		arena.Step(parameters.rule);
+		++run.generations;
+		run.settled = worker.detector.Update(arena.GetGeneration(), arena.ComputeCycleHash());
+	}
+
+	run.population = arena.GetPopulation();
+	return run;
+}
+
+using RunSoupFunction = SoupRun(*)(SoupWorker& worker, const SoupParameters& parameters, SoupRandom& random);
+
+//Arenas of these sizes are compiled in, any other size runs on a Grid
+static RunSoupFunction SelectRunSoup(int arenaSize, bool fixedArena)
+{
+	if (fixedArena)
+	{
+		switch (arenaSize)
+		{
+		case 32: return &RunFixedSoup<32>;
+		case 64: return &RunFixedSoup<64>;
+		case 128: return &RunFixedSoup<128>;
+		case 256: return &RunFixedSoup<256>;
+		}
+	}
+
+	return &RunGridSoup;
+}
+
+SoupSearch::SoupSearch(const SoupSearchOptions& options)
+	: m_Options(options)
+{
+}
+
+SoupSearchResult SoupSearch::Run()
+{
+	if (m_Options.soupSize <= 0 || m_Options.soupSize > m_Options.arenaSize)
+		throw std::runtime_error{ "The soup has to fit in the arena" };
+	if (m_Options.soupCount > uint64_t(INT32_MAX))
+		throw std::runtime_error{ "Too many soups" };
+
+	ThreadPool threadPool{ m_Options.threadCount };
+
+	//Creating the first engine checks the engine name and rule before any thread starts
+	std::vector<std::unique_ptr<SoupWorker>> workers;
+	for (int i{ 0 }; i < threadPool.GetThreadCount(); i++)
+	{
+		LifeEngine* pEngine = EngineFactory::Create(m_Options.engine, m_Options.rule);
+		pEngine->SetRecordChanges(true);
+		workers.emplace_back(new SoupWorker{ m_Options.arenaSize, pEngine });
+	}
+
+	SoupParameters parameters{};
+	parameters.rule = workers[0]->pEngine->GetRule();
+	parameters.soupSize = m_Options.soupSize;
+	parameters.density256 = int(std::lround(std::min(std::max(m_Options.density, 0.0), 1.0) * 256.0));
+	parameters.maxGenerations = m_Options.maxGenerations;
+	uint64_t seed = m_Options.seed;
+
+	//The bitwise engines only differ in instruction set, a FixedGrid steps the same rule with the size compiled in
+	bool bitwise = m_Options.engine.compare(0, 7, "bitwise") == 0;
+	RunSoupFunction pRunSoup = SelectRunSoup(m_Options.arenaSize, m_Options.fixedArena && bitwise);
+
+	auto runSoup = [&](int index, int threadIndex)
+	{
+		SoupWorker& worker = *workers[threadIndex];
+		SoupRandom random{ seed, uint64_t(index) };
+		SoupRun run = pRunSoup(worker, parameters, random);
+		uint64_t generations = run.generations;
+
+		SoupSearchResult& result = worker.result;
+		++result.soupCount;
+		result.totalGenerations += generations;
+		result.totalPopulation += run.population;
+		if (run.settled)
+		{
+			++result.settledCount;
+			++result.periodCounts[worker.detector.GetPeriod()];
+		}
+
+		//Ties go to the lowest index, so the longest soup does not depend on which thread ran what
+		if (generations > result.longestGenerations || (generations == result.longestGenerations && uint64_t(index) < result.longestSoup))
+		{
+			result.longestGenerations = generations;
+			result.longestSoup = uint64_t(index);
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	threadPool.ParallelForStealing(int(m_Options.soupCount), runSoup);
+	auto end = std::chrono::steady_clock::now();
+
+	SoupSearchResult result{};
+	for (const std::unique_ptr<SoupWorker>& pWorker : workers)
+	{
+		const SoupSearchResult& part = pWorker->result;
+		result.soupCount += part.soupCount;
+		result.settledCount += part.settledCount;
+		result.totalGenerations += part.totalGenerations;
+		result.totalPopulation += part.totalPopulation;
+		for (const std::pair<const uint64_t, uint64_t>& period : part.periodCounts)
+			result.periodCounts[period.first] += period.second;
+
+		if (part.soupCount != 0 && (part.longestGenerations > result.longestGenerations
+			|| (part.longestGenerations == result.longestGenerations && part.longestSoup < result.longestSoup)))
+		{
+			result.longestGenerations = part.longestGenerations;
+			result.longestSoup = part.longestSoup;
+		}
+	}
+
+	result.fixedArena = pRunSoup != &RunGridSoup;
+	result.seconds = std::chrono::duration<double>(end - start).count();
+	return result;
+}
+
+SoupSearchOptions SoupSearch::ParseArguments(int argc, char** argv)
+{
+	SoupSearchOptions options{};
+
+	for (int i{ 1 }; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			throw std::runtime_error{ "Missing value for " + argument };
+
+		std::string value = argv[++i];
+		try
+		{
+			if (argument == "--soups")
+				options.soupCount = std::stoull(value);
+			else if (argument == "--engine")
+				options.engine = value;
+			else if (argument == "--rule")
+				options.rule = value;
+			else if (argument == "--soup-size")
+				options.soupSize = std::stoi(value);
+			else if (argument == "--arena")
+				options.arenaSize = std::stoi(value);
+			else if (argument == "--generations")
+				options.maxGenerations = std::stoull(value);
+			else if (argument == "--density")
+				options.density = std::stod(value);
+			else if (argument == "--seed")
+				options.seed = std::stoull(value);
+			else if (argument == "--threads")
+				options.threadCount = std::stoi(value);
+			else if (argument == "--fixed-arena")
+				options.fixedArena = std::stoi(value) != 0;
+			else
+				throw std::runtime_error{ "Unknown argument " + argument };
+		}
+		catch (const std::logic_error&)
+		{
+			throw std::runtime_error{ "Invalid value \"" + value + "\" for " + argument };
+		}
+	}
+
+	return options;
+}
+
+void SoupSearch::PrintUsage(std::ostream& stream)
+{
+	stream << "Soup search: LifeHeadless --soups N [options]\n"
+		<< "  --soups N            number of random soups to run\n"
+		<< "  --engine NAME        dense engine to use (default bitwise)\n"
+		<< "  --rule RULE          rule in the notation of the engine (default B3/S23)\n"
+		<< "  --soup-size N        size of the random square (default 16)\n"
+		<< "  --arena N            size of the grid every soup runs in (default 256)\n"
+		<< "  --generations N      give up on a soup after this many generations (default 20000)\n"
+		<< "  --density D          chance of a cell being alive in the soup (default 0.5)\n"
+		<< "  --seed N             seed of the census (default 1)\n"
+		<< "  --threads N          threads, 0 = all cores (default 0)\n"
+		<< "  --fixed-arena 0|1    run 32, 64, 128 and 256 arenas of the bitwise engines with the size compiled in (default 1)\n";
+}
+
+void SoupSearch::PrintResult(const SoupSearchResult& result, std::ostream& stream)
+{
+	double seconds = result.seconds > 0.0 ? result.seconds : 1e-9;
+	double soups = result.soupCount > 0 ? double(result.soupCount) : 1.0;
+
+	stream << "soups: " << result.soupCount << "\n"
+		<< "settled: " << result.settledCount << "\n"
+		<< "seconds: " << std::fixed << std::setprecision(6) << result.seconds << "\n"
+		<< "soups/s: " << std::setprecision(1) << result.soupCount / seconds << "\n"
+		<< "generations/s: " << result.totalGenerations / seconds << "\n"
+		<< "average generations: " << result.totalGenerations / soups << "\n"
+		<< "average final population: " << result.totalPopulation / soups << "\n"
+		<< "longest soup: " << result.longestSoup << " (" << result.longestGenerations << " generations)\n"
+		<< "fixed arena: " << (result.fixedArena ? "yes" : "no") << "\n";
+	stream.unsetf(std::ios_base::floatfield);
+
+	for (const std::pair<const uint64_t, uint64_t>& period : result.periodCounts)
+		stream << "period " << period.first << ": " << period.second << "\n";
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+
+struct SoupSearchOptions
+{
+	std::string engine = "bitwise";	//Any dense engine name from EngineFactory
+	std::string rule;				//Empty keeps the default rule of the engine
+	uint64_t soupCount = 10000;
+	int soupSize = 16;				//Random square in the center of the arena
+	int arenaSize = 256;
+	uint64_t maxGenerations = 20000;	//Soups that have not settled by then are counted as unsettled
+	double density = 0.5;
+	uint64_t seed = 1;
+	int threadCount = 0;			//0 uses every hardware thread
+	bool fixedArena = true;			//Arenas of 32, 64, 128 or 256 cells run on a FixedGrid with the bitwise engines
+};
+
+struct SoupSearchResult
+{
+	uint64_t soupCount = 0;
+	uint64_t settledCount = 0;
+	uint64_t totalGenerations = 0;
+	uint64_t totalPopulation = 0;	//Summed over the final generation of every soup
+	uint64_t longestSoup = 0;		//Index of the soup that took the most generations to settle
+	uint64_t longestGenerations = 0;
+	std::map<uint64_t, uint64_t> periodCounts;	//Settled soups per period of their final cycle
+	bool fixedArena = false;		//Whether the soups ran on a FixedGrid
+	double seconds = 0.0;
+};
+
+//Census of many small random soups: every soup is run in its own arena until it settles into a cycle.
+//Soups are independent tasks spread over all cores with work stealing, each thread reuses one arena and engine.
+//Soup n only depends on the seed and n, so results do not depend on the thread count.
+class SoupSearch final
+{
+public:
+	SoupSearch(const SoupSearchOptions& options);
+	~SoupSearch() = default;
+	SoupSearch(const SoupSearch& other) = delete;
+	SoupSearch(SoupSearch&& other) = delete;
+	SoupSearch& operator=(const SoupSearch& other) = delete;
+	SoupSearch& operator=(SoupSearch&& other) = delete;
+
+	//Throws std::runtime_error when the engine or rule can not be used or the soup does not fit in the arena
+	SoupSearchResult Run();
+
+	//Throws std::runtime_error on unknown or malformed arguments
+	static SoupSearchOptions ParseArguments(int argc, char** argv);
+	static void PrintUsage(std::ostream& stream);
+	static void PrintResult(const SoupSearchResult& result, std::ostream& stream);
+
+private:
+	SoupSearchOptions m_Options;
+};
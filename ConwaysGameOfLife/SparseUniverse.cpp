@@ -0,0 +1,351 @@
+#include "SparseUniverse.h"
+#include "BitwiseKernel.h"
+#include "Cell.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const uint16_t SparseUniverse::AllNeighbours;
+
+static uint16_t NeighbourBit(int offsetX, int offsetY)
+{
+	return uint16_t(1 << ((offsetY + 1) * 3 + offsetX + 1));
+}
+
+template <typename RuleKernel>
+static void StepTileRows(const uint64_t* pWest, const uint64_t* pCenter, const uint64_t* pEast, uint64_t* pNext, const Rule& rule)
+{
+	for (int row{ 0 }; row < 64; row++)
+	{
+		pNext[row] = NextGeneration<SwarOps, RuleKernel>(pWest[row], pCenter[row], pEast[row],
+			pWest[row + 1], pCenter[row + 1], pEast[row + 1],
+			pWest[row + 2], pCenter[row + 2], pEast[row + 2], rule);
+	}
+}
+
+struct StepTileRowsSelector
+{
+	using Result = void(*)(const uint64_t*, const uint64_t*, const uint64_t*, uint64_t*, const Rule&);
+
+	template <typename RuleKernel>
+	Result Select() const
+	{
+		return &StepTileRows<RuleKernel>;
+	}
+};
+
+static StepTileRowsSelector::Result SelectStepTileRows(const Rule& rule)
+{
+	StepTileRowsSelector selector{};
+	return SelectRuleKernel(rule, selector);
+}
+
+SparseUniverse::SparseUniverse()
+	: m_pStepRows(SelectStepTileRows(m_Rule))
+	, m_Generation(0)
+	, m_VisitedTiles(0)
+{
+}
+
+void SparseUniverse::Clear()
+{
+	m_Tiles.clear();
+	m_ActiveTiles.clear();
+	m_Generation = 0;
+	m_VisitedTiles = 0;
+}
+
+void SparseUniverse::SetRule(const Rule& rule)
+{
+	if (rule.IsBorn(0))
+		throw std::runtime_error("SparseUniverse: rules with B0 are not supported");
+
+	m_Rule = rule;
+	m_pStepRows = SelectStepTileRows(rule);
+
+	//Tiles that were stable under the old rule might not be under the new one
+	for (auto& entry : m_Tiles)
+		Activate(entry.first, entry.second, AllNeighbours);
+}
+
+const Rule& SparseUniverse::GetRule() const
+{
+	return m_Rule;
+}
+
+void SparseUniverse::LoadGrid(const Grid& grid, int64_t originX, int64_t originY)
+{
+	Clear();
+
+	grid.ForEachAliveCell([this, originX, originY](int x, int y)
+		{
+			SetCell(originX + x, originY + y, true);
+		}
+	);
+	m_Generation = grid.GetGeneration();
+}
+
+void SparseUniverse::SetCell(int64_t x, int64_t y, bool alive)
+{
+	int32_t tileX = ToTileCoordinate(x);
+	int32_t tileY = ToTileCoordinate(y);
+	int localX = int(x - int64_t(tileX) * TileSize);
+	int localY = int(y - int64_t(tileY) * TileSize);
+
+	//Killing a cell in a tile that does not exist changes nothing
+	if (!alive && !FindTile(tileX, tileY))
+		return;
+
+	Tile& tile = GetOrCreateTile(tileX, tileY);
+	uint64_t bit = uint64_t(1) << localX;
+	if (alive)
+		tile.rows[localY] |= bit;
+	else
+		tile.rows[localY] &= ~bit;
+
+	Activate(MakeKey(tileX, tileY), tile, AllNeighbours);
+}
+
+bool SparseUniverse::IsAlive(int64_t x, int64_t y) const
+{
+	int32_t tileX = ToTileCoordinate(x);
+	int32_t tileY = ToTileCoordinate(y);
+	const Tile* pTile = FindTile(tileX, tileY);
+	if (!pTile)
+		return false;
+
+	int localX = int(x - int64_t(tileX) * TileSize);
+	int localY = int(y - int64_t(tileY) * TileSize);
+	return (pTile->rows[localY] >> localX) & 1;
+}
+
+void SparseUniverse::Step()
+{
+	//Collect every active tile and the neighbours its changes reach, these are the only tiles that can change
+	m_Candidates.clear();
+	for (uint64_t key : m_ActiveTiles)
+	{
+		uint16_t neighbours = m_Tiles.find(key)->second.neighbours;
+		int32_t tileX = GetTileX(key);
+		int32_t tileY = GetTileY(key);
+		for (int offsetY{ -1 }; offsetY <= 1; offsetY++)
+		{
+			for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+			{
+				if (neighbours & NeighbourBit(offsetX, offsetY))
+					m_Candidates.push_back(MakeKey(tileX + offsetX, tileY + offsetY));
+			}
+		}
+	}
+
+	std::sort(m_Candidates.begin(), m_Candidates.end());
+	m_Candidates.erase(std::unique(m_Candidates.begin(), m_Candidates.end()), m_Candidates.end());
+	m_VisitedTiles = m_Candidates.size();
+
+	//Compute all new tiles first, the tiles of the current generation are still needed as neighbours
+	m_Pending.resize(m_Candidates.size());
+	for (size_t i{ 0 }; i < m_Candidates.size(); i++)
+	{
+		m_Pending[i].key = m_Candidates[i];
+		StepTile(GetTileX(m_Candidates[i]), GetTileY(m_Candidates[i]), m_Pending[i]);
+	}
+
+	//Only the tiles that were active can still be marked as such
+	for (uint64_t key : m_ActiveTiles)
+	{
+		Tile& tile = m_Tiles.find(key)->second;
+		tile.active = false;
+		tile.neighbours = 0;
+	}
+	m_ActiveTiles.clear();
+
+	for (const PendingTile& pending : m_Pending)
+	{
+		if (pending.neighbours != 0)
+		{
+			//Tiles that just died stay for one more generation, so the neighbours they touched get visited
+			Tile& tile = GetOrCreateTile(GetTileX(pending.key), GetTileY(pending.key));
+			std::copy(pending.rows, pending.rows + TileSize, tile.rows);
+			Activate(pending.key, tile, pending.neighbours);
+		}
+		else if (pending.empty)
+		{
+			//Empty space that stays empty does not need a tile
+			m_Tiles.erase(pending.key);
+		}
+	}
+
+	++m_Generation;
+}
+
+void SparseUniverse::WriteToGrid(Grid& grid, int64_t originX, int64_t originY) const
+{
+	grid.ClearGrid();
+
+	//Only look at the tiles that overlap the region of the grid
+	int32_t firstTileX = ToTileCoordinate(originX);
+	int32_t firstTileY = ToTileCoordinate(originY);
+	int32_t lastTileX = ToTileCoordinate(originX + grid.GetWidth() - 1);
+	int32_t lastTileY = ToTileCoordinate(originY + grid.GetHeight() - 1);
+
+	for (int32_t tileY{ firstTileY }; tileY <= lastTileY; tileY++)
+	{
+		for (int32_t tileX{ firstTileX }; tileX <= lastTileX; tileX++)
+		{
+			const Tile* pTile = FindTile(tileX, tileY);
+			if (!pTile)
+				continue;
+
+			for (int row{ 0 }; row < TileSize; row++)
+			{
+				int64_t y = int64_t(tileY) * TileSize + row - originY;
+				uint64_t word = pTile->rows[row];
+				if (word == 0 || y < 0 || y >= grid.GetHeight())
+					continue;
+
+				while (word)
+				{
+					int64_t x = int64_t(tileX) * TileSize + CountTrailingZeros64(word) - originX;
+					if (x >= 0 && x < grid.GetWidth())
+						grid.SetCell(int(x), int(y), true);
+
+					word &= word - 1;
+				}
+			}
+		}
+	}
+}
+
+uint64_t SparseUniverse::GetGeneration() const
+{
+	return m_Generation;
+}
+
+uint64_t SparseUniverse::GetPopulation() const
+{
+	uint64_t population = 0;
+	for (const auto& entry : m_Tiles)
+	{
+		for (uint64_t row : entry.second.rows)
+			population += PopCount64(row);
+	}
+
+	return population;
+}
+
+size_t SparseUniverse::GetTileCount() const
+{
+	return m_Tiles.size();
+}
+
+size_t SparseUniverse::GetVisitedTileCount() const
+{
+	return m_VisitedTiles;
+}
+
+uint64_t SparseUniverse::MakeKey(int32_t tileX, int32_t tileY)
+{
+	return (uint64_t(uint32_t(tileX)) << 32) | uint32_t(tileY);
+}
+
+int32_t SparseUniverse::GetTileX(uint64_t key)
+{
+	return int32_t(uint32_t(key >> 32));
+}
+
+int32_t SparseUniverse::GetTileY(uint64_t key)
+{
+	return int32_t(uint32_t(key));
+}
+
+int32_t SparseUniverse::ToTileCoordinate(int64_t cellCoordinate)
+{
+	//Round towards negative infinity so negative coordinates end up in the right tile
+	int64_t tile = cellCoordinate / TileSize;
+	if (cellCoordinate % TileSize < 0)
+		--tile;
+
+	return int32_t(tile);
+}
+
+const SparseUniverse::Tile* SparseUniverse::FindTile(int32_t tileX, int32_t tileY) const
+{
+	auto it = m_Tiles.find(MakeKey(tileX, tileY));
+	return it != m_Tiles.end() ? &it->second : nullptr;
+}
+
+SparseUniverse::Tile& SparseUniverse::GetOrCreateTile(int32_t tileX, int32_t tileY)
+{
+	auto it = m_Tiles.find(MakeKey(tileX, tileY));
+	if (it != m_Tiles.end())
+		return it->second;
+
+	Tile tile{};
+	return m_Tiles.emplace(MakeKey(tileX, tileY), tile).first->second;
+}
+
+void SparseUniverse::Activate(uint64_t key, Tile& tile, uint16_t neighbours)
+{
+	if (!tile.active)
+		m_ActiveTiles.push_back(key);
+
+	tile.active = true;
+	tile.neighbours |= neighbours;
+}
+
+void SparseUniverse::StepTile(int32_t tileX, int32_t tileY, PendingTile& pending) const
+{
+	//The 3x3 block of tiles around this one, missing tiles are dead space
+	const Tile* tiles[3][3];
+	for (int offsetY{ -1 }; offsetY <= 1; offsetY++)
+	{
+		for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+			tiles[offsetY + 1][offsetX + 1] = FindTile(tileX + offsetX, tileY + offsetY);
+	}
+
+	//Gather rows -1 to 64 with the cells left and right of the tile shifted into place
+	uint64_t west[TileSize + 2];
+	uint64_t center[TileSize + 2];
+	uint64_t east[TileSize + 2];
+	for (int row{ -1 }; row <= TileSize; row++)
+	{
+		int tileRow = row < 0 ? 0 : (row < TileSize ? 1 : 2);
+		int localRow = (row + TileSize) % TileSize;
+
+		uint64_t westWord = tiles[tileRow][0] ? tiles[tileRow][0]->rows[localRow] : 0;
+		uint64_t centerWord = tiles[tileRow][1] ? tiles[tileRow][1]->rows[localRow] : 0;
+		uint64_t eastWord = tiles[tileRow][2] ? tiles[tileRow][2]->rows[localRow] : 0;
+
+		west[row + 1] = (centerWord << 1) | (westWord >> 63);
+		center[row + 1] = centerWord;
+		east[row + 1] = (centerWord >> 1) | (eastWord << 63);
+	}
+
+	//While stepping, note whether anything is left and in which columns cells changed
+	uint64_t* pNextRows = pending.rows;
+	uint64_t any = 0;
+	uint64_t changedColumns = 0;
+	m_pStepRows(west, center, east, pNextRows, m_Rule);
+	for (int row{ 0 }; row < TileSize; row++)
+	{
+		any |= pNextRows[row];
+		changedColumns |= pNextRows[row] ^ center[row + 1];
+	}
+	pending.empty = any == 0;
+
+	//A change only reaches the neighbours on the edges it touched, bit 0 is the west edge and bit 63 the east edge
+	uint64_t firstRow = pNextRows[0] ^ center[1];
+	uint64_t lastRow = pNextRows[TileSize - 1] ^ center[TileSize];
+	uint16_t neighbours = changedColumns != 0 ? NeighbourBit(0, 0) : 0;
+	for (int offsetX{ -1 }; offsetX <= 1; offsetX++)
+	{
+		uint64_t columns = offsetX < 0 ? 1 : (offsetX > 0 ? uint64_t(1) << 63 : ~uint64_t(0));
+		if (offsetX != 0 && (changedColumns & columns))
+			neighbours |= NeighbourBit(offsetX, 0);
+		if (firstRow & columns)
+			neighbours |= NeighbourBit(offsetX, -1);
+		if (lastRow & columns)
+			neighbours |= NeighbourBit(offsetX, 1);
+	}
+	pending.neighbours = neighbours;
+}
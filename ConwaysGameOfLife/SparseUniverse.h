@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Rule.h"
+
+class Grid;
+
+//Unbounded universe made of 64x64 tiles that only exist where there are alive cells.
+//Tiles are stored in a hash map keyed by their tile coordinate, one 64 bit word per tile row.
+//A step only visits tiles that changed in the previous generation and those of their 8 neighbours
+//next to an edge where something changed, so the cost follows the activity of the pattern instead of its bounding box.
+//Tiles that did not change are not touched at all, not even to reset them.
+class SparseUniverse final
+{
+public:
+	SparseUniverse();
+	~SparseUniverse() = default;
+	SparseUniverse(const SparseUniverse& other) = delete;
+	SparseUniverse(SparseUniverse&& other) = delete;
+	SparseUniverse& operator=(const SparseUniverse& other) = delete;
+	SparseUniverse& operator=(SparseUniverse&& other) = delete;
+
+	void Clear();
+
+	//Rules with birth on 0 neighbours would fill the infinite empty space and are rejected with std::runtime_error
+	void SetRule(const Rule& rule);
+	const Rule& GetRule() const;
+
+	void LoadGrid(const Grid& grid, int64_t originX = 0, int64_t originY = 0);
+	void SetCell(int64_t x, int64_t y, bool alive);
+	bool IsAlive(int64_t x, int64_t y) const;
+
+	void Step();
+
+	//Writes the cells of the region starting at (originX, originY) with the size of the grid into the grid
+	void WriteToGrid(Grid& grid, int64_t originX = 0, int64_t originY = 0) const;
+
+	uint64_t GetGeneration() const;
+	uint64_t GetPopulation() const;
+	size_t GetTileCount() const;
+	size_t GetVisitedTileCount() const;
+
+private:
+	static const int TileSize = 64;
+
+	//Bit (offsetY + 1) * 3 + offsetX + 1 stands for the tile at that offset, bit 4 for the tile itself
+	static const uint16_t AllNeighbours = 0x1FF;
+
+	struct Tile
+	{
+		uint64_t rows[TileSize];
+		bool active;			//Changed in the last generation (or was edited) and listed in m_ActiveTiles
+		uint16_t neighbours;	//Tiles the change can reach, these need stepping
+	};
+
+	//Steps the 64 rows of a tile from the gathered rows -1 to 64, with the cells left and right of them shifted into place
+	using StepRowsFunction = void(*)(const uint64_t* pWest, const uint64_t* pCenter, const uint64_t* pEast, uint64_t* pNext, const Rule& rule);
+
+	struct PendingTile
+	{
+		uint64_t key;
+		uint64_t rows[TileSize];
+		bool empty;
+		uint16_t neighbours;	//0 when nothing changed
+	};
+
+	std::unordered_map<uint64_t, Tile> m_Tiles;
+	std::vector<uint64_t> m_ActiveTiles;
+	std::vector<uint64_t> m_Candidates;
+	std::vector<PendingTile> m_Pending;
+	Rule m_Rule;
+	StepRowsFunction m_pStepRows;	//Compiled for the rule, or the runtime kernel
+	uint64_t m_Generation;
+	size_t m_VisitedTiles;
+
+	static uint64_t MakeKey(int32_t tileX, int32_t tileY);
+	static int32_t GetTileX(uint64_t key);
+	static int32_t GetTileY(uint64_t key);
+	static int32_t ToTileCoordinate(int64_t cellCoordinate);
+
+	const Tile* FindTile(int32_t tileX, int32_t tileY) const;
+	Tile& GetOrCreateTile(int32_t tileX, int32_t tileY);
+	void Activate(uint64_t key, Tile& tile, uint16_t neighbours);
+	void StepTile(int32_t tileX, int32_t tileY, PendingTile& pending) const;
+};
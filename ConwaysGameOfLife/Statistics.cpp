@@ -0,0 +1,68 @@
+#include "Statistics.h"
+#include "Cell.h"
+
+#include <ostream>
+
+void StatisticsSink::Finish()
+{
+}
+
+CsvStatisticsSink::CsvStatisticsSink(std::ostream& stream, int flushInterval)
+	: m_Stream(stream)
+	, m_FlushInterval(flushInterval)
+	, m_Unflushed(0)
+{
+	m_Stream << "generation,population,births,deaths,minX,minY,maxX,maxY\n";
+}
+
+void CsvStatisticsSink::Write(const GenerationStatistics& statistics)
+{
+	m_Stream << statistics.generation << ',' << statistics.population << ',' << statistics.births << ',' << statistics.deaths
+		<< ',' << statistics.minX << ',' << statistics.minY << ',' << statistics.maxX << ',' << statistics.maxY << '\n';
+
+	if (++m_Unflushed >= m_FlushInterval)
+	{
+		m_Stream.flush();
+		m_Unflushed = 0;
+	}
+}
+
+void CsvStatisticsSink::Finish()
+{
+	m_Stream.flush();
+}
+
+JsonStatisticsSink::JsonStatisticsSink(std::ostream& stream, int flushInterval)
+	: m_Stream(stream)
+	, m_FlushInterval(flushInterval)
+	, m_Unflushed(0)
+	, m_First(true)
+{
+	m_Stream << "[";
+}
+
+void JsonStatisticsSink::Write(const GenerationStatistics& statistics)
+{
+	m_Stream << (m_First ? "\n" : ",\n")
+		<< "  {\"generation\": " << statistics.generation
+		<< ", \"population\": " << statistics.population
+		<< ", \"births\": " << statistics.births
+		<< ", \"deaths\": " << statistics.deaths
+		<< ", \"minX\": " << statistics.minX
+		<< ", \"minY\": " << statistics.minY
+		<< ", \"maxX\": " << statistics.maxX
+		<< ", \"maxY\": " << statistics.maxY << "}";
+	m_First = false;
+
+	if (++m_Unflushed >= m_FlushInterval)
+	{
+		m_Stream.flush();
+		m_Unflushed = 0;
+	}
+}
+
+void JsonStatisticsSink::Finish()
+{
+	m_Stream << "\n]\n";
+	m_Stream.flush();
+}
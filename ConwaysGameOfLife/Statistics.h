@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+
+struct GenerationStatistics;
+
+//Receives the statistics of the generations of a run, e.g. to write them out as a time series.
+//Every generation is one record, so a long run can be monitored while it runs without reading the grid.
+class StatisticsSink
+{
+public:
+	StatisticsSink() = default;
+	virtual ~StatisticsSink() = default;
+	StatisticsSink(const StatisticsSink& other) = delete;
+	StatisticsSink(StatisticsSink&& other) = delete;
+	StatisticsSink& operator=(const StatisticsSink& other) = delete;
+	StatisticsSink& operator=(StatisticsSink&& other) = delete;
+
+	virtual void Write(const GenerationStatistics& statistics) = 0;
+	//Called once after the last generation
+	virtual void Finish();
+};
+
+//One line per generation after a header line, flushed every flushInterval lines so the file can be followed while it grows
+class CsvStatisticsSink final : public StatisticsSink
+{
+public:
+	CsvStatisticsSink(std::ostream& stream, int flushInterval = 64);
+	virtual ~CsvStatisticsSink() = default;
+	CsvStatisticsSink(const CsvStatisticsSink& other) = delete;
+	CsvStatisticsSink(CsvStatisticsSink&& other) = delete;
+	CsvStatisticsSink& operator=(const CsvStatisticsSink& other) = delete;
+	CsvStatisticsSink& operator=(CsvStatisticsSink&& other) = delete;
+
+	virtual void Write(const GenerationStatistics& statistics) override;
+	virtual void Finish() override;
+
+private:
+	std::ostream& m_Stream;
+	int m_FlushInterval;
+	int m_Unflushed;
+};
+
+//A JSON array with one object per generation, only complete once Finish closed it
+class JsonStatisticsSink final : public StatisticsSink
+{
+public:
+	JsonStatisticsSink(std::ostream& stream, int flushInterval = 64);
+	virtual ~JsonStatisticsSink() = default;
+	JsonStatisticsSink(const JsonStatisticsSink& other) = delete;
+	JsonStatisticsSink(JsonStatisticsSink&& other) = delete;
+	JsonStatisticsSink& operator=(const JsonStatisticsSink& other) = delete;
+	JsonStatisticsSink& operator=(JsonStatisticsSink&& other) = delete;
+
+	virtual void Write(const GenerationStatistics& statistics) override;
+	virtual void Finish() override;
+
+private:
+	std::ostream& m_Stream;
+	int m_FlushInterval;
+	int m_Unflushed;
+	bool m_First;
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include "Bits.h"
+
+//Counting kernel LifeEngine runs over every row right after stepping it, while the row is still in the cache.
+//It compares the next generation with the current one word by word, two popcounts per word give its births and deaths.
+//The population follows from those as long as the population of the generation before is known, otherwise it is counted as well.
+//
+//Like the Life kernels there is a portable version here and an AVX2 one in its own translation unit,
+//which counts 4 words at once and may only be called after CpuFeatures confirmed AVX2 and popcnt.
+
+//Partial statistics of a range of rows, merged into those of the whole generation after the step
+struct RowStatistics
+{
+	uint64_t population = 0;
+	uint64_t births = 0;
+	uint64_t deaths = 0;
+	int minX = INT_MAX;
+	int minY = INT_MAX;
+	int maxX = -1;
+	int maxY = -1;
+};
+
+//Adds the births, deaths and (when asked for) population of one row to the statistics.
+//The padding bits of the current row may hold the halo column, so the last word of both rows is masked.
+//Returns the last word of the next row with an alive cell, -1 for an empty row.
+template <bool CountPopulation>
+inline int CountRow(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	uint64_t population = 0;
+	uint64_t births = 0;
+	uint64_t deaths = 0;
+	int lastWord = -1;
+
+	//Without a single branch per word, a settled soup mixes empty, still and changing words too randomly to predict
+	for (int w{ 0 }; w < wordCount; w++)
+	{
+		uint64_t mask = w == wordCount - 1 ? lastWordMask : ~uint64_t(0);
+		uint64_t current = pRow[w] & mask;
+		uint64_t next = pNext[w] & mask;
+		uint64_t changed = current ^ next;
+		births += PopCount64(changed & next);
+		deaths += PopCount64(changed & current);
+		if (CountPopulation)
+			population += PopCount64(next);
+		lastWord = next != 0 ? w : lastWord;
+	}
+
+	statistics.population += population;
+	statistics.births += births;
+	statistics.deaths += deaths;
+	return lastWord;
+}
+
+using CountRowFunction = int(*)(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics);
+
+//The AVX2 versions of CountRow<false> and CountRow<true>
+int CountRowAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics);
+int CountRowWithPopulationAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics);
@@ -0,0 +1,128 @@
+#include "StatisticsKernel.h"
+
+//This file is compiled with AVX2 code generation enabled (/arch:AVX2, -mavx2), which includes popcnt.
+//Nothing in here may run before CpuFeatures::HasAvx2() and HasPopcnt() returned true.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+static uint64_t PopCountWord(uint64_t word)
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return uint64_t(_mm_popcnt_u64(word));
+#else
+	return uint64_t(_mm_popcnt_u32(uint32_t(word)) + _mm_popcnt_u32(uint32_t(word >> 32)));
+#endif
+}
+
+//Sum of the 4 words of a vector
+static uint64_t AddLanes(__m256i vector)
+{
+	alignas(32) uint64_t lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vector);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+template <bool CountPopulation>
+static int CountRowVector(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	//Every byte is counted by looking up its two nibbles in a 16 entry table
+	const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+	const __m256i zero = _mm256_setzero_si256();
+	auto CountBytes = [&](__m256i vector)
+	{
+		__m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(vector, lowNibbles));
+		__m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(vector, 4), lowNibbles));
+		return _mm256_add_epi8(low, high);
+	};
+
+	//A byte counts at most 8 per vector, so the byte counters are added up into words every 31 vectors
+	__m256i birthBytes = zero, deathBytes = zero, populationBytes = zero;
+	__m256i births = zero, deaths = zero, population = zero;
+	auto Flush = [&]()
+	{
+		births = _mm256_add_epi64(births, _mm256_sad_epu8(birthBytes, zero));
+		deaths = _mm256_add_epi64(deaths, _mm256_sad_epu8(deathBytes, zero));
+		if (CountPopulation)
+			population = _mm256_add_epi64(population, _mm256_sad_epu8(populationBytes, zero));
+		birthBytes = deathBytes = populationBytes = zero;
+	};
+
+	//The masked last word is left to the scalar loop below
+	int lastVector = -1;
+	int pending{ 0 };
+	int w{ 0 };
+	for (; w + 4 <= wordCount - 1; w += 4)
+	{
+		__m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow + w));
+		__m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pNext + w));
+		__m256i changed = _mm256_xor_si256(current, next);
+		birthBytes = _mm256_add_epi8(birthBytes, CountBytes(_mm256_and_si256(changed, next)));
+		deathBytes = _mm256_add_epi8(deathBytes, CountBytes(_mm256_and_si256(changed, current)));
+		if (CountPopulation)
+			populationBytes = _mm256_add_epi8(populationBytes, CountBytes(next));
+		lastVector = _mm256_testz_si256(next, next) ? lastVector : w;
+
+		if (++pending == 31)
+		{
+			Flush();
+			pending = 0;
+		}
+	}
+	Flush();
+
+	uint64_t rowBirths = AddLanes(births);
+	uint64_t rowDeaths = AddLanes(deaths);
+	uint64_t rowPopulation = CountPopulation ? AddLanes(population) : 0;
+	int lastWord = -1;
+	for (; w < wordCount; w++)
+	{
+		uint64_t mask = w == wordCount - 1 ? lastWordMask : ~uint64_t(0);
+		uint64_t current = pRow[w] & mask;
+		uint64_t next = pNext[w] & mask;
+		uint64_t changed = current ^ next;
+		rowBirths += PopCountWord(changed & next);
+		rowDeaths += PopCountWord(changed & current);
+		if (CountPopulation)
+			rowPopulation += PopCountWord(next);
+		lastWord = next != 0 ? w : lastWord;
+	}
+
+	//Only the vector is known, the word is found in it afterwards
+	if (lastWord < 0 && lastVector >= 0)
+	{
+		lastWord = lastVector + 3;
+		while (pNext[lastWord] == 0)
+			--lastWord;
+	}
+
+	statistics.population += rowPopulation;
+	statistics.births += rowBirths;
+	statistics.deaths += rowDeaths;
+	return lastWord;
+}
+
+int CountRowAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	return CountRowVector<false>(pRow, pNext, wordCount, lastWordMask, statistics);
+}
+
+int CountRowWithPopulationAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	return CountRowVector<true>(pRow, pNext, wordCount, lastWordMask, statistics);
+}
+
+#else
+
+//No AVX2 on this architecture, CpuFeatures never reports it so the portable kernel is all there is
+int CountRowAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	return CountRow<false>(pRow, pNext, wordCount, lastWordMask, statistics);
+}
+
+int CountRowWithPopulationAvx2(const uint64_t* pRow, const uint64_t* pNext, int wordCount, uint64_t lastWordMask, RowStatistics& statistics)
+{
+	return CountRow<true>(pRow, pNext, wordCount, lastWordMask, statistics);
+}
+
+#endif
@@ -0,0 +1,175 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int threadCount)
+	: m_pTaskFunction(nullptr)
+	, m_pTask(nullptr)
+	, m_TaskCount(0)
+	, m_NextTask(0)
+	, m_BusyWorkers(0)
+	, m_JobId(0)
+	, m_Stopping(false)
+	, m_Stealing(false)
+{
+	if (threadCount <= 0)
+		threadCount = int(std::thread::hardware_concurrency());
+	if (threadCount <= 0)
+		threadCount = 1;
+
+	m_Ranges.reset(new std::atomic<uint64_t>[threadCount]);
+	for (int i{ 0 }; i < threadCount; i++)
+		m_Ranges[i].store(0);
+
+	//The thread that calls ParallelFor also does work, so start one thread less
+	for (int i{ 1 }; i < threadCount; i++)
+		m_Workers.push_back(std::thread{ &ThreadPool::WorkerLoop, this, i });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+int ThreadPool::GetThreadCount() const
+{
+	return int(m_Workers.size()) + 1;
+}
+
+void ThreadPool::Run(int taskCount, TaskFunction pTaskFunction, void* pTask, bool stealing)
+{
+	if (taskCount <= 0)
+		return;
+
+	//Publish the job and wake up the workers
+	{
+		std::lock_guard<std::mutex> lock{ m_Mutex };
+		m_pTaskFunction = pTaskFunction;
+		m_pTask = pTask;
+		m_TaskCount = taskCount;
+		m_NextTask.store(0);
+		m_BusyWorkers = int(m_Workers.size());
+		++m_JobId;
+
+		//Hand every thread an equal block of indices to start with
+		m_Stealing = stealing;
+		if (stealing)
+		{
+			int threadCount = GetThreadCount();
+			for (int i{ 0 }; i < threadCount; i++)
+			{
+				uint64_t begin = uint64_t(taskCount) * i / threadCount;
+				uint64_t end = uint64_t(taskCount) * (i + 1) / threadCount;
+				m_Ranges[i].store(begin | (end << 32));
+			}
+		}
+	}
+	m_WorkAvailable.notify_all();
+
+	//Help out on this thread, then wait for the workers to finish their last task
+	RunTasks(0);
+
+	std::unique_lock<std::mutex> lock{ m_Mutex };
+	m_WorkDone.wait(lock, [this]() { return m_BusyWorkers == 0; });
+}
+
+void ThreadPool::RunTasks(int threadIndex)
+{
+	if (m_Stealing)
+	{
+		RunStealingTasks(threadIndex);
+		return;
+	}
+
+	//Every thread grabs the next free index until there are none left
+	int index = m_NextTask.fetch_add(1);
+	while (index < m_TaskCount)
+	{
+		m_pTaskFunction(m_pTask, index, threadIndex);
+		index = m_NextTask.fetch_add(1);
+	}
+}
+
+void ThreadPool::RunStealingTasks(int threadIndex)
+{
+	std::atomic<uint64_t>& range = m_Ranges[threadIndex];
+	do
+	{
+		//Take indices from the front of the own block, thieves take theirs from the back
+		uint64_t current = range.load();
+		while (uint32_t(current) < uint32_t(current >> 32))
+		{
+			if (!range.compare_exchange_weak(current, current + 1))
+				continue;
+
+			m_pTaskFunction(m_pTask, int(uint32_t(current)), threadIndex);
+			current = range.load();
+		}
+	} while (Steal(threadIndex));
+}
+
+bool ThreadPool::Steal(int threadIndex)
+{
+	int threadCount = GetThreadCount();
+	while (true)
+	{
+		//The victim is the thread with the most work left
+		int victim = -1;
+		uint64_t victimRange = 0;
+		uint32_t mostLeft = 0;
+		for (int i{ 0 }; i < threadCount; i++)
+		{
+			uint64_t current = m_Ranges[i].load();
+			uint32_t left = uint32_t(current >> 32) - std::min(uint32_t(current), uint32_t(current >> 32));
+			if (i != threadIndex && left > mostLeft)
+			{
+				victim = i;
+				victimRange = current;
+				mostLeft = left;
+			}
+		}
+
+		if (victim < 0)
+			return false;
+
+		//Move the back half of the victim's block to this thread, retry when the victim's block changed in between
+		uint64_t begin = uint32_t(victimRange);
+		uint64_t end = victimRange >> 32;
+		uint64_t middle = end - (mostLeft + 1) / 2;
+		if (m_Ranges[victim].compare_exchange_strong(victimRange, begin | (middle << 32)))
+		{
+			m_Ranges[threadIndex].store(middle | (end << 32));
+			return true;
+		}
+	}
+}
+
+void ThreadPool::WorkerLoop(int threadIndex)
+{
+	uint64_t lastJobId = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ m_Mutex };
+			m_WorkAvailable.wait(lock, [this, lastJobId]() { return m_Stopping || m_JobId != lastJobId; });
+			if (m_Stopping)
+				return;
+
+			lastJobId = m_JobId;
+		}
+
+		RunTasks(threadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock{ m_Mutex };
+			--m_BusyWorkers;
+		}
+		m_WorkDone.notify_one();
+	}
+}
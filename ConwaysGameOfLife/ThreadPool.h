@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Persistent pool of worker threads for data parallel loops.
+//The workers are created once and sleep between jobs, so handing out work every generation is cheap.
+class ThreadPool final
+{
+public:
+	//A thread count of 0 uses one thread per hardware thread, the calling thread counts as one of them
+	ThreadPool(int threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool(ThreadPool&& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+	ThreadPool& operator=(ThreadPool&& other) = delete;
+
+	int GetThreadCount() const;
+
+	//Calls task(index) for every index in [0, taskCount) spread over all threads and waits until all of them are done
+	template <typename Task>
+	void ParallelFor(int taskCount, Task& task);
+
+	//Calls task(index, threadIndex) for every index in [0, taskCount), with threadIndex in [0, GetThreadCount()).
+	//Every thread starts on its own block of indices and steals half of the largest block left when it runs out,
+	//meant for many independent tasks of very different length. A thread index is only used by one thread at a time.
+	template <typename Task>
+	void ParallelForStealing(int taskCount, Task& task);
+
+private:
+	using TaskFunction = void(*)(void* pTask, int index, int threadIndex);
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	//The job that is currently running
+	TaskFunction m_pTaskFunction;
+	void* m_pTask;
+	int m_TaskCount;
+	std::atomic<int> m_NextTask;
+	int m_BusyWorkers;
+	uint64_t m_JobId;
+	bool m_Stopping;
+
+	//Block of indices per thread for stealing jobs, the first index in the low and the end in the high 32 bits
+	bool m_Stealing;
+	std::unique_ptr<std::atomic<uint64_t>[]> m_Ranges;
+
+	void Run(int taskCount, TaskFunction pTaskFunction, void* pTask, bool stealing);
+	void RunTasks(int threadIndex);
+	void RunStealingTasks(int threadIndex);
+	bool Steal(int threadIndex);
+	void WorkerLoop(int threadIndex);
+
+	template <typename Task>
+	static void InvokeTask(void* pTask, int index, int threadIndex);
+	template <typename Task>
+	static void InvokeStealingTask(void* pTask, int index, int threadIndex);
+};
+
+template <typename Task>
+void ThreadPool::ParallelFor(int taskCount, Task& task)
+{
+	//The task is passed on as a plain pointer so no std::function (and no allocation) is needed per job
+	Run(taskCount, &InvokeTask<Task>, &task, false);
+}
+
+template <typename Task>
+void ThreadPool::ParallelForStealing(int taskCount, Task& task)
+{
+	Run(taskCount, &InvokeStealingTask<Task>, &task, true);
+}
+
+template <typename Task>
+void ThreadPool::InvokeTask(void* pTask, int index, int)
+{
+	(*static_cast<Task*>(pTask))(index);
+}
+
+template <typename Task>
+void ThreadPool::InvokeStealingTask(void* pTask, int index, int threadIndex)
+{
+	(*static_cast<Task*>(pTask))(index, threadIndex);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+
+//Hands values from one writer thread to one reader thread without locks and without either side ever waiting.
+//The writer fills its own buffer and publishes it, the reader picks up the newest published buffer.
+//The third buffer sits in between, so both sides always have a buffer the other one does not touch.
+//Values that are published faster than they are read are simply skipped.
+template <typename T>
+class TripleBuffer final
+{
+public:
+	TripleBuffer(const T& initial);
+	~TripleBuffer() = default;
+	TripleBuffer(const TripleBuffer& other) = delete;
+	TripleBuffer(TripleBuffer&& other) = delete;
+	TripleBuffer& operator=(const TripleBuffer& other) = delete;
+	TripleBuffer& operator=(TripleBuffer&& other) = delete;
+
+	//Writer side: fill the write buffer, then publish it. Publishing hands out a new write buffer.
+	T& GetWriteBuffer();
+	void Publish();
+
+	//Reader side: returns true when a newer value was published since the last call.
+	//The read buffer stays unchanged until the next call.
+	bool Update();
+	const T& GetReadBuffer() const;
+
+private:
+	static const int IndexMask = 3;
+	static const int FreshBit = 4;
+
+	T m_Buffers[3];
+	int m_WriteIndex;
+	int m_ReadIndex;
+	std::atomic<int> m_SharedIndex;	//Index of the buffer in between, with FreshBit set when the writer put it there
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer(const T& initial)
+	: m_Buffers{ initial, initial, initial }
+	, m_WriteIndex(0)
+	, m_ReadIndex(1)
+	, m_SharedIndex(2)
+{
+}
+
+template <typename T>
+T& TripleBuffer<T>::GetWriteBuffer()
+{
+	return m_Buffers[m_WriteIndex];
+}
+
+template <typename T>
+void TripleBuffer<T>::Publish()
+{
+	//Release makes the writes to the buffer visible to the reader that acquires it
+	m_WriteIndex = m_SharedIndex.exchange(m_WriteIndex | FreshBit, std::memory_order_acq_rel) & IndexMask;
+}
+
+template <typename T>
+bool TripleBuffer<T>::Update()
+{
+	if (!(m_SharedIndex.load(std::memory_order_relaxed) & FreshBit))
+		return false;
+
+	m_ReadIndex = m_SharedIndex.exchange(m_ReadIndex, std::memory_order_acq_rel) & IndexMask;
+	return true;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::GetReadBuffer() const
+{
+	return m_Buffers[m_ReadIndex];
+}
@@ -0,0 +1,102 @@
+#include "Check.h"
+#include "Cell.h"
+#include "EngineFactory.h"
+#include "LifeEngine.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+
+//Every heap allocation of the process goes through here, so allocations an engine forgets to report are caught as well
+static std::atomic<uint64_t> g_HeapAllocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++g_HeapAllocations;
+	if (void* pMemory = std::malloc(size == 0 ? 1 : size))
+		return pMemory;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, std::size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+static void FillSoup(Grid& grid, uint64_t seed)
+{
+	std::mt19937_64 random{ seed };
+	std::bernoulli_distribution alive{ 0.35 };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+//Once an engine stepped a grid a few times, further steps must neither allocate nor copy the grid
+static void CheckEngine(const std::string& name, Topology topology, ThreadPool* pThreadPool, bool countStatistics, bool recordChanges)
+{
+	const int warmUpSteps = 4;
+	const int checkedSteps = 16;
+
+	std::string description = name + " (" + std::to_string(int(topology)) + ", " + (pThreadPool ? "threads" : "serial")
+		+ (countStatistics ? ", statistics" : "") + (recordChanges ? ", changes)" : ")");
+
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(name) };
+	pEngine->SetThreadPool(pThreadPool);
+	pEngine->SetCountStatistics(countStatistics);
+	pEngine->SetRecordChanges(recordChanges);
+
+	Grid grid{ 200, 150, 1 };
+	grid.SetTopology(topology);
+	FillSoup(grid, 7);
+
+	for (int step{ 0 }; step < warmUpSteps; step++)
+		pEngine->Step(grid);
+
+	//Wrapping topologies copy the rows across the top and bottom edge into the halo, that is the only copy allowed
+	uint64_t haloBytes = topology == Topology::DeadBorder ? 0 : 2 * uint64_t(grid.GetStride()) * sizeof(uint64_t);
+	for (int step{ 0 }; step < checkedSteps; step++)
+	{
+		uint64_t heapAllocations = g_HeapAllocations.load();
+		pEngine->Step(grid);
+		uint64_t stepAllocations = g_HeapAllocations.load() - heapAllocations;
+
+		const GenerationCounters& counters = grid.GetGenerationCounters();
+		CHECK_CASE(counters.allocations == 0, description);
+		CHECK_CASE(counters.bytesAllocated == 0, description);
+		CHECK_CASE(counters.bytesCopied == haloBytes, description);
+		CHECK_CASE(stepAllocations == 0, description);
+	}
+}
+
+int main()
+{
+	ThreadPool threadPool{ 4 };
+	for (const std::string& name : EngineFactory::GetEngineNames())
+	{
+		for (Topology topology : { Topology::DeadBorder, Topology::Torus, Topology::KleinBottle })
+		{
+			for (bool countStatistics : { false, true })
+			{
+				for (bool recordChanges : { false, true })
+				{
+					CheckEngine(name, topology, nullptr, countStatistics, recordChanges);
+					CheckEngine(name, topology, &threadPool, countStatistics, recordChanges);
+				}
+			}
+		}
+	}
+
+	return ReportChecks();
+}
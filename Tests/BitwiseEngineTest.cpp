@@ -0,0 +1,89 @@
+#include "Check.h"
+#include "BitwiseEngine.h"
+#include "Cell.h"
+#include "CpuFeatures.h"
+#include "ScalarEngine.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+//Steps random grids with every instruction set of BitwiseEngine and with ScalarEngine, which checks every cell on its own,
+//and compares them cell for cell after every generation. The widths cross every word boundary up to 1000 cells,
+//which covers the partial last word, the halo column and the vector loops of AVX2 and AVX-512 with their scalar tails.
+static bool CheckInstructionSet(InstructionSet instructionSet, const char* name)
+{
+	BitwiseEngine bitwise{ instructionSet };
+	if (bitwise.GetInstructionSet() != instructionSet)
+	{
+		std::cout << name << ": not supported by this CPU, skipped" << std::endl;
+		return false;
+	}
+
+	//The rules with their own compiled kernel, every other rule goes through the runtime kernel
+	const std::vector<std::string> compiledRules = { "B3/S23", "B36/S23", "B3678/S34678", "B2/S", "B3/S012345678", "B3/S12345" };
+	const Topology topologies[] = { Topology::DeadBorder, Topology::Torus, Topology::KleinBottle };
+	const int maxWidth = 1000;
+	const int steps = 3;
+
+	std::mt19937_64 random{ 42 + uint64_t(instructionSet) };
+	ScalarEngine scalar{};
+	for (int width{ 1 }; width <= maxWidth; width++)
+	{
+		int height = 1 + int(random() % 9);
+		Topology topology = topologies[width % 3];
+
+		//B0 rules turn the dead border alive, so random rules are only drawn without birth on 0 neighbours
+		Rule rule{};
+		if (width % 4 != 0)
+		{
+			rule = Rule::Parse(compiledRules[random() % compiledRules.size()]);
+		}
+		else
+		{
+			rule.birthMask = uint16_t(random() & 0x1FE);
+			rule.survivalMask = uint16_t(random() & 0x1FF);
+		}
+		bitwise.SetRule(rule);
+		scalar.SetRule(rule);
+
+		std::bernoulli_distribution alive{ 0.1 + 0.1 * double(random() % 6) };
+		Grid expected{ width, height, 1 };
+		expected.SetTopology(topology);
+		for (int y{ 0 }; y < height; y++)
+		{
+			for (int x{ 0 }; x < width; x++)
+				expected.SetCell(x, y, alive(random));
+		}
+		Grid actual{ expected };
+
+		std::string description = std::string{ name } + " " + std::to_string(width) + "x" + std::to_string(height)
+			+ " topology " + std::to_string(int(topology)) + " rule " + rule.ToString();
+		for (int step{ 0 }; step < steps; step++)
+		{
+			scalar.Step(expected);
+			bitwise.Step(actual);
+
+			bool equal = true;
+			for (int y{ 0 }; y < height && equal; y++)
+			{
+				for (int w{ 0 }; w < expected.GetWordsPerRow(); w++)
+					equal = equal && expected.GetRow(y)[w] == actual.GetRow(y)[w];
+			}
+			CHECK_CASE(equal, description + " generation " + std::to_string(step + 1));
+			if (!equal)
+				break;
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	CheckInstructionSet(InstructionSet::Swar, "SWAR");
+	CheckInstructionSet(InstructionSet::Avx2, "AVX2");
+	CheckInstructionSet(InstructionSet::Avx512, "AVX-512");
+
+	return ReportChecks();
+}
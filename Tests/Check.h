@@ -0,0 +1,34 @@
+#pragma once
+#include <iostream>
+
+//Minimal checks for the test executables, which are plain programs run by CTest.
+//A failing check prints where it failed and carries on, the test returns ReportChecks() from main.
+static int g_FailedChecks = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			++g_FailedChecks; \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+		} \
+	} while (false)
+
+//Like CHECK with a description of the case, for checks inside loops over many cases
+#define CHECK_CASE(condition, description) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			++g_FailedChecks; \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition " for " << description << std::endl; \
+		} \
+	} while (false)
+
+static int ReportChecks()
+{
+	if (g_FailedChecks != 0)
+		std::cerr << g_FailedChecks << " checks failed" << std::endl;
+	return g_FailedChecks == 0 ? 0 : 1;
+}
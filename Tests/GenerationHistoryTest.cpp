@@ -0,0 +1,193 @@
+#include "Check.h"
+#include "Cell.h"
+#include "EngineFactory.h"
+#include "GenerationHistory.h"
+#include "LifeEngine.h"
+#include "SimulationThread.h"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void FillSoup(Grid& grid, uint64_t seed)
+{
+	std::mt19937_64 random{ seed };
+	std::bernoulli_distribution alive{ 0.35 };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+static void AddBlinker(Grid& grid, int x, int y)
+{
+	for (int dx{ -1 }; dx <= 1; dx++)
+		grid.SetCell(x + dx, y, true);
+}
+
+//Steps the grid the way the application does, recording before and after every step
+static std::vector<uint64_t> RecordSteps(LifeEngine& engine, GenerationHistory& history, Grid& grid, int steps)
+{
+	std::vector<uint64_t> hashes{ grid.ComputeHash() };
+	for (int step{ 0 }; step < steps; step++)
+	{
+		history.Record(grid);
+		engine.Step(grid);
+		history.Record(grid);
+		hashes.push_back(grid.ComputeHash());
+	}
+	return hashes;
+}
+
+//Rewinding to one generation after another walks the deltas from the cursor, jumping far goes through a keyframe
+static void CheckRewind()
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	Grid grid{ 150, 100, 1 };
+	grid.SetTopology(Topology::Torus);
+	FillSoup(grid, 3);
+
+	GenerationHistory history{ size_t(64) << 20, 8 };
+	std::vector<uint64_t> hashes = RecordSteps(*pEngine, history, grid, 60);
+	CHECK(history.GetOldestGeneration() == 0);
+	CHECK(history.GetNewestGeneration() == 60);
+
+	for (uint64_t generation{ 60 }; generation-- > 0;)
+	{
+		history.Rewind(grid, generation);
+		CHECK_CASE(grid.GetGeneration() == generation, "delta rewind to " + std::to_string(generation));
+		CHECK_CASE(grid.ComputeHash() == hashes[generation], "delta rewind to " + std::to_string(generation));
+	}
+
+	for (uint64_t generation : { 60, 1, 59, 17, 40, 0, 33 })
+	{
+		history.Rewind(grid, generation);
+		CHECK_CASE(grid.ComputeHash() == hashes[generation], "keyframe rewind to " + std::to_string(generation));
+	}
+}
+
+//An edit after a rewind makes the recorded generations after it stale, stepping forward has to compute the edited grid
+static void CheckEditAfterRewind()
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	Grid grid{ 64, 64, 1 };
+	AddBlinker(grid, 10, 10);
+
+	GenerationHistory history;
+	RecordSteps(*pEngine, history, grid, 5);
+	history.Rewind(grid, 2);
+	AddBlinker(grid, 40, 40);
+	CHECK(history.Contains(3));
+
+	Grid expected{ grid };
+	pEngine->Step(expected);
+
+	//What StepForward does: record the edit first, which drops the generations after it
+	history.Record(grid);
+	CHECK(!history.Contains(3));
+	CHECK(history.GetNewestGeneration() == 2);
+	history.Record(grid);
+	pEngine->Step(grid);
+	history.Record(grid);
+	CHECK(grid.GetGeneration() == 3);
+	CHECK(grid.ComputeHash() == expected.ComputeHash());
+
+	//Both the edited and the computed generation are in the history now
+	history.Rewind(grid, 2);
+	history.Rewind(grid, 3);
+	CHECK(grid.ComputeHash() == expected.ComputeHash());
+
+	//Without an edit the recorded future stays and is replayed
+	history.Rewind(grid, 2);
+	history.Record(grid);
+	CHECK(history.Contains(3));
+}
+
+//Over budget the oldest generations go, what is left still rewinds to the right cells
+static void CheckMemoryBudget()
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	Grid grid{ 200, 200, 1 };
+	FillSoup(grid, 5);
+
+	const size_t budget = 64 << 10;
+	GenerationHistory history{ budget, 4 };
+	std::vector<uint64_t> hashes = RecordSteps(*pEngine, history, grid, 200);
+	CHECK(history.GetMemoryUsage() <= budget);
+	CHECK(history.GetOldestGeneration() > 0);
+	CHECK(history.GetNewestGeneration() == 200);
+	CHECK(history.GetGenerationCount() == size_t(200 - history.GetOldestGeneration() + 1));
+
+	bool threw = false;
+	try
+	{
+		history.Rewind(grid, history.GetOldestGeneration() - 1);
+	}
+	catch (const std::runtime_error&)
+	{
+		threw = true;
+	}
+	CHECK(threw);
+
+	for (uint64_t generation{ 200 }; generation-- > history.GetOldestGeneration();)
+	{
+		history.Rewind(grid, generation);
+		CHECK_CASE(grid.ComputeHash() == hashes[generation], "rewind to " + std::to_string(generation) + " after dropping frames");
+	}
+	history.Rewind(grid, history.GetOldestGeneration());
+	CHECK(grid.ComputeHash() == hashes[history.GetOldestGeneration()]);
+}
+
+//The same rewind, edit and step through the commands of the simulation thread
+static void CheckSimulationThread()
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	Grid grid{ 64, 64, 1 };
+	AddBlinker(grid, 10, 10);
+
+	Grid expected{ grid };
+	pEngine->Step(expected);
+	pEngine->Step(expected);
+	AddBlinker(expected, 40, 40);
+	pEngine->Step(expected);
+
+	SimulationThread simulation{ grid, pEngine.get() };
+	SimulationCommand command{};
+	command.type = CommandType::Step;
+	for (int step{ 0 }; step < 5; step++)
+		simulation.PostCommand(command);
+	command.type = CommandType::Rewind;
+	command.generation = 2;
+	simulation.PostCommand(command);
+	command.type = CommandType::SetCell;
+	command.alive = true;
+	command.y = 40;
+	for (command.x = 39; command.x <= 41; command.x++)
+		simulation.PostCommand(command);
+	command.type = CommandType::Step;
+	simulation.PostCommand(command);
+
+	//All commands were queued before the thread started, so its first frame has all of them applied
+	simulation.Start();
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{ 10 };
+	while (simulation.AcquireFrame().GetGeneration() == 0 && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+	const Grid& frame = simulation.AcquireFrame();
+	CHECK(frame.GetGeneration() == 3);
+	CHECK(frame.ComputeHash() == expected.ComputeHash());
+	simulation.Stop();
+}
+
+int main()
+{
+	CheckRewind();
+	CheckEditAfterRewind();
+	CheckMemoryBudget();
+	CheckSimulationThread();
+	return ReportChecks();
+}
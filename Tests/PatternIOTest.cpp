@@ -0,0 +1,202 @@
+#include "Check.h"
+#include "Cell.h"
+#include "HashLife.h"
+#include "PatternIO.h"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+static void FillRandom(Grid& grid, std::mt19937_64& random)
+{
+	std::bernoulli_distribution alive{ 0.05 + 0.15 * double(random() % 6) };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+static Grid ReadRleIntoGrid(const std::string& rle, int width, int height, int64_t offsetX = 0, int64_t offsetY = 0)
+{
+	Grid grid{ width, height, 1 };
+	std::istringstream stream{ rle };
+	GridPatternSink sink{ grid, offsetX, offsetY };
+	PatternReader::ReadRle(stream, sink);
+	return grid;
+}
+
+template <typename Function>
+static bool Throws(Function function)
+{
+	try
+	{
+		function();
+	}
+	catch (const std::runtime_error&)
+	{
+		return true;
+	}
+	return false;
+}
+
+//Writing a grid as RLE and reading it back gives the same cells at the same place, the rule comes along
+static void CheckGridRle(std::mt19937_64& random)
+{
+	for (int width : { 1, 7, 63, 64, 65, 200 })
+	{
+		Grid grid{ width, 1 + int(random() % 90), 1 };
+		FillRandom(grid, random);
+
+		std::ostringstream written;
+		PatternWriter::WriteRle(grid, "B36/S23", written);
+
+		Grid read{ grid.GetWidth(), grid.GetHeight(), 1 };
+		std::istringstream stream{ written.str() };
+		GridPatternSink sink{ read };
+		std::string rule = PatternReader::ReadRle(stream, sink);
+
+		std::string description = "width " + std::to_string(width) + " height " + std::to_string(grid.GetHeight());
+		CHECK_CASE(rule == "B36/S23", description);
+		CHECK_CASE(read.ComputeHash() == grid.ComputeHash(), description);
+	}
+
+	//An empty grid still has a header with the rule
+	Grid empty{ 10, 10, 1 };
+	std::ostringstream written;
+	PatternWriter::WriteRle(empty, "B3/S23", written);
+	std::istringstream stream{ written.str() };
+	GridPatternSink sink{ empty };
+	CHECK(PatternReader::ReadRle(stream, sink) == "B3/S23");
+	CHECK(empty.GetPopulation() == 0);
+}
+
+//HashLife writes its bounding box as #CXRLE Pos, so cells far from the origin and at negative positions stay where they were
+static void CheckHashLifeRle(std::mt19937_64& random)
+{
+	HashLife hashLife{};
+	hashLife.SetRule(Rule::Parse("B36/S23"));
+	for (int i{ 0 }; i < 500; i++)
+		hashLife.SetCell(int64_t(random() % 300) - 1000, int64_t(random() % 200) - 70, true);
+	hashLife.SetCell(5000, 3000, true);
+
+	std::ostringstream written;
+	PatternWriter::WriteRle(hashLife, written);
+
+	HashLife read{};
+	std::istringstream stream{ written.str() };
+	HashLifePatternSink sink{ read };
+	std::string rule = PatternReader::ReadRle(stream, sink);
+	sink.Finish();
+	CHECK(rule == "B36/S23");
+	CHECK(read.GetPopulation() == hashLife.GetPopulation());
+
+	int64_t left, top, right, bottom;
+	int64_t readLeft, readTop, readRight, readBottom;
+	CHECK(hashLife.GetBoundingBox(left, top, right, bottom));
+	CHECK(read.GetBoundingBox(readLeft, readTop, readRight, readBottom));
+	CHECK(left == readLeft && top == readTop && right == readRight && bottom == readBottom);
+
+	//The region around the random cells, the lone cell far away is covered by the population and bounding box
+	Grid expected{ 320, 220, 1 };
+	Grid actual{ 320, 220, 1 };
+	hashLife.WriteToGrid(expected, -1010, -80);
+	read.WriteToGrid(actual, -1010, -80);
+	CHECK(actual.ComputeHash() == expected.ComputeHash());
+}
+
+//Pos moves the pattern, the sink offset moves it once more and cells that end up outside of the grid are dropped
+static void CheckPositionOffsets()
+{
+	Grid moved = ReadRleIntoGrid("#CXRLE Pos=5,7\nx = 3, y = 2, rule = B3/S23\n3o$bo!", 20, 20);
+	CHECK(moved.GetPopulation() == 4);
+	CHECK(moved.IsAlive(5, 7) && moved.IsAlive(6, 7) && moved.IsAlive(7, 7) && moved.IsAlive(6, 8));
+
+	Grid both = ReadRleIntoGrid("#CXRLE Pos=-3,-2 Gen=10\nx = 3, y = 2\n3o$bo!", 20, 20, 10, 10);
+	CHECK(both.GetPopulation() == 4);
+	CHECK(both.IsAlive(7, 8) && both.IsAlive(8, 8) && both.IsAlive(9, 8) && both.IsAlive(8, 9));
+
+	//The first row lands above the grid, of the second only the cell in column 0 is left
+	Grid clipped = ReadRleIntoGrid("#CXRLE Pos=-1,-1\nx = 3, y = 2\n3o$bo!", 20, 20);
+	CHECK(clipped.GetPopulation() == 1);
+	CHECK(clipped.IsAlive(0, 0));
+
+	//Other comments do not move anything
+	Grid plain = ReadRleIntoGrid("#N Glider\n#C Pos=5,5 in a comment\nx = 3, y = 3\nbo$2bo$3o!", 10, 10);
+	const int glider[5][2] = { { 1, 0 }, { 2, 1 }, { 0, 2 }, { 1, 2 }, { 2, 2 } };
+	Grid reference{ 10, 10, 1 };
+	for (const int* pCell : glider)
+		reference.SetCell(pCell[0], pCell[1], true);
+	CHECK(plain.ComputeHash() == reference.ComputeHash());
+}
+
+static void CheckPlaintext()
+{
+	Grid glider = ReadRleIntoGrid("bo$2bo$3o!", 10, 10);
+
+	for (const char* cells : { "!Name: Glider\n!\n.O.\n..O\nOOO\n", "!Name: Glider\r\n.O.\r\n..O\r\nOOO", ".*\n..*\n***\n" })
+	{
+		Grid grid{ 10, 10, 1 };
+		std::istringstream stream{ cells };
+		GridPatternSink sink{ grid };
+		CHECK_CASE(PatternReader::ReadPlaintext(stream, sink).empty(), cells);
+		CHECK_CASE(grid.ComputeHash() == glider.ComputeHash(), cells);
+	}
+}
+
+//A grid goes into HashLife, out as macrocell and back into a grid through the reader
+static void CheckMacrocell(std::mt19937_64& random)
+{
+	for (int size : { 5, 64, 130 })
+	{
+		Grid grid{ size, size, 1 };
+		FillRandom(grid, random);
+
+		HashLife hashLife{};
+		hashLife.SetRule(Rule::Parse("B3678/S34678"));
+		hashLife.LoadGrid(grid);
+
+		std::ostringstream written;
+		PatternWriter::WriteMacrocell(hashLife, written);
+
+		Grid read{ size, size, 1 };
+		std::istringstream stream{ written.str() };
+		GridPatternSink sink{ read };
+		std::string rule = PatternReader::ReadMacrocell(stream, sink);
+
+		std::string description = "size " + std::to_string(size);
+		CHECK_CASE(rule == "B3678/S34678", description);
+		CHECK_CASE(read.ComputeHash() == grid.ComputeHash(), description);
+
+		//And straight into another universe, which writes the same file again
+		HashLife copy{};
+		std::istringstream again{ written.str() };
+		copy.ReadMacrocell(again);
+		std::ostringstream rewritten;
+		PatternWriter::WriteMacrocell(copy, rewritten);
+		CHECK_CASE(rewritten.str() == written.str(), description);
+	}
+}
+
+static void CheckMalformed()
+{
+	CHECK(Throws([]() { ReadRleIntoGrid("x = 3, y = 1\n3q!", 10, 10); }));
+	CHECK(Throws([]() { ReadRleIntoGrid("x = 3, y = 1\n9999999999999999o!", 10, 10); }));
+
+	HashLife hashLife{};
+	std::istringstream macrocell{ "[M2] (test)\n4 0 1 0 0\n" };
+	CHECK(Throws([&hashLife, &macrocell]() { hashLife.ReadMacrocell(macrocell); }));
+}
+
+int main()
+{
+	std::mt19937_64 random{ 12 };
+	CheckGridRle(random);
+	CheckHashLifeRle(random);
+	CheckPositionOffsets();
+	CheckPlaintext();
+	CheckMacrocell(random);
+	CheckMalformed();
+	return ReportChecks();
+}
@@ -0,0 +1,271 @@
+#include "Check.h"
+#include "Cell.h"
+#include "DensityPyramid.h"
+#include "EngineFactory.h"
+#include "LifeEngine.h"
+#include "PixelExpansion.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+static const uint32_t Alive = 0xFFFFFFFF;
+static const uint32_t Dead = 0xFF202020;
+static const uint32_t Line = 0xFF808080;
+static const uint32_t Outside = 0xFF000040;
+//Written around every output, any pixel that still differs from it afterwards was written out of bounds
+static const uint32_t Canary = 0xDEADBEEF;
+
+static void FillRandom(Grid& grid, std::mt19937_64& random)
+{
+	std::bernoulli_distribution alive{ 0.05 + 0.15 * double(random() % 6) };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+//Cell size 1 goes through the SSE2 path with a scalar tail, larger cells through the run fill
+static void CheckExpandRow(std::mt19937_64& random)
+{
+	for (int cellSize{ 1 }; cellSize <= 5; cellSize++)
+	{
+		for (int width{ 1 }; width <= 300; width++)
+		{
+			Grid grid{ width, 1, cellSize };
+			FillRandom(grid, random);
+
+			const int slack = 16;
+			int pixelWidth = width * cellSize;
+			std::vector<uint32_t> pixels(pixelWidth + slack, Canary);
+			PixelExpansion::ExpandRow(grid.GetRow(0), width, cellSize, Alive, Dead, pixels.data());
+
+			std::string description = "width " + std::to_string(width) + " cell size " + std::to_string(cellSize);
+			bool equal = true;
+			for (int px{ 0 }; px < pixelWidth; px++)
+				equal = equal && pixels[px] == (grid.IsAlive(px / cellSize, 0) ? Alive : Dead);
+			CHECK_CASE(equal, description);
+			CHECK_CASE(std::all_of(pixels.begin() + pixelWidth, pixels.end(), [](uint32_t pixel) { return pixel == Canary; }), description);
+		}
+	}
+}
+
+//Rows of the texture can be wider than the grid, the pixels past width * cellSize belong to nobody
+static void CheckExpandRows(std::mt19937_64& random)
+{
+	for (int cellSize{ 1 }; cellSize <= 4; cellSize++)
+	{
+		for (int width : { 1, 3, 63, 64, 65, 130, 257 })
+		{
+			int height = 1 + int(random() % 12);
+			Grid grid{ width, height, cellSize };
+			FillRandom(grid, random);
+
+			int firstRow = int(random() % height);
+			int lastRow = firstRow + 1 + int(random() % (height - firstRow));
+			int pixelWidth = width * cellSize;
+			int pitchPixels = pixelWidth + 5;
+			int pixelRows = (lastRow - firstRow) * cellSize;
+			std::vector<uint32_t> pixels(size_t(pitchPixels) * pixelRows, Canary);
+			PixelExpansion::ExpandRows(grid, firstRow, lastRow, Alive, Dead, pixels.data(), pitchPixels * int(sizeof(uint32_t)));
+
+			std::string description = "width " + std::to_string(width) + " rows " + std::to_string(firstRow) + " to " + std::to_string(lastRow)
+				+ " cell size " + std::to_string(cellSize);
+			bool equal = true;
+			bool canaries = true;
+			for (int py{ 0 }; py < pixelRows; py++)
+			{
+				const uint32_t* pRow = pixels.data() + size_t(py) * pitchPixels;
+				for (int px{ 0 }; px < pixelWidth; px++)
+					equal = equal && pRow[px] == (grid.IsAlive(px / cellSize, firstRow + py / cellSize) ? Alive : Dead);
+				canaries = canaries && std::all_of(pRow + pixelWidth, pRow + pitchPixels, [](uint32_t pixel) { return pixel == Canary; });
+			}
+			CHECK_CASE(equal, description);
+			CHECK_CASE(canaries, description);
+		}
+	}
+}
+
+static void CheckGridLines()
+{
+	for (int cellSize{ 1 }; cellSize <= 6; cellSize++)
+	{
+		for (int width : { 1, 2, 7, 33 })
+		{
+			const int height = 5;
+			int pixelWidth = width * cellSize;
+			int pitchPixels = pixelWidth + 3;
+			int pixelRows = height * cellSize;
+			std::vector<uint32_t> pixels(size_t(pitchPixels) * pixelRows, Canary);
+			PixelExpansion::DrawGridLines(width, height, cellSize, Line, pixels.data(), pitchPixels * int(sizeof(uint32_t)));
+
+			std::string description = "width " + std::to_string(width) + " cell size " + std::to_string(cellSize);
+			bool equal = true;
+			bool canaries = true;
+			for (int py{ 0 }; py < pixelRows; py++)
+			{
+				const uint32_t* pRow = pixels.data() + size_t(py) * pitchPixels;
+				for (int px{ 0 }; px < pixelWidth; px++)
+				{
+					//The outline is the first and last pixel row and column of every cell
+					int inX = px % cellSize;
+					int inY = py % cellSize;
+					bool onLine = inX == 0 || inX == cellSize - 1 || inY == 0 || inY == cellSize - 1;
+					equal = equal && pRow[px] == (onLine ? Line : 0u);
+				}
+				canaries = canaries && std::all_of(pRow + pixelWidth, pRow + pitchPixels, [](uint32_t pixel) { return pixel == Canary; });
+			}
+			CHECK_CASE(equal, description);
+			CHECK_CASE(canaries, description);
+		}
+	}
+}
+
+//The shading ExpandView promises: dead for an empty block, otherwise at least a quarter of the way to alive
+static uint32_t ExpectedShade(uint64_t population, int level)
+{
+	uint64_t amount = ((population << 8) + (uint64_t(1) << (2 * level)) - 1) >> (2 * level);
+	amount = std::min<uint64_t>(amount, 256);
+	if (amount != 0)
+		amount = std::max<uint64_t>(amount, 64);
+
+	uint32_t result{ 0 };
+	for (int shift{ 0 }; shift < 32; shift += 8)
+	{
+		uint64_t a = (Dead >> shift) & 0xFF;
+		uint64_t b = (Alive >> shift) & 0xFF;
+		result |= uint32_t(((a * (256 - amount) + b * amount) >> 8) << shift);
+	}
+	return result;
+}
+
+static void CheckExpandView(std::mt19937_64& random)
+{
+	Grid grid{ 150, 90, 1 };
+	FillRandom(grid, random);
+	DensityPyramid pyramid{};
+	pyramid.Update(grid);
+
+	for (int level{ 0 }; level <= pyramid.GetLevelCount(); level++)
+	{
+		for (int cellPixels : { 1, 3, 8 })
+		{
+			//Starting left of and above the grid shows the outside color as well
+			int originX = int(random() % 200) - 40;
+			int originY = int(random() % 120) - 20;
+			const int width = 101;
+			const int height = 37;
+			int pitchPixels = width + 7;
+			std::vector<uint32_t> pixels(size_t(pitchPixels) * height, Canary);
+			PixelExpansion::ExpandView(pyramid, level, originX, originY, cellPixels, Alive, Dead, Outside, pixels.data(),
+				pitchPixels * int(sizeof(uint32_t)), width, height);
+
+			std::string description = "level " + std::to_string(level) + " cell pixels " + std::to_string(cellPixels);
+			int blockSize = 1 << level;
+			int levelWidth = (grid.GetWidth() + blockSize - 1) / blockSize;
+			int levelHeight = (grid.GetHeight() + blockSize - 1) / blockSize;
+			bool equal = true;
+			bool canaries = true;
+			for (int py{ 0 }; py < height; py++)
+			{
+				const uint32_t* pRow = pixels.data() + size_t(py) * pitchPixels;
+				for (int px{ 0 }; px < width; px++)
+				{
+					int blockX = (originX >> level) + px / cellPixels;
+					int blockY = (originY >> level) + py / cellPixels;
+					uint32_t expected = Outside;
+					if (blockX >= 0 && blockY >= 0 && blockX < levelWidth && blockY < levelHeight)
+					{
+						uint64_t population{ 0 };
+						for (int y{ blockY * blockSize }; y < std::min(grid.GetHeight(), (blockY + 1) * blockSize); y++)
+						{
+							for (int x{ blockX * blockSize }; x < std::min(grid.GetWidth(), (blockX + 1) * blockSize); x++)
+								population += grid.IsAlive(x, y) ? 1 : 0;
+						}
+						expected = ExpectedShade(population, level);
+					}
+					equal = equal && pRow[px] == expected;
+				}
+				canaries = canaries && std::all_of(pRow + width, pRow + pitchPixels, [](uint32_t pixel) { return pixel == Canary; });
+			}
+			CHECK_CASE(equal, description);
+			CHECK_CASE(canaries, description);
+		}
+	}
+}
+
+//The pyramid and the dirty rows only look at the chunks the grid says changed, they have to end up where a fresh start would
+static void CheckChangeTracking(std::mt19937_64& random)
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	Grid grid{ 9000, 41, 1 };
+	grid.SetTopology(Topology::Torus);
+	FillRandom(grid, random);
+	Grid frames[2]{ grid, grid };
+
+	DensityPyramid pyramid{};
+	DirtyRows dirtyRows{};
+	std::vector<std::pair<int, int>> ranges{};
+	std::vector<uint64_t> drawn(size_t(grid.GetWordsPerRow()) * grid.GetHeight(), 0);
+
+	for (int update{ 0 }; update < 40; update++)
+	{
+		//Steps with and without recording, single cell edits and frames copied like a simulation thread hands them out
+		int steps = int(random() % 3);
+		for (int step{ 0 }; step < steps; step++)
+		{
+			pEngine->SetRecordChanges(random() % 8 != 0);
+			pEngine->Step(grid);
+		}
+		if (random() % 4 == 0)
+			grid.ToggleCell(int(random() % 9000), int(random() % 41));
+
+		const Grid* pShown = &grid;
+		if (update % 10 >= 5)
+		{
+			frames[update % 2].CopyFrom(grid);
+			pShown = &frames[update % 2];
+		}
+
+		std::string description = "update " + std::to_string(update);
+		pyramid.Update(*pShown);
+		DensityPyramid fresh{};
+		fresh.Update(*pShown);
+		bool equal = pyramid.GetLevelCount() == fresh.GetLevelCount();
+		for (int level{ 1 }; level <= fresh.GetLevelCount() && equal; level++)
+		{
+			for (int y{ 0 }; y < fresh.GetLevelHeight(level); y++)
+			{
+				for (int x{ 0 }; x < fresh.GetLevelWidth(level); x++)
+					equal = equal && pyramid.GetPopulation(level, x, y) == fresh.GetPopulation(level, x, y);
+			}
+		}
+		CHECK_CASE(equal, description);
+
+		dirtyRows.Update(*pShown, ranges);
+		for (const std::pair<int, int>& range : ranges)
+		{
+			for (int y{ range.first }; y < range.second; y++)
+				std::copy(pShown->GetRow(y), pShown->GetRow(y) + grid.GetWordsPerRow(), drawn.begin() + size_t(y) * grid.GetWordsPerRow());
+		}
+		bool upToDate = true;
+		for (int y{ 0 }; y < grid.GetHeight(); y++)
+			upToDate = upToDate && std::equal(pShown->GetRow(y), pShown->GetRow(y) + grid.GetWordsPerRow(), drawn.begin() + size_t(y) * grid.GetWordsPerRow());
+		CHECK_CASE(upToDate, description);
+	}
+}
+
+int main()
+{
+	std::mt19937_64 random{ 17 };
+	CheckExpandRow(random);
+	CheckExpandRows(random);
+	CheckGridLines();
+	CheckExpandView(random);
+	CheckChangeTracking(random);
+
+	return ReportChecks();
+}
@@ -0,0 +1,56 @@
+#include "Check.h"
+#include "Cell.h"
+#include "EngineFactory.h"
+#include "LifeEngine.h"
+#include "ShardedSimulation.h"
+
+#include <memory>
+#include <random>
+#include <string>
+
+static void FillSoup(Grid& grid, uint64_t seed)
+{
+	std::mt19937_64 random{ seed };
+	std::bernoulli_distribution alive{ 0.35 };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+//The workers exchange their edge rows after every generation, the result has to be bit-identical to one process.
+//Larger than Life reaches 5 rows across the shard edges, the width leaves part of the last word as padding.
+static void CheckEngine(const std::string& engine, const std::string& rule)
+{
+	const uint64_t generations = 40;
+	for (Topology topology : { Topology::DeadBorder, Topology::Torus, Topology::KleinBottle })
+	{
+		for (int shardCount : { 2, 3 })
+		{
+			std::string description = engine + " (" + std::to_string(int(topology)) + ", " + std::to_string(shardCount) + " shards)";
+			Grid expected{ 200, 120, 1 };
+			expected.SetTopology(topology);
+			FillSoup(expected, 11);
+			Grid grid{ expected };
+
+			std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create(engine, rule) };
+			for (uint64_t generation{ 0 }; generation < generations; generation++)
+				pEngine->Step(expected);
+
+			ShardedSimulation sharded{ engine, rule, shardCount };
+			sharded.Run(grid, generations);
+			CHECK_CASE(grid.GetGeneration() == generations, description);
+			CHECK_CASE(grid.ComputeHash() == expected.ComputeHash(), description);
+			CHECK_CASE(sharded.GetExchangedBytes() != 0, description);
+		}
+	}
+}
+
+int main()
+{
+	CheckEngine("bitwise", "B3/S23");
+	CheckEngine("neighbour-count", "B36/S23");
+	CheckEngine("larger-than-life", "R5,C0,M1,S34..58,B34..45,NM");
+	return ReportChecks();
+}
@@ -0,0 +1,133 @@
+#include "Check.h"
+#include "Cell.h"
+#include "EngineFactory.h"
+#include "HeadlessRunner.h"
+#include "LifeEngine.h"
+#include "Snapshot.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+static void FillSoup(Grid& grid, uint64_t seed)
+{
+	std::mt19937_64 random{ seed };
+	std::bernoulli_distribution alive{ 0.35 };
+	for (int y{ 0 }; y < grid.GetHeight(); y++)
+	{
+		for (int x{ 0 }; x < grid.GetWidth(); x++)
+			grid.SetCell(x, y, alive(random));
+	}
+}
+
+template <typename Function>
+static bool Throws(Function function)
+{
+	try
+	{
+		function();
+	}
+	catch (const std::runtime_error&)
+	{
+		return true;
+	}
+	return false;
+}
+
+//Save, open, verify and step the mapped grid, for widths with and without a partial last word
+static void CheckRoundTrip(const std::string& path)
+{
+	std::unique_ptr<LifeEngine> pEngine{ EngineFactory::Create("bitwise") };
+	for (int width : { 1, 64, 200 })
+	{
+		for (Topology topology : { Topology::DeadBorder, Topology::Torus, Topology::KleinBottle })
+		{
+			std::string description = "width " + std::to_string(width) + " topology " + std::to_string(int(topology));
+			Grid grid{ width, 70, 2 };
+			grid.SetTopology(topology);
+			FillSoup(grid, uint64_t(width));
+			for (int step{ 0 }; step < 3; step++)
+				pEngine->Step(grid);
+			Snapshot::Save(path, grid, "B3/S23");
+
+			Snapshot snapshot{ path };
+			const SnapshotHeader& header = snapshot.GetHeader();
+			CHECK_CASE(header.width == width && header.height == 70 && header.cellSize == 2, description);
+			CHECK_CASE(header.generation == 3, description);
+			CHECK_CASE(snapshot.GetRule() == "B3/S23", description);
+			CHECK_CASE(snapshot.VerifyChecksum(), description);
+
+			Grid mapped = snapshot.CreateGrid();
+			CHECK_CASE(mapped.GetTopology() == topology, description);
+			CHECK_CASE(mapped.GetGeneration() == 3, description);
+			CHECK_CASE(mapped.ComputeHash() == grid.ComputeHash(), description);
+
+			//Stepping the mapped grid gives the same generations and leaves the file as it was
+			for (int step{ 0 }; step < 5; step++)
+			{
+				pEngine->Step(grid);
+				pEngine->Step(mapped);
+			}
+			CHECK_CASE(mapped.ComputeHash() == grid.ComputeHash(), description);
+			CHECK_CASE(Snapshot{ path }.VerifyChecksum(), description);
+		}
+	}
+}
+
+static void CheckDamagedFiles(const std::string& path)
+{
+	Grid grid{ 100, 100, 1 };
+	FillSoup(grid, 9);
+	Snapshot::Save(path, grid, "B3/S23");
+
+	//A flipped bit in the rows is only found by the checksum
+	{
+		std::streamoff offset = Snapshot::DataOffset + 8 * (grid.GetStride() * 10 + 1);
+		std::fstream file{ path, std::ios::in | std::ios::out | std::ios::binary };
+		file.seekg(offset);
+		char byte = char(file.get());
+		file.seekp(offset);
+		file.put(char(byte ^ 1));
+	}
+	CHECK(!Snapshot{ path }.VerifyChecksum());
+
+	//A damaged header or a cut off file is rejected when opening
+	{
+		std::fstream file{ path, std::ios::in | std::ios::out | std::ios::binary };
+		file.put('X');
+	}
+	CHECK(Throws([&path]() { Snapshot snapshot{ path }; }));
+
+	Snapshot::Save(path, grid, "B3/S23");
+	{
+		std::ifstream file{ path, std::ios::binary };
+		std::string contents{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+		std::ofstream truncated{ path, std::ios::binary | std::ios::trunc };
+		truncated.write(contents.data(), std::streamsize(contents.size() - 8));
+	}
+	CHECK(Throws([&path]() { Snapshot snapshot{ path }; }));
+}
+
+//The snapshot a grid is mapped from can not be replaced on every platform, the runner does not try
+static void CheckSaveOverSource()
+{
+	const char* sameFile[] = { "LifeHeadless", "--snapshot", "a.snap", "--save-snapshot", "a.snap" };
+	CHECK(Throws([&sameFile]() { HeadlessRunner::ParseArguments(5, const_cast<char**>(sameFile)); }));
+
+	const char* otherFile[] = { "LifeHeadless", "--snapshot", "a.snap", "--save-snapshot", "b.snap" };
+	CHECK(!Throws([&otherFile]() { HeadlessRunner::ParseArguments(5, const_cast<char**>(otherFile)); }));
+}
+
+int main()
+{
+	const std::string path = "SnapshotTest.snap";
+	CheckRoundTrip(path);
+	CheckDamagedFiles(path);
+	CheckSaveOverSource();
+	std::remove(path.c_str());
+	return ReportChecks();
+}